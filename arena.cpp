@@ -0,0 +1,55 @@
+/*
+    arena.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+#include "arena.hpp"
+
+// Ctor & dtor
+mgrid::Arena::Arena(const std::size_t numberOfDoubles, const bool hugePages):
+    memory(0), length(numberOfDoubles), mappedBytes(0)
+{
+    // Round the allocation up to a whole number of pages when using huge
+    // pages, so that the last page can be a huge page too
+    const std::size_t alignment = hugePages ? hugePageSize : arenaAlignment;
+    std::size_t bytes = length*sizeof(double);
+    bytes = ((bytes + alignment - 1)/alignment)*alignment;
+    void* block = 0;
+    if (bytes == 0 || posix_memalign(&block, alignment, bytes) != 0)
+        throw std::bad_alloc();
+    memory = static_cast<double*>(block);
+
+#ifdef MADV_HUGEPAGE
+    // This is only advice, so carry on with normal pages if it fails
+    if (hugePages) madvise(block, bytes, MADV_HUGEPAGE);
+#endif
+}
+mgrid::Arena::Arena(const int file, const std::size_t offset,
+    const std::size_t numberOfDoubles):
+    memory(0), length(numberOfDoubles), 
+    mappedBytes(numberOfDoubles*sizeof(double))
+{
+    // Copy-on-write mapping of the file
+    void* block = 0;
+    if (mappedBytes > 0) block = mmap(0, mappedBytes, PROT_READ | PROT_WRITE, 
+        MAP_PRIVATE, file, offset);
+    if (mappedBytes == 0 || block == MAP_FAILED) throw std::bad_alloc();
+    memory = static_cast<double*>(block);
+}
+mgrid::Arena::~Arena() {
+    if (mappedBytes > 0) {
+        munmap(memory, mappedBytes);
+    } else {
+        std::free(memory);
+    }
+}
+
+// Padding
+int mgrid::Arena::padded_columns(const int nz) {
+    const int width = arenaAlignment/sizeof(double);
+    return ((nz + width - 1)/width)*width;
+}
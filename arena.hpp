@@ -0,0 +1,60 @@
+/*
+    arena.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    A single aligned block of memory, which the levels of a Stack are laid
+    out in one after another.
+*/
+
+#ifndef ARENA_HPP_5HV2K8QN
+#define ARENA_HPP_5HV2K8QN
+
+#include <cstddef>
+#include <boost/utility.hpp>
+
+namespace mgrid {
+
+// = Arena class interface =
+/*  The arena is aligned to arenaAlignment bytes (a cache line, which is also
+    the width of the widest vector registers), and rows of each level are
+    padded to a multiple of this by padded_columns, so that every row starts
+    on an aligned boundary. If hugePages is set the arena is aligned to a
+    huge page instead, and the kernel is asked to back it with huge pages
+    (where supported), which cuts down TLB misses on large stacks.
+
+    The memory is not initialised here: the owner should write to it from
+    the threads which will use it, so that on NUMA machines each page ends
+    up on the right node.
+
+    An arena can also be mapped from part of an open file (e.g. a
+    checkpoint), starting offset bytes in, which must be a multiple of the
+    page size. The mapping is private, so changes to the arena aren't
+    written back to the file, and pages are only read when they're first
+    used.
+*/
+class Arena: private boost::noncopyable {
+public:
+    Arena(const std::size_t numberOfDoubles, const bool hugePages=false);
+    Arena(const int file, const std::size_t offset,
+        const std::size_t numberOfDoubles);
+    ~Arena();
+
+    // Accessors
+    inline double* data() { return memory; }
+    inline std::size_t size() { return length; }
+
+    // Row length (in doubles) including padding
+    static int padded_columns(const int nz);
+
+private:
+    double* memory;
+    std::size_t length;
+    std::size_t mappedBytes;    // Zero unless mapped from a file
+};
+
+const std::size_t arenaAlignment = 64;
+const std::size_t hugePageSize = 2*1024*1024;
+
+} // end namespace mgrid
+
+#endif /* end of include guard: ARENA_HPP_5HV2K8QN */
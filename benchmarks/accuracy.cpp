@@ -0,0 +1,268 @@
+/*
+    accuracy.cpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+
+    Accuracy per cost: solves manufactured solution problems (see
+    manufactured.hpp) with each combination of resolution, cycle type and
+    smoothing, and measures the error, time and memory of each. The
+    configurations which no other beats on both error and time (the Pareto
+    front) are marked, and the cheapest which meets a target error is
+    reported, to choose the grids and cycles for a given accuracy.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <multigrid/multigrid.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/program_options.hpp>
+
+#include "manufactured.hpp"
+#include "benchmark.hpp"
+
+using namespace mgrid;
+using namespace std;
+namespace bpo = boost::program_options;
+
+// One solver configuration, and how it did
+struct Configuration {
+    string problem, cycle, sweeps, coarse;
+    int grids, nx, nz;
+    double maxError, rmsError, seconds, memory, workUnits;
+    bool pareto;
+
+    string label() const;
+};
+string Configuration::label() const {
+    ostringstream result;
+    result << problem << " " << cycle << "(" << sweeps << ") " << coarse
+           << " " << nx << "x" << nz;
+    return result.str();
+}
+bool faster(const Configuration& a, const Configuration& b) {
+    return a.seconds < b.seconds;
+}
+
+// Fresh solvers for each timed solve
+void make_manufactured(boost::shared_ptr<Manufactured>& problem,
+    const Settings& settings, const bool variableCoefficient)
+{
+    Silence silence;
+    problem.reset(new Manufactured(settings, variableCoefficient));
+}
+void solve_quietly(boost::shared_ptr<Manufactured>& problem) {
+    Silence silence;
+    problem->solve();
+}
+
+// Parses a cycle type (v, w or 3), pre/post sweeps (e.g. 1/2) or coarse
+// operator (rediscretised or galerkin), throwing if it can't
+CycleType parse_cycle(const string& cycle) {
+    if (cycle == "v" || cycle == "V") return vCycle;
+    if (cycle == "w" || cycle == "W") return wCycle;
+    if (cycle == "3") return threeCycle;
+    throw std::runtime_error("Unknown cycle type " + cycle);
+}
+void parse_sweeps(const string& sweeps, unsigned long& pre,
+    unsigned long& post)
+{
+    if (std::sscanf(sweeps.c_str(), "%lu/%lu", &pre, &post) != 2)
+        throw std::runtime_error("Sweeps should be pre/post, not " + sweeps);
+}
+CoarseOperatorType parse_coarse(const string& coarse) {
+    if (coarse == "rediscretised") return rediscretisedOperator;
+    if (coarse == "galerkin") return galerkinOperator;
+    throw std::runtime_error("Unknown coarse operator " + coarse);
+}
+
+// Marks the configurations of each problem which are more accurate than
+// every faster one, after sorting them by time
+void find_pareto_front(vector<Configuration>& configurations) {
+    std::stable_sort(configurations.begin(), configurations.end(), faster);
+    map<string, double> bestError;
+    foreach(Configuration& configuration, configurations) {
+        map<string, double>::iterator best
+            = bestError.find(configuration.problem);
+        configuration.pareto = (best == bestError.end()
+            || configuration.maxError < best->second);
+        if (configuration.pareto)
+            bestError[configuration.problem] = configuration.maxError;
+    }
+}
+
+void write_table(ostream& out, const vector<Configuration>& configurations,
+    const string& problem)
+{
+    char line[200];
+    std::sprintf(line, "%-44s %12s %12s %10s %8s %11s %s\n", "configuration",
+        "max error", "rms error", "time (ms)", "WU", "memory (MB)", "pareto");
+    out << line;
+    foreach(const Configuration& c, configurations) {
+        if (c.problem != problem) continue;
+        std::sprintf(line, "%-44s %12.4e %12.4e %10.3f %8.1f %11.2f %s\n",
+            c.label().c_str(), c.maxError, c.rmsError, 1e3*c.seconds,
+            c.workUnits, c.memory/(1024.0*1024.0), c.pareto ? "*" : "");
+        out << line;
+    }
+}
+
+void write_json(ostream& out, const vector<Configuration>& configurations) {
+    out << "[\n";
+    for (size_t n=0; n<configurations.size(); n++) {
+        const Configuration& c = configurations[n];
+        out << "{\"problem\": \"" << c.problem << "\", \"cycle\": \""
+            << c.cycle << "\", \"sweeps\": \"" << c.sweeps
+            << "\", \"coarse\": \"" << c.coarse << "\", \"grids\": "
+            << c.grids << ", \"nx\": " << c.nx << ", \"nz\": " << c.nz
+            << ", \"max_error\": " << c.maxError << ", \"rms_error\": "
+            << c.rmsError << ", \"seconds\": " << c.seconds
+            << ", \"work_units\": " << c.workUnits << ", \"memory\": "
+            << c.memory << ", \"pareto\": " << (c.pareto ? "true" : "false")
+            << "}" << (n+1 < configurations.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+int main (int argc, char *argv[]) {
+    try {
+        // Set up command-line options
+        vector<string> problems, cycles, sweeps, coarse;
+        vector<int> grids;
+        double aspect, minTime, targetError;
+        int minimumResolution;
+        string outputPath;
+        bpo::options_description visibleOptions(
+            "Usage ./accuracy_bench [options]\n\nOptions:");
+        visibleOptions.add_options()
+            ("help", "prints this help message")
+            ("problems", bpo::value<vector<string> >(&problems)->multitoken(),
+                "problems to solve: poisson and/or variable (default both)")
+            ("aspect", bpo::value<double>(&aspect)->default_value(1),
+                "aspect ratio")
+            ("grids", bpo::value<vector<int> >(&grids)->multitoken(),
+                "numbers of grids (default 4 5 6 7)")
+            ("minimum-resolution", bpo::value<int>(&minimumResolution)
+                ->default_value(4), "points across the coarsest grid")
+            ("cycles", bpo::value<vector<string> >(&cycles)->multitoken(),
+                "cycle types: v, w or 3 (default v w)")
+            ("sweeps", bpo::value<vector<string> >(&sweeps)->multitoken(),
+                "pre/post relaxation sweeps (default 1/1 1/2 2/2)")
+            ("coarse", bpo::value<vector<string> >(&coarse)->multitoken(),
+                "coarse operators: rediscretised and/or galerkin (default "
+                "both)")
+            ("target-error", bpo::value<double>(&targetError)
+                ->default_value(0), "report the cheapest configuration with "
+                "at most this max error")
+            ("min-time", bpo::value<double>(&minTime)->default_value(0.1),
+                "least time to spend timing each solve, in seconds")
+            ("output", bpo::value<string>(&outputPath),
+                "write every configuration to this JSON file");
+        bpo::variables_map varMap;
+        bpo::store(bpo::parse_command_line(argc, argv, visibleOptions),
+            varMap);
+        bpo::notify(varMap);
+        if (varMap.count("help")) {
+            std::cout << visibleOptions << std::endl;
+            return 1;
+        }
+        if (problems.empty()) {
+            problems.push_back("poisson");
+            problems.push_back("variable");
+        }
+        if (grids.empty()) for (int n=4; n<=7; n++) grids.push_back(n);
+        if (cycles.empty()) {
+            cycles.push_back("v");
+            cycles.push_back("w");
+        }
+        if (sweeps.empty()) {
+            sweeps.push_back("1/1");
+            sweeps.push_back("1/2");
+            sweeps.push_back("2/2");
+        }
+        if (coarse.empty()) {
+            coarse.push_back("rediscretised");
+            coarse.push_back("galerkin");
+        }
+
+        // Solve each configuration, timing it from a fresh solver
+        BenchmarkRunner runner(minTime, 3);
+        vector<Configuration> configurations;
+        foreach(const string& problemName, problems) {
+            if (problemName != "poisson" && problemName != "variable")
+                throw std::runtime_error("Unknown problem " + problemName);
+            const bool variableCoefficient = (problemName == "variable");
+            foreach(int numberOfGrids, grids)
+            foreach(const string& cycle, cycles)
+            foreach(const string& sweep, sweeps)
+            foreach(const string& coarseOperator, coarse) {
+                Settings settings;
+                settings.aspectRatio = aspect;
+                settings.numberOfGrids = numberOfGrids;
+                settings.minimumResolution = minimumResolution;
+                settings.mgCycleType = parse_cycle(cycle);
+                parse_sweeps(sweep, settings.preMGRelaxIter,
+                    settings.postMGRelaxIter);
+                settings.coarseOperator = parse_coarse(coarseOperator);
+
+                boost::shared_ptr<Manufactured> problem;
+                make_manufactured(problem, settings, variableCoefficient);
+                Configuration c;
+                c.problem = problemName;
+                c.cycle = cycle;
+                c.sweeps = sweep;
+                c.coarse = coarseOperator;
+                c.grids = numberOfGrids;
+                c.nx = problem->get_result().rows();
+                c.nz = problem->get_result().columns();
+
+                Benchmark benchmark;
+                benchmark.name = c.label();
+                benchmark.aspect = aspect;
+                benchmark.nx = c.nx;
+                benchmark.nz = c.nz;
+                benchmark.points = double(c.nx)*c.nz;
+                benchmark.bytes = 0;
+                benchmark.setup = boost::bind(&make_manufactured,
+                    boost::ref(problem), settings, variableCoefficient);
+                benchmark.kernel = boost::bind(&solve_quietly,
+                    boost::ref(problem));
+                c.seconds = runner.run(benchmark).seconds;
+                problem->error(c.maxError, c.rmsError);
+                c.memory = problem->peak_memory();
+                c.workUnits = problem->solve_result().workUnits;
+                configurations.push_back(c);
+            }
+        }
+
+        // Report the front for each problem, fastest first
+        find_pareto_front(configurations);
+        foreach(const string& problemName, problems) {
+            cout << endl << "== " << problemName << ", aspect " << aspect
+                 << " ==" << endl;
+            write_table(cout, configurations, problemName);
+            if (targetError <= 0) continue;
+            vector<Configuration>::const_iterator c = configurations.begin();
+            while (c != configurations.end() && (c->problem != problemName
+                || c->maxError > targetError))
+                c++;
+            if (c == configurations.end()) {
+                cout << "No configuration reaches a max error of "
+                     << targetError << endl;
+            } else {
+                cout << "Cheapest with max error below " << targetError
+                     << ": " << c->label() << " (" << 1e3*c->seconds
+                     << " ms)" << endl;
+            }
+        }
+        if (not(outputPath.empty())) {
+            ofstream file(outputPath.c_str());
+            write_json(file, configurations);
+        }
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,178 @@
+/*
+    benchmark.cpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <multigrid/multigrid.hpp>
+
+#include "benchmark.hpp"
+
+using mgrid::Profiler;
+
+// = BenchmarkResult =
+std::string BenchmarkResult::key() const {
+    std::ostringstream result;
+    result << name << " A" << aspect << " " << nx << "x" << nz;
+    return result.str();
+}
+double BenchmarkResult::points_per_second() const {
+    return seconds > 0 ? points/seconds : 0;
+}
+double BenchmarkResult::gb_per_second() const {
+    return seconds > 0 ? 1e-9*bytes/seconds : 0;
+}
+
+// = BenchmarkRunner =
+BenchmarkRunner::BenchmarkRunner(const double minTime,
+    const unsigned long minRepetitions):
+    minTime(minTime),
+    minRepetitions(minRepetitions)
+{}
+
+const BenchmarkResult& BenchmarkRunner::run(const Benchmark& benchmark) {
+    // Warm up caches (and the workspace) first
+    if (benchmark.setup) benchmark.setup();
+    benchmark.kernel();
+
+    // Time each call separately, so that the median isn't thrown by the
+    // odd interruption
+    std::vector<double> times;
+    double total = 0;
+    while (total < minTime || times.size() < minRepetitions) {
+        if (benchmark.setup) benchmark.setup();
+        const double start = Profiler::now();
+        benchmark.kernel();
+        times.push_back(Profiler::now() - start);
+        total += times.back();
+    }
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.aspect = benchmark.aspect;
+    result.nx = benchmark.nx;
+    result.nz = benchmark.nz;
+    result.repetitions = times.size();
+    result.seconds = times[times.size()/2];
+    result.minSeconds = times.front();
+    result.points = benchmark.points;
+    result.bytes = benchmark.bytes;
+    benchmarkResults.push_back(result);
+    return benchmarkResults.back();
+}
+
+// Reports
+void BenchmarkRunner::write_table_header(std::ostream& out) const {
+    char line[160];
+    std::sprintf(line, "%-34s %8s %12s %12s %10s\n", "benchmark", "reps",
+        "median (ms)", "Mpoints/s", "GB/s");
+    out << line;
+}
+void BenchmarkRunner::write_table_row(std::ostream& out,
+    const BenchmarkResult& result) const
+{
+    char line[160];
+    std::sprintf(line, "%-34s %8lu %12.4f %12.2f %10.3f\n",
+        result.key().c_str(), result.repetitions, 1e3*result.seconds,
+        1e-6*result.points_per_second(), result.gb_per_second());
+    out << line;
+}
+void BenchmarkRunner::write_json(std::ostream& out) const {
+    const std::streamsize precision = out.precision(9);
+    out << "{\n  \"kernels\": \""
+        << mgrid::kernelISANames[mgrid::kernels().isa] << "\",\n"
+        << "  \"benchmarks\": [";
+    for (std::size_t n=0; n<benchmarkResults.size(); n++) {
+        const BenchmarkResult& r = benchmarkResults[n];
+        out << (n > 0 ? ",\n" : "\n")
+            << "    {\"name\": \"" << r.name << "\", \"aspect\": " << r.aspect
+            << ", \"nx\": " << r.nx << ", \"nz\": " << r.nz
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"seconds\": " << r.seconds
+            << ", \"min_seconds\": " << r.minSeconds
+            << ", \"points\": " << r.points << ", \"bytes\": " << r.bytes
+            << ", \"points_per_second\": " << r.points_per_second()
+            << ", \"gb_per_second\": " << r.gb_per_second() << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.precision(precision);
+}
+int BenchmarkRunner::compare(
+    const std::map<std::string, BenchmarkResult>& baseline,
+    const double tolerance, std::ostream& out) const
+{
+    int slower = 0;
+    char line[200];
+    std::sprintf(line, "%-34s %12s %12s %9s\n", "benchmark", "now (ms)",
+        "base (ms)", "change");
+    out << line;
+    foreach(const BenchmarkResult& result, benchmarkResults) {
+        std::map<std::string, BenchmarkResult>::const_iterator match
+            = baseline.find(result.key());
+        if (match == baseline.end()) {
+            std::sprintf(line, "%-34s %12.4f %12s\n", result.key().c_str(),
+                1e3*result.seconds, "-");
+            out << line;
+            continue;
+        }
+        const double change = result.seconds/match->second.seconds - 1;
+        const bool isSlower = (change > tolerance);
+        if (isSlower) slower++;
+        std::sprintf(line, "%-34s %12.4f %12.4f %+8.1f%%%s\n",
+            result.key().c_str(), 1e3*result.seconds,
+            1e3*match->second.seconds, 100*change,
+            isSlower ? "  SLOWER" : "");
+        out << line;
+    }
+    return slower;
+}
+
+// = Baselines =
+// Value of a field on a line written by write_json
+static bool json_field(const std::string& line, const std::string& field,
+    std::string& value)
+{
+    const std::string label = "\"" + field + "\": ";
+    std::size_t start = line.find(label);
+    if (start == std::string::npos) return false;
+    start += label.size();
+    if (line[start] == '"') {
+        const std::size_t end = line.find('"', start + 1);
+        if (end == std::string::npos) return false;
+        value = line.substr(start + 1, end - start - 1);
+    } else {
+        value = line.substr(start, line.find_first_of(",}", start) - start);
+    }
+    return true;
+}
+bool read_baseline(const std::string& path,
+    std::map<std::string, BenchmarkResult>& baseline)
+{
+    std::ifstream file(path.c_str());
+    if (not(file)) return false;
+    std::string line, value;
+    while (std::getline(file, line)) {
+        BenchmarkResult result;
+        if (not(json_field(line, "name", result.name))) continue;
+        if (json_field(line, "aspect", value))
+            result.aspect = std::atof(value.c_str());
+        if (json_field(line, "nx", value)) result.nx = std::atoi(value.c_str());
+        if (json_field(line, "nz", value)) result.nz = std::atoi(value.c_str());
+        if (json_field(line, "repetitions", value))
+            result.repetitions = std::atol(value.c_str());
+        if (json_field(line, "seconds", value))
+            result.seconds = std::atof(value.c_str());
+        if (json_field(line, "min_seconds", value))
+            result.minSeconds = std::atof(value.c_str());
+        if (json_field(line, "points", value))
+            result.points = std::atof(value.c_str());
+        if (json_field(line, "bytes", value))
+            result.bytes = std::atof(value.c_str());
+        baseline[result.key()] = result;
+    }
+    return true;
+}
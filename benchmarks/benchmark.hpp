@@ -0,0 +1,113 @@
+/*
+    benchmark.hpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+
+    Timing harness for the kernel and solver benchmarks: runs each kernel
+    until enough time has passed to trust the timing, and reports the
+    points and bytes it gets through per second.
+*/
+
+#ifndef BENCHMARK_HPP_K7TD2QXN
+#define BENCHMARK_HPP_K7TD2QXN
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <boost/function.hpp>
+
+// = Benchmark struct =
+/*  A kernel to time, with the grid it runs on and the work it does each
+    time it's called. Points are the grid points updated (or written), and
+    bytes an estimate of the memory traffic (each array streamed through
+    once); bytes is zero for whole solves, where it doesn't mean much.
+    setup, if given, is called before each call of the kernel and isn't
+    timed (e.g. to build a fresh solver for each solve).
+*/
+struct Benchmark {
+    std::string name;
+    double aspect;
+    int nx, nz;
+    double points, bytes;
+    boost::function<void ()> setup;
+    boost::function<void ()> kernel;
+};
+
+// = BenchmarkResult struct =
+/*  Timings of a benchmark: the median and fastest time per call over all
+    the repetitions. Rates are worked out from the median.
+*/
+struct BenchmarkResult {
+    BenchmarkResult(): aspect(0), nx(0), nz(0), repetitions(0), seconds(0),
+        minSeconds(0), points(0), bytes(0) {};
+    std::string name;
+    double aspect;
+    int nx, nz;
+    unsigned long repetitions;
+    double seconds, minSeconds;
+    double points, bytes;
+
+    // Identifies a benchmark between runs, e.g. "relax A4 1025x257"
+    std::string key() const;
+    double points_per_second() const;
+    double gb_per_second() const;
+};
+
+// = BenchmarkRunner class interface =
+/*  Runs benchmarks and keeps their results. Each kernel is called once to
+    warm up, then repeatedly until it has run for at least minTime seconds
+    and minRepetitions times.
+
+    write_json writes the results with one benchmark on each line, which
+    is the format read_baseline reads back (it isn't a general JSON
+    parser). compare prints each result next to the matching one in a
+    baseline, and returns the number which are more than tolerance (a
+    fraction) slower than the baseline.
+*/
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(const double minTime, const unsigned long minRepetitions);
+
+    const BenchmarkResult& run(const Benchmark& benchmark);
+    inline const std::vector<BenchmarkResult>& results() const;
+
+    // Reports
+    void write_table_header(std::ostream& out) const;
+    void write_table_row(std::ostream& out,
+        const BenchmarkResult& result) const;
+    void write_json(std::ostream& out) const;
+    int compare(const std::map<std::string, BenchmarkResult>& baseline,
+        const double tolerance, std::ostream& out) const;
+
+private:
+    const double minTime;
+    const unsigned long minRepetitions;
+    std::vector<BenchmarkResult> benchmarkResults;
+};
+
+// Reads results written by BenchmarkRunner::write_json, by key. Returns
+// false if the file can't be opened.
+bool read_baseline(const std::string& path,
+    std::map<std::string, BenchmarkResult>& baseline);
+
+// = Silence class =
+/*  Sends std::cout to nowhere while it's in scope, to keep the solvers'
+    progress messages out of the benchmark output.
+*/
+class Silence {
+public:
+    Silence(): saved(std::cout.rdbuf(sink.rdbuf())) {};
+    ~Silence() { std::cout.rdbuf(saved); }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+};
+
+// = Inline methods =
+inline const std::vector<BenchmarkResult>& BenchmarkRunner::results() const {
+    return benchmarkResults;
+}
+
+#endif /* end of include guard: BENCHMARK_HPP_K7TD2QXN */
@@ -0,0 +1,273 @@
+/*
+    main.cpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+
+    Benchmarks of the multigrid kernels (relaxation, residuals, transfers,
+    boundary updates and derivatives) and of whole Poisson and Mosolov
+    solves, over a range of grid sizes and aspect ratios.
+*/
+
+#include <fstream>
+#include <multigrid/multigrid.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/program_options.hpp>
+
+#include "poisson.hpp"
+#include "mosolov.hpp"
+#include "benchmark.hpp"
+
+using namespace mgrid;
+using namespace std;
+namespace bpo = boost::program_options;
+
+// Command-line options
+struct BenchmarkOptions {
+    vector<double> aspects;
+    vector<int> grids, solveGrids;
+    string filter;
+    int tileSize;
+};
+
+// Should we run the named benchmark?
+bool selected(const BenchmarkOptions& options, const string& name) {
+    return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+// Fresh solvers for the solve benchmarks
+void make_poisson(boost::shared_ptr<Poisson>& problem,
+    const Settings& settings)
+{
+    Silence silence;
+    problem.reset(new Poisson(settings));
+}
+void make_mosolov(boost::shared_ptr<Mosolov>& problem,
+    const MosolovSettings& settings)
+{
+    Silence silence;
+    problem.reset(new Mosolov(settings));
+}
+template <typename Solver> void solve_quietly(
+    boost::shared_ptr<Solver>& problem)
+{
+    Silence silence;
+    problem->solve();
+}
+
+// Kernels on the finest grid of a Poisson problem. Bytes count each
+// array read or written once per call, as in the profiler. relax is a 
+// single sweep along with the boundary update after it.
+void run_kernels(BenchmarkRunner& runner, const BenchmarkOptions& options,
+    const double aspect, const int grids)
+{
+    Settings settings;
+    settings.aspectRatio = aspect;
+    settings.numberOfGrids = grids;
+    settings.tileSize = options.tileSize;
+    boost::shared_ptr<Poisson> problem;
+    make_poisson(problem, settings);
+    Stack& u = problem->get_solution();
+    const Level fine = u.finestLevel;
+    const int nx = u[fine].rows(), nz = u[fine].columns();
+    const double points = double(nx)*nz;
+    const double coarsePoints = double(u[fine-1].rows())*u[fine-1].columns();
+    const double boundaryPoints = 2.0*(nx + nz);
+    FDArray residual(aspect, nx, nz), divergence(aspect, nx, nz);
+    FDVecArray gradient(aspect, nx, nz);
+
+    Benchmark benchmark;
+    benchmark.aspect = aspect;
+    benchmark.nx = nx;
+    benchmark.nz = nz;
+    benchmark.points = points;
+    benchmark.bytes = 3*sizeof(double)*points;
+    if (selected(options, "relax")) {
+        benchmark.name = "relax";
+        benchmark.kernel = boost::bind(
+            static_cast<void (MultigridBase::*)(const Level,
+                const unsigned long)>(&MultigridBase::relax),
+            problem.get(), fine, 1ul);
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "residual")) {
+        benchmark.name = "residual";
+        benchmark.kernel = boost::bind(&MultigridBase::evaluate_residual,
+            problem.get(), fine, boost::ref(residual));
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "gradient")) {
+        benchmark.name = "gradient";
+        benchmark.kernel = boost::bind(&FDArray::gradient, &u[fine],
+            boost::ref(gradient));
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "divergence")) {
+        benchmark.name = "divergence";
+        benchmark.kernel = boost::bind(&FDVecArray::divergence, &gradient,
+            boost::ref(divergence));
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "restrict")) {
+        benchmark.name = "restrict";
+        benchmark.points = coarsePoints;
+        benchmark.bytes = sizeof(double)*(points + coarsePoints);
+        benchmark.kernel = boost::bind(
+            static_cast<void (Stack::*)(Level)>(&Stack::coarsen), &u, fine);
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "interpolate")) {
+        benchmark.name = "interpolate";
+        benchmark.points = points;
+        benchmark.bytes = sizeof(double)*(points + coarsePoints);
+        benchmark.kernel = boost::bind(
+            static_cast<void (Stack::*)(Level)>(&Stack::refine), &u, fine-1);
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "update_boundaries")) {
+        benchmark.name = "update_boundaries";
+        benchmark.points = boundaryPoints;
+        benchmark.bytes = 6*sizeof(double)*boundaryPoints;
+        benchmark.kernel = boost::bind(&FDArray::update_boundaries, &u[fine]);
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+}
+
+// Whole solves, each from a freshly built solver
+void run_solves(BenchmarkRunner& runner, const BenchmarkOptions& options,
+    const double aspect, const int grids)
+{
+    Settings settings;
+    settings.aspectRatio = aspect;
+    settings.numberOfGrids = grids;
+    settings.tileSize = options.tileSize;
+    Benchmark benchmark;
+    benchmark.aspect = aspect;
+    benchmark.bytes = 0;
+    if (selected(options, "poisson_solve")) {
+        boost::shared_ptr<Poisson> problem;
+        make_poisson(problem, settings);
+        benchmark.name = "poisson_solve";
+        benchmark.nx = problem->get_result().rows();
+        benchmark.nz = problem->get_result().columns();
+        benchmark.points = double(benchmark.nx)*benchmark.nz;
+        benchmark.setup = boost::bind(&make_poisson, boost::ref(problem),
+            settings);
+        benchmark.kernel = boost::bind(&solve_quietly<Poisson>,
+            boost::ref(problem));
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+    if (selected(options, "mosolov_solve")) {
+        MosolovSettings mosolovSettings;
+        mosolovSettings.multigridSettings = settings;
+        boost::shared_ptr<Mosolov> problem;
+        make_mosolov(problem, mosolovSettings);
+        benchmark.name = "mosolov_solve";
+        benchmark.nx = problem->get_result().rows();
+        benchmark.nz = problem->get_result().columns();
+        benchmark.points = double(benchmark.nx)*benchmark.nz;
+        benchmark.setup = boost::bind(&make_mosolov, boost::ref(problem),
+            mosolovSettings);
+        benchmark.kernel = boost::bind(&solve_quietly<Mosolov>,
+            boost::ref(problem));
+        runner.write_table_row(cout, runner.run(benchmark));
+    }
+}
+
+int main (int argc, char *argv[]) {
+    try {
+        // Set up command-line options
+        BenchmarkOptions options;
+        double minTime, tolerance;
+        unsigned long minRepetitions;
+        string outputPath, baselinePath;
+        bpo::options_description visibleOptions(
+            "Usage ./multigrid_bench [options]\n\nOptions:");
+        visibleOptions.add_options()
+            ("help", "prints this help message")
+            ("aspects", bpo::value< vector<double> >(&options.aspects)
+                ->multitoken(), "aspect ratios (default 1 4)")
+            ("grids", bpo::value< vector<int> >(&options.grids)
+                ->multitoken(), "numbers of grids for the kernels "
+                "(default 6 7 8)")
+            ("solve-grids", bpo::value< vector<int> >(&options.solveGrids)
+                ->multitoken(), "numbers of grids for the solves "
+                "(default 5 6)")
+            ("filter", bpo::value<string>(&options.filter),
+                "only run benchmarks with this in their name")
+            ("tile-size", bpo::value<int>(&options.tileSize)
+                ->default_value(0), "tile width for sweeps and transfers")
+            ("min-time", bpo::value<double>(&minTime)->default_value(0.2),
+                "least time to spend on each benchmark, in seconds")
+            ("min-repetitions", bpo::value<unsigned long>(&minRepetitions)
+                ->default_value(3), "least number of calls of each kernel")
+            ("output", bpo::value<string>(&outputPath),
+                "write the results to this JSON file")
+            ("baseline", bpo::value<string>(&baselinePath),
+                "compare the results with this JSON file")
+            ("tolerance", bpo::value<double>(&tolerance)
+                ->default_value(0.1), "fraction by which a benchmark can "
+                "be slower than the baseline before it fails");
+        bpo::variables_map varMap;
+        bpo::store(bpo::parse_command_line(argc, argv, visibleOptions),
+            varMap);
+        bpo::notify(varMap);
+        if (varMap.count("help")) {
+            std::cout << visibleOptions << std::endl;
+            return 1;
+        }
+        if (options.aspects.empty()) {
+            options.aspects.push_back(1);
+            options.aspects.push_back(4);
+        }
+        if (options.grids.empty()) {
+            options.grids.push_back(6);
+            options.grids.push_back(7);
+            options.grids.push_back(8);
+        }
+        if (options.solveGrids.empty()) {
+            options.solveGrids.push_back(5);
+            options.solveGrids.push_back(6);
+        }
+
+        // Run the benchmarks
+        BenchmarkRunner runner(minTime, minRepetitions);
+        cout << "Kernels: " << kernelISANames[kernels().isa]
+             << " (set MULTIGRID_KERNELS to change)" << endl;
+        runner.write_table_header(cout);
+        foreach(double aspect, options.aspects) {
+            foreach(int grids, options.grids)
+                run_kernels(runner, options, aspect, grids);
+            foreach(int grids, options.solveGrids)
+                run_solves(runner, options, aspect, grids);
+        }
+
+        // Save the results, and compare them with the baseline
+        if (not(outputPath.empty())) {
+            ofstream file(outputPath.c_str());
+            runner.write_json(file);
+        }
+        if (not(baselinePath.empty())) {
+            map<string, BenchmarkResult> baseline;
+            if (not(read_baseline(baselinePath, baseline))) {
+                Message msg(ErrorMessage);
+                msg << "Couldn't read the baseline " << baselinePath << endl;
+                cout << msg.str();
+                return 1;
+            }
+            cout << endl;
+            const int slower = runner.compare(baseline, tolerance, cout);
+            if (slower > 0) {
+                Message msg(WarningMessage);
+                msg << slower << " benchmark(s) slower than the baseline by "
+                    << "more than " << 100*tolerance << "%" << endl;
+                cout << msg.str();
+                return 2;
+            }
+        }
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+    manufactured.cpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+*/
+
+#include "manufactured.hpp"
+
+using namespace mgrid;
+
+Manufactured::Manufactured(const Settings& settings,
+    const bool variableCoefficient):
+    LinearMultigrid::LinearMultigrid(settings),
+    variableCoefficient(variableCoefficient)
+{
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags)
+        solution.boundaryConditions.set(boundaryFlag, zeroDirichletCondition);
+
+    // Coefficients at the midpoints on every level, and the source term
+    if (variableCoefficient) {
+        xCoefficient.reset(new Stack(settings));
+        zCoefficient.reset(new Stack(settings));
+        for (Level level=coarsestLevel; level<=finestLevel; level++) {
+            FDArray& kx = (*xCoefficient)[level];
+            FDArray& kz = (*zCoefficient)[level];
+            const double hx = kx.spacing(0), hz = kx.spacing(1);
+            ARRAY_LOOP(kx) {
+                kx(i, j) = coefficient((i + 0.5)*hx, j*hz);
+                kz(i, j) = coefficient(i*hx, (j + 0.5)*hz);
+            }
+        }
+    }
+    FDArray& f = source[finestLevel];
+    const double hx = f.spacing(0), hz = f.spacing(1);
+    ARRAY_LOOP(f) f(i, j) = forcing(i*hx, j*hz);
+    sourceIsSet = true;
+}
+Manufactured::~Manufactured() { /* pass */ }
+
+double Manufactured::forcing(const double x, const double z) const {
+    // With u = sin(a x) sin(b z), div(k grad u) = k (lap u + grad(log k) .
+    // grad u), and grad(log k) = (1/aspect, 1) for the variable coefficient
+    const double a = M_PI/aspect, b = M_PI;
+    const double u = exact(x, z);
+    const double laplacian = -(a*a + b*b)*u;
+    if (not(variableCoefficient)) return laplacian;
+    const double ux = a*std::cos(a*x)*std::sin(b*z);
+    const double uz = b*std::sin(a*x)*std::cos(b*z);
+    return coefficient(x, z)*(laplacian + ux/aspect + uz);
+}
+
+void Manufactured::error(double& maxError, double& rmsError) {
+    FDArray& u = solution[finestLevel];
+    const double hx = u.spacing(0), hz = u.spacing(1);
+    double sum = 0;
+    maxError = 0;
+    ARRAY_LOOP(u) {
+        const double difference = std::fabs(u(i, j) - exact(i*hx, j*hz));
+        maxError = std::max(maxError, difference);
+        sum += difference*difference;
+    }
+    rmsError = std::sqrt(sum/u.size());
+}
+
+std::size_t Manufactured::peak_memory() {
+    return LinearMultigrid::peak_memory() + (variableCoefficient ?
+        xCoefficient->memory() + zCoefficient->memory() : 0);
+}
+
+std::string Manufactured::filename(std::string root) {
+    std::ostringstream name;
+    name.precision(1);
+    name << root << (variableCoefficient ? "variable" : "poisson") << "A"
+         << std::fixed << aspect;
+    return name.str();
+}
@@ -0,0 +1,105 @@
+/*
+    manufactured.hpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+
+    Manufactured solution problems for measuring discretisation error: the
+    source term is worked out from a known solution, so the error of a
+    solve can be measured exactly.
+*/
+
+#ifndef MANUFACTURED_HPP_W3NB8R1E
+#define MANUFACTURED_HPP_W3NB8R1E
+
+#include <cmath>
+#include <multigrid/multigrid.hpp>
+
+// = Manufactured class interface =
+/*  Solves div(k grad u) = f on [0, aspect] x [0, 1], with u = 0 on every
+    boundary, for the exact solution u = sin(pi x/aspect) sin(pi z). The
+    coefficient k is 1 (Poisson's equation), or exp(x/aspect + z) for the
+    variable coefficient problem, which is discretised in conservative
+    form with k at the midpoints between grid points. The coefficients are
+    stored on every level (and counted in peak_memory), so coarse levels
+    are rediscretised from k rather than from the fine coefficients.
+*/
+class Manufactured: public mgrid::LinearMultigrid {
+public:
+    Manufactured(const mgrid::Settings& settings,
+        const bool variableCoefficient);
+    virtual ~Manufactured();
+
+    // Exact solution, coefficient and source term at a point
+    inline double exact(const double x, const double z) const;
+    inline double coefficient(const double x, const double z) const;
+    double forcing(const double x, const double z) const;
+
+    // Differences between the solution on the finest grid and the exact
+    // solution: the largest, and the root mean square
+    void error(double& maxError, double& rmsError);
+
+    // Solution routines
+    virtual inline double differential_operator(mgrid::Level level, int i,
+        int j);
+    virtual inline void relaxation_updater(mgrid::Level level, int i, int j);
+
+    virtual std::size_t peak_memory();
+    virtual std::string filename(std::string root="");
+
+protected:
+    const bool variableCoefficient;
+    // k(x + hx/2, z) and k(x, z + hz/2) at each point (x, z), for the 
+    // variable coefficient problem only
+    boost::shared_ptr<mgrid::Stack> xCoefficient, zCoefficient;
+};
+
+// = Inline functions =
+inline double Manufactured::exact(const double x, const double z) const {
+    return std::sin(M_PI*x/aspect)*std::sin(M_PI*z);
+}
+inline double Manufactured::coefficient(const double x,
+    const double z) const
+{
+    return variableCoefficient ? std::exp(x/aspect + z) : 1.0;
+}
+
+// Differential operators. The Dirichlet boundaries are set by
+// update_boundaries, so the operator is only needed inside them; on the
+// boundaries it returns the source term, which leaves no residual there.
+inline double Manufactured::differential_operator(mgrid::Level level, int i,
+    int j)
+{
+    mgrid::FDArray& u = solution[level];
+    if (not(variableCoefficient)) return u.dxx(i, j) + u.dzz(i, j);
+    if (i == 0 || j == 0 || i == u.rows()-1 || j == u.columns()-1)
+        return source[level](i, j);
+    const double hx = u.spacing(0), hz = u.spacing(1);
+    const mgrid::FDArray& kx = (*xCoefficient)[level];
+    const mgrid::FDArray& kz = (*zCoefficient)[level];
+    return (kx(i, j)*(u(i+1, j) - u(i, j))
+            - kx(i-1, j)*(u(i, j) - u(i-1, j)))/(hx*hx)
+        + (kz(i, j)*(u(i, j+1) - u(i, j))
+            - kz(i, j-1)*(u(i, j) - u(i, j-1)))/(hz*hz);
+}
+inline void Manufactured::relaxation_updater(mgrid::Level level, int i,
+    int j)
+{
+    mgrid::FDArray& u = solution[level];
+    const double hx = u.spacing(0), hz = u.spacing(1);
+    const double xxfactor = 1/(hx*hx);
+    const double zzfactor = 1/(hz*hz);
+    if (not(variableCoefficient)) {
+        u(i, j) = ((u(i+1, j) + u(i-1, j))*xxfactor
+            + (u(i, j+1) + u(i, j-1))*zzfactor
+            - source[level](i, j))/(2*(xxfactor + zzfactor));
+        return;
+    }
+    const mgrid::FDArray& kx = (*xCoefficient)[level];
+    const mgrid::FDArray& kz = (*zCoefficient)[level];
+    u(i, j) = ((kx(i, j)*u(i+1, j) + kx(i-1, j)*u(i-1, j))*xxfactor
+        + (kz(i, j)*u(i, j+1) + kz(i, j-1)*u(i, j-1))*zzfactor
+        - source[level](i, j))
+        / ((kx(i, j) + kx(i-1, j))*xxfactor
+            + (kz(i, j) + kz(i, j-1))*zzfactor);
+}
+
+#endif /* end of include guard: MANUFACTURED_HPP_W3NB8R1E */
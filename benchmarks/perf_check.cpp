@@ -0,0 +1,224 @@
+/*
+    perf_check.cpp (multigrid_bench)
+    Jess Robertson, 2026-10-19
+
+    Performance regression check, run by ctest -L perf: solves one of a
+    fixed set of problems, and fails if the solution's norm has changed,
+    the cycles converge more slowly than they used to, or the solve has
+    got slower than a saved baseline allows.
+*/
+
+#include <cmath>
+#include <fstream>
+#include <multigrid/multigrid.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/program_options.hpp>
+
+#include "poisson.hpp"
+#include "mosolov.hpp"
+#include "benchmark.hpp"
+
+using namespace mgrid;
+using namespace std;
+namespace bpo = boost::program_options;
+
+// Reference values for a case: the norm of the solution and the mean
+// convergence factor of the cycles on the finest grid
+struct Reference {
+    double norm, convergenceFactor;
+};
+
+// Reads a reference file, with a line for each case of the form
+//   <norm> <convergence factor> <benchmark key>
+// Blank lines and lines starting with # are skipped.
+bool read_references(const string& path, map<string, Reference>& references)
+{
+    ifstream file(path.c_str());
+    if (not(file)) return false;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream fields(line);
+        Reference reference;
+        string key;
+        if (not(fields >> reference.norm >> reference.convergenceFactor))
+            continue;
+        getline(fields >> ws, key);
+        references[key] = reference;
+    }
+    return true;
+}
+
+// Solve one of the cases, keeping the last solver so it can be checked
+template <typename Solver, typename SolverSettings> void make_solver(
+    boost::shared_ptr<Solver>& problem, const SolverSettings& settings)
+{
+    Silence silence;
+    problem.reset(new Solver(settings));
+}
+template <typename Solver> void solve(boost::shared_ptr<Solver>& problem) {
+    Silence silence;
+    problem->solve();
+}
+template <typename Solver, typename SolverSettings> Benchmark solve_benchmark(
+    const string& name, const double aspect,
+    boost::shared_ptr<Solver>& problem, const SolverSettings& settings)
+{
+    Benchmark benchmark;
+    make_solver(problem, settings);
+    benchmark.name = name;
+    benchmark.aspect = aspect;
+    benchmark.nx = problem->get_result().rows();
+    benchmark.nz = problem->get_result().columns();
+    benchmark.points = double(benchmark.nx)*benchmark.nz;
+    benchmark.bytes = 0;
+    benchmark.setup = boost::bind(&make_solver<Solver, SolverSettings>,
+        boost::ref(problem), settings);
+    benchmark.kernel = boost::bind(&solve<Solver>, boost::ref(problem));
+    return benchmark;
+}
+
+int main (int argc, char *argv[]) {
+    try {
+        // Set up command-line options
+        string caseName, referencePath, baselinePath, outputPath;
+        double aspect, tolerance, normTolerance, factorTolerance, minTime;
+        int grids;
+        bpo::options_description visibleOptions(
+            "Usage ./perf_check --case <poisson|mosolov> [options]\n\n"
+            "Options:");
+        visibleOptions.add_options()
+            ("help", "prints this help message")
+            ("case", bpo::value<string>(&caseName),
+                "problem to solve: poisson or mosolov")
+            ("aspect", bpo::value<double>(&aspect)->default_value(1),
+                "aspect ratio")
+            ("grids", bpo::value<int>(&grids)->default_value(6),
+                "number of grids")
+            ("reference", bpo::value<string>(&referencePath),
+                "file of reference norms and convergence factors")
+            ("baseline", bpo::value<string>(&baselinePath),
+                "JSON file of baseline times (from multigrid_bench or "
+                "--output); the time isn't checked if it doesn't exist")
+            ("output", bpo::value<string>(&outputPath),
+                "write the time to this JSON file, to use as a baseline")
+            ("tolerance", bpo::value<double>(&tolerance)
+                ->default_value(0.25), "fraction by which the solve can be "
+                "slower than the baseline")
+            ("norm-tolerance", bpo::value<double>(&normTolerance)
+                ->default_value(1e-6), "relative change allowed in the norm")
+            ("factor-tolerance", bpo::value<double>(&factorTolerance)
+                ->default_value(0.05), "increase allowed in the convergence "
+                "factor")
+            ("min-time", bpo::value<double>(&minTime)->default_value(0.5),
+                "least time to spend timing the solve, in seconds");
+        bpo::variables_map varMap;
+        bpo::store(bpo::parse_command_line(argc, argv, visibleOptions),
+            varMap);
+        bpo::notify(varMap);
+        if (varMap.count("help") || caseName.empty()) {
+            std::cout << visibleOptions << std::endl;
+            return 1;
+        }
+
+        // Time the solve, and keep the last solution to check
+        BenchmarkRunner runner(minTime, 3);
+        BenchmarkResult result;
+        double norm = 0, factor = 0;
+        if (caseName == "poisson") {
+            Settings settings;
+            settings.aspectRatio = aspect;
+            settings.numberOfGrids = grids;
+            settings.trackConvergence = true;
+            boost::shared_ptr<Poisson> problem;
+            result = runner.run(solve_benchmark("poisson_solve", aspect,
+                problem, settings));
+            norm = problem->get_result().norm();
+            factor = problem->solve_result().convergence_factor();
+        } else if (caseName == "mosolov") {
+            MosolovSettings settings;
+            settings.multigridSettings.aspectRatio = aspect;
+            settings.multigridSettings.numberOfGrids = grids;
+            settings.multigridSettings.trackConvergence = true;
+            boost::shared_ptr<Mosolov> problem;
+            result = runner.run(solve_benchmark("mosolov_solve", aspect,
+                problem, settings));
+            norm = problem->get_result().norm();
+            factor = problem->total_solve_result().convergence_factor();
+        } else {
+            Message msg(ErrorMessage);
+            msg << "Unknown case " << caseName << endl;
+            cout << msg.str();
+            return 1;
+        }
+        char line[200];
+        sprintf(line, "%.12e %.6f %s", norm, factor, result.key().c_str());
+        cout << "result: " << line << endl;
+        cout << "time: " << 1e3*result.seconds << " ms (median of "
+             << result.repetitions << ")" << endl;
+        if (not(outputPath.empty())) {
+            ofstream file(outputPath.c_str());
+            runner.write_json(file);
+        }
+
+        // Check the solution and convergence against the reference
+        int failures = 0;
+        map<string, Reference> references;
+        if (not(referencePath.empty())) {
+            if (not(read_references(referencePath, references))) {
+                Message msg(ErrorMessage);
+                msg << "Couldn't read the references " << referencePath
+                    << endl;
+                cout << msg.str();
+                return 1;
+            }
+            map<string, Reference>::const_iterator reference
+                = references.find(result.key());
+            if (reference == references.end()) {
+                Message msg(ErrorMessage);
+                msg << "No reference for " << result.key() << endl;
+                cout << msg.str();
+                failures++;
+            } else {
+                const Reference& r = reference->second;
+                if (fabs(norm - r.norm) > normTolerance*fabs(r.norm)) {
+                    Message msg(ErrorMessage);
+                    msg << "Norm " << norm << " differs from the reference "
+                        << r.norm << endl;
+                    cout << msg.str();
+                    failures++;
+                }
+                if (factor > r.convergenceFactor + factorTolerance) {
+                    Message msg(ErrorMessage);
+                    msg << "Convergence factor " << factor << " is worse "
+                        << "than the reference " << r.convergenceFactor
+                        << endl;
+                    cout << msg.str();
+                    failures++;
+                }
+            }
+        }
+
+        // Check the time against the baseline, if there is one
+        map<string, BenchmarkResult> baseline;
+        if (not(baselinePath.empty())) {
+            if (read_baseline(baselinePath, baseline)
+                && baseline.count(result.key()))
+            {
+                failures += runner.compare(baseline, tolerance, cout);
+            } else {
+                Message msg(StatusMessage);
+                msg << "No baseline time for " << result.key()
+                    << " in " << baselinePath << ", so the time isn't "
+                    << "checked" << endl;
+                cout << msg.str();
+            }
+        }
+        return failures > 0 ? 1 : 0;
+
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
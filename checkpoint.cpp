@@ -0,0 +1,188 @@
+/*
+    checkpoint.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <cstring>
+#include <cstdio>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "checkpoint.hpp"
+
+// Whole reads and writes at a given offset, retrying short transfers
+static bool write_all(const int file, const void* data, std::size_t bytes,
+    off_t offset)
+{
+    const char* next = static_cast<const char*>(data);
+    while (bytes > 0) {
+        const ssize_t written = pwrite(file, next, bytes, offset);
+        if (written <= 0) return false;
+        next += written;
+        bytes -= written;
+        offset += written;
+    }
+    return true;
+}
+static bool read_all(const int file, void* data, std::size_t bytes,
+    off_t offset)
+{
+    char* next = static_cast<char*>(data);
+    while (bytes > 0) {
+        const ssize_t got = pread(file, next, bytes, offset);
+        if (got <= 0) return false;
+        next += got;
+        bytes -= got;
+        offset += got;
+    }
+    return true;
+}
+
+// = CheckpointWriter =
+void mgrid::CheckpointWriter::add(const std::string& name, const void* data,
+    const std::size_t bytes)
+{
+    if (name.size() >= checkpointNameLength)
+        throw CheckpointException("section name " + name + " is too long");
+    const char* first = static_cast<const char*>(data);
+    names.push_back(name);
+    sections.push_back(std::vector<char>(first, first + bytes));
+}
+void mgrid::CheckpointWriter::write(const std::string& path) {
+    // Lay the sections out after the header and the section table, each on
+    // an aligned boundary
+    CheckpointHeader header;
+    std::memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+    header.version = checkpointVersion;
+    header.byteOrder = checkpointByteOrder;
+    header.numberOfSections = sections.size();
+    std::vector<CheckpointSection> table(sections.size());
+    std::size_t offset = sizeof(CheckpointHeader)
+        + table.size()*sizeof(CheckpointSection);
+    for (std::size_t n=0; n<table.size(); n++) {
+        offset = ((offset + checkpointAlignment - 1)/checkpointAlignment)
+            *checkpointAlignment;
+        std::memset(table[n].name, 0, checkpointNameLength);
+        std::strncpy(table[n].name, names[n].c_str(), checkpointNameLength-1);
+        table[n].offset = offset;
+        table[n].bytes = sections[n].size();
+        offset += sections[n].size();
+    }
+
+    // Write everything to a temporary file, and only replace the old
+    // checkpoint once it's all safely on disk
+    const std::string temporary = path + ".tmp";
+    const int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+        0644);
+    if (file < 0) throw CheckpointException("couldn't create " + temporary);
+    bool written = write_all(file, &header, sizeof(header), 0);
+    if (not(table.empty()))
+        written = written && write_all(file, &table[0],
+            table.size()*sizeof(CheckpointSection), sizeof(header));
+    for (std::size_t n=0; n<table.size(); n++)
+        if (not(sections[n].empty()))
+            written = written && write_all(file, &sections[n][0],
+                sections[n].size(), table[n].offset);
+    written = written && (fsync(file) == 0);
+    close(file);
+    if (not(written) || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw CheckpointException("couldn't write " + path);
+    }
+}
+
+// = CheckpointReader =
+mgrid::CheckpointReader::CheckpointReader(const std::string& path):
+    path(path),
+    file(open(path.c_str(), O_RDONLY))
+{
+    if (file < 0) throw CheckpointException("couldn't open " + path);
+
+    // Check that we can read this file before reading the section table
+    CheckpointHeader header;
+    if (not(read_all(file, &header, sizeof(header), 0))
+        || std::memcmp(header.magic, checkpointMagic, sizeof(header.magic)))
+    {
+        close(file);
+        throw CheckpointException(path + " isn't a checkpoint file");
+    }
+    if (header.version != checkpointVersion
+        || header.byteOrder != checkpointByteOrder)
+    {
+        close(file);
+        throw CheckpointException(path
+            + " was written by a different version or kind of machine");
+    }
+    sections.resize(header.numberOfSections);
+    if (not(sections.empty()) && not(read_all(file, &sections[0],
+        sections.size()*sizeof(CheckpointSection), sizeof(header))))
+    {
+        close(file);
+        throw CheckpointException(path + " is truncated");
+    }
+
+    // Every section has to be in the file, or mapping it would give a bus
+    // error on first access rather than an exception
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        close(file);
+        throw CheckpointException("couldn't open " + path);
+    }
+    const boost::uint64_t fileBytes = status.st_size;
+    foreach(const CheckpointSection& section, sections) {
+        if (section.offset > fileBytes
+            || section.bytes > fileBytes - section.offset)
+        {
+            close(file);
+            throw CheckpointException(path + " is truncated");
+        }
+    }
+}
+mgrid::CheckpointReader::~CheckpointReader() {
+    close(file);
+}
+
+// Sections
+const mgrid::CheckpointSection& mgrid::CheckpointReader::_section(
+    const std::string& name)
+{
+    foreach(const CheckpointSection& section, sections)
+        if (name == section.name) return section;
+    throw CheckpointException(path + " has no " + name + " section");
+}
+bool mgrid::CheckpointReader::has_section(const std::string& name) {
+    foreach(const CheckpointSection& section, sections)
+        if (name == section.name) return true;
+    return false;
+}
+std::size_t mgrid::CheckpointReader::section_bytes(const std::string& name) {
+    return _section(name).bytes;
+}
+void mgrid::CheckpointReader::read(const std::string& name, void* data,
+    const std::size_t bytes)
+{
+    const CheckpointSection& section = _section(name);
+    if (bytes != section.bytes)
+        throw CheckpointException("the " + name + " section of " + path
+            + " is the wrong size");
+    if (not(read_all(file, data, bytes, section.offset)))
+        throw CheckpointException(path + " is truncated");
+}
+boost::shared_ptr<mgrid::Arena> mgrid::CheckpointReader::map(
+    const std::string& name)
+{
+    // Map the section if we can, or read it into a new arena if not (e.g.
+    // on file systems which can't be mapped)
+    const CheckpointSection& section = _section(name);
+    const std::size_t numberOfDoubles = section.bytes/sizeof(double);
+    try {
+        return boost::shared_ptr<Arena>(
+            new Arena(file, section.offset, numberOfDoubles));
+    } catch (std::bad_alloc&) {
+        boost::shared_ptr<Arena> result(new Arena(numberOfDoubles));
+        read(name, result->data(), section.bytes);
+        return result;
+    }
+}
@@ -0,0 +1,124 @@
+/*
+    checkpoint.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Binary checkpoint files, which hold a solver's state so that a long
+    solve can be restarted where it left off.
+*/
+
+#ifndef CHECKPOINT_HPP_W3PV8K1D
+#define CHECKPOINT_HPP_W3PV8K1D
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "utilities.hpp"
+#include "arena.hpp"
+
+namespace mgrid {
+
+// = Checkpoint file format =
+/*  A checkpoint file is made up of:
+    -- a CheckpointHeader, holding the magic string "MGRIDCKP", the format
+       version, a byte order mark and the number of sections.
+    -- a CheckpointSection for each section, holding its name and where it
+       is in the file.
+    -- the sections themselves, which are raw bytes in the byte order of
+       the machine that wrote them. Each starts on a multiple of
+       checkpointAlignment bytes (which is a multiple of any page size), so
+       that a Stack's arena can be mapped straight back into memory.
+    Files with a different version or byte order are rejected rather than
+    converted. Bump checkpointVersion whenever the layout of a section
+    changes.
+*/
+const char checkpointMagic[8] = {'M', 'G', 'R', 'I', 'D', 'C', 'K', 'P'};
+const boost::uint32_t checkpointVersion = 1;
+const boost::uint32_t checkpointByteOrder = 0x01020304;
+const std::size_t checkpointAlignment = 65536;
+const std::size_t checkpointNameLength = 48;
+
+struct CheckpointHeader {
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t byteOrder;
+    boost::uint64_t numberOfSections;
+};
+struct CheckpointSection {
+    char name[checkpointNameLength];
+    boost::uint64_t offset;             // From the start of the file
+    boost::uint64_t bytes;
+};
+
+// = CheckpointWriter class interface =
+/*  Collects copies of the sections of a checkpoint in memory, so that the
+    solver can carry on while they're written (e.g. from an OutputQueue).
+    write goes to a temporary file which is renamed over the old checkpoint
+    once it's complete, so a crash while writing leaves the last checkpoint
+    intact. Errors are reported as CheckpointExceptions.
+*/
+class CheckpointWriter: private boost::noncopyable {
+public:
+    // Add a copy of the given bytes as a section
+    void add(const std::string& name, const void* data,
+        const std::size_t bytes);
+    template <typename T> inline void add(const std::string& name,
+        const std::vector<T>& values);
+
+    // Write the file
+    void write(const std::string& path);
+
+private:
+    std::vector<std::string> names;
+    std::vector<std::vector<char> > sections;
+};
+
+// = CheckpointReader class interface =
+/*  Opens a checkpoint file and reads its section table. Sections can be
+    read into memory that's already there, or (for big sections) mapped
+    into a new Arena. Mapped arenas are copy-on-write, so changing them
+    doesn't change the file, and they can outlive the reader. Errors (a
+    missing file or section, or the wrong version) are reported as
+    CheckpointExceptions.
+*/
+class CheckpointReader: private boost::noncopyable {
+public:
+    CheckpointReader(const std::string& path);
+    ~CheckpointReader();
+
+    // Sections
+    bool has_section(const std::string& name);
+    std::size_t section_bytes(const std::string& name);
+    void read(const std::string& name, void* data, const std::size_t bytes);
+    template <typename T> inline void read(const std::string& name,
+        std::vector<T>& values);
+    boost::shared_ptr<Arena> map(const std::string& name);
+
+private:
+    const CheckpointSection& _section(const std::string& name);
+
+    const std::string path;
+    int file;
+    std::vector<CheckpointSection> sections;
+};
+
+// = Inline methods =
+template <typename T> inline void CheckpointWriter::add(
+    const std::string& name, const std::vector<T>& values)
+{
+    add(name, values.empty() ? 0 : &values[0], values.size()*sizeof(T));
+}
+template <typename T> inline void CheckpointReader::read(
+    const std::string& name, std::vector<T>& values)
+{
+    values.resize(section_bytes(name)/sizeof(T));
+    read(name, values.empty() ? 0 : &values[0], values.size()*sizeof(T));
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: CHECKPOINT_HPP_W3PV8K1D */
@@ -0,0 +1,126 @@
+/*
+    main.cpp (distributed_poisson)
+    Jess Robertson, 2026-10-19
+    
+    Driver for the distributed Poisson example. Run with, e.g.
+        mpirun -np 4 ./distributed_poisson --grids 10 --compare
+*/ 
+
+#include <multigrid/multigrid.hpp>
+#include <boost/program_options.hpp>     
+#include "poisson.hpp"                  
+
+using namespace mgrid;   
+using namespace std;
+namespace bpo = boost::program_options; 
+
+// Solve on the first process only, and check the distributed solution 
+// against it point by point
+void compare_with_serial(const Settings& settings, DistributedPoisson& problem) 
+{
+    DistributedStack& solution = problem.get_solution();
+    const Level finest = solution.finestLevel;
+    const int nx = solution.global_rows(finest);
+    const int nz = solution.global_columns(finest);
+    
+    // Solve serially and share the result
+    blitz::Array<double, 2> serialResult(nx, nz);
+    double serialNorm = 0;
+    if (solution.rank == 0) {
+        SerialPoisson serial(settings);
+        serial.solve();
+        serialResult = serial.get_result();
+        serialNorm = serial.get_result().norm();
+    }
+    MPI_Bcast(serialResult.data(), nx*nz, MPI_DOUBLE, 0, 
+        solution.communicator());
+    
+    // Largest difference over the points we own
+    double maxDifference = 0;
+    if (solution.is_active(finest)) {
+        FDArray& u = solution[finest];
+        for (int i=solution.first(finest, 0); i<solution.last(finest, 0); i++)
+            for (int j=solution.first(finest, 1); 
+                 j<solution.last(finest, 1); j++) 
+            {
+                const int gi = i + solution.offset(finest, 0);
+                const int gj = j + solution.offset(finest, 1);
+                maxDifference = max(maxDifference, 
+                    fabs(u(i, j) - serialResult(gi, gj)));
+            }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &maxDifference, 1, MPI_DOUBLE, MPI_MAX, 
+        solution.communicator());
+    const double distributedNorm = problem.norm();
+    if (solution.rank == 0) {
+        Message msg(StatusMessage);
+        msg.precision(15);
+        msg << "Serial norm " << serialNorm << ", distributed norm " 
+            << distributedNorm << ", largest difference " 
+            << maxDifference << std::endl;
+        std::cout << msg.str();
+    }
+}
+
+int main (int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int status = 0;
+    try{
+        // Set up command-line options
+        Settings settings;
+        bpo::options_description 
+            visibleOptions("Usage mpirun -np <N> ./distributed_poisson\n\nOptions:");
+        visibleOptions.add_options() 
+            ("help", "prints this help message")
+            ("aspect", bpo::value<double>(&settings.aspectRatio)->
+                default_value(settings.aspectRatio), "aspect ratio")
+            ("grids", bpo::value<int>(&settings.numberOfGrids)->
+                default_value(settings.numberOfGrids), "number of grids")
+            ("resolution", bpo::value<int>(&settings.minimumResolution)->
+                default_value(6), "resolution of coarsest grid")
+            ("agglomerate", bpo::value<int>(&settings.agglomerationSize)->
+                default_value(settings.agglomerationSize), 
+                "smallest block size before coarse grids are gathered")
+            ("compare", "check against the serial solver")
+            ("write", "write out each process's block");
+        
+        // Parse command line variables, pass to variable map  
+        bpo::variables_map varMap;
+        bpo::store(bpo::parse_command_line(argc, argv, visibleOptions), varMap);
+        bpo::notify(varMap);
+        
+        // Check for help flag
+        if (varMap.count("help")) {
+            if (rank == 0) std::cout << visibleOptions << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+        
+        // Solve problem
+        {
+            DistributedPoisson problem(settings);
+            const double startTime = MPI_Wtime();
+            problem.solve();
+            const double solveTime = MPI_Wtime() - startTime;
+            const double norm = problem.norm();
+            if (rank == 0) {
+                Message msg(StatusMessage);
+                msg.precision(15);
+                msg << "Solved in " << solveTime << "s, norm " << norm 
+                    << std::endl;
+                std::cout << msg.str();
+            }
+            if (varMap.count("compare")) 
+                compare_with_serial(settings, problem);
+            if (varMap.count("write")) problem.write(1, "poisson_");
+        }
+        
+    } catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+        status = 1;
+    }      
+    MPI_Finalize();
+    return status;
+}
@@ -0,0 +1,44 @@
+/*
+    poisson.cpp (distributed_poisson)
+    Jess Robertson, 2026-10-19
+
+    Setup for Poisson classes
+*/                                 
+
+#include "poisson.hpp"    
+
+using namespace mgrid;
+
+// Boundary conditions and source as in the Poisson example
+DistributedPoisson::DistributedPoisson(const Settings& settings): 
+    DistributedLinearMultigrid::DistributedLinearMultigrid(settings) 
+{
+    solution.boundaryConditions.set(leftBoundary,   zeroNeumannCondition);
+    solution.boundaryConditions.set(rightBoundary,  zeroDirichletCondition);
+    solution.boundaryConditions.set(topBoundary,    zeroNeumannCondition);    
+    solution.boundaryConditions.set(bottomBoundary, zeroDirichletCondition); 
+    source_term(-1.0);
+}    
+SerialPoisson::SerialPoisson(const Settings& settings): 
+    LinearMultigrid::LinearMultigrid(settings) 
+{
+    solution.boundaryConditions.set(leftBoundary,   zeroNeumannCondition);
+    solution.boundaryConditions.set(rightBoundary,  zeroDirichletCondition);
+    solution.boundaryConditions.set(topBoundary,    zeroNeumannCondition);    
+    solution.boundaryConditions.set(bottomBoundary, zeroDirichletCondition); 
+    source_term(-1.0);
+}    
+
+// Filename generators
+std::string DistributedPoisson::filename(std::string root) {
+    std::ostringstream name;  
+    name.precision(1);  // Print variables to one decimal place
+    name << root << "A" << std::fixed << aspect; 
+    return name.str();
+} 
+std::string SerialPoisson::filename(std::string root) {
+    std::ostringstream name;  
+    name.precision(1);
+    name << root << "A" << std::fixed << aspect; 
+    return name.str();
+} 
@@ -0,0 +1,80 @@
+/*
+    poisson.hpp (distributed_poisson)
+    Jess Robertson, 2026-10-19
+    
+    Poisson problem solved across MPI processes, and the same problem solved
+    on one process for comparison.
+*/
+
+#ifndef POISSON_HPP_7GJ2X0QD
+#define POISSON_HPP_7GJ2X0QD    
+
+#include <multigrid/multigrid.hpp>
+#include <multigrid/multigrid_distributed.hpp>
+
+// = DistributedPoisson class interface =
+class DistributedPoisson: public mgrid::DistributedLinearMultigrid {
+public:
+    DistributedPoisson(const mgrid::Settings& settings);  
+    virtual ~DistributedPoisson() {};
+    
+    // Differential operators act on this process's block
+    virtual inline double differential_operator(mgrid::Level level, int i, int j); 
+    virtual inline void relaxation_updater(mgrid::Level level, int i, int j);   
+    
+    // Filename generator
+    virtual std::string filename(std::string root="");  
+}; 
+
+// = SerialPoisson class interface =
+class SerialPoisson: public mgrid::LinearMultigrid {
+public:
+    SerialPoisson(const mgrid::Settings& settings);  
+    virtual ~SerialPoisson() {};
+    
+    // Differential operators
+    virtual inline double differential_operator(mgrid::Level level, int i, int j); 
+    virtual inline void relaxation_updater(mgrid::Level level, int i, int j);   
+    
+    // Filename generator
+    virtual std::string filename(std::string root="");  
+}; 
+
+// = Inline functions =     
+// Differential operators are the same for both
+inline double DistributedPoisson::differential_operator(mgrid::Level level, 
+    int i, int j) 
+{
+    return solution[level].dxx(i, j) + solution[level].dzz(i, j);
+};
+inline void DistributedPoisson::relaxation_updater(mgrid::Level level, 
+    int i, int j) 
+{ 
+    const double hx = solution[level].spacing(0);
+    const double hz = solution[level].spacing(1);
+    const double xxfactor = 1/(hx*hx);
+    const double zzfactor = 1/(hz*hz);
+    solution[level](i, j) = 
+        ((solution[level](i+1, j) + solution[level](i-1, j))*xxfactor
+        + (solution[level](i, j+1) + solution[level](i, j-1))*zzfactor 
+        - source[level](i, j))/(2*(xxfactor + zzfactor));
+};  
+inline double SerialPoisson::differential_operator(mgrid::Level level, 
+    int i, int j) 
+{
+    return solution[level].dxx(i, j) + solution[level].dzz(i, j);
+};
+inline void SerialPoisson::relaxation_updater(mgrid::Level level, 
+    int i, int j) 
+{ 
+    const double hx = solution[level].spacing(0);
+    const double hz = solution[level].spacing(1);
+    const double xxfactor = 1/(hx*hx);
+    const double zzfactor = 1/(hz*hz);
+    solution[level](i, j) = 
+        ((solution[level](i+1, j) + solution[level](i-1, j))*xxfactor
+        + (solution[level](i, j+1) + solution[level](i, j-1))*zzfactor 
+        - source[level](i, j))/(2*(xxfactor + zzfactor));
+};  
+
+#endif /* end of include guard: POISSON_HPP_7GJ2X0QD */
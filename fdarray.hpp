@@ -13,6 +13,8 @@
 #include <boost/bind.hpp>  
 
 #include "fdbase.hpp"  
+#include "fdview.hpp"
+#include "reduction.hpp"
 #include "boundary_conditions.hpp"
 
 namespace mgrid {
@@ -33,11 +35,27 @@ public:
     // Override base methods for array resizing and referencing
     inline virtual 
         void resize(const double aspectRatio, const int nx, const int nz);    
+    inline virtual 
+        void resize_block(const double hx, const double hz, const int nx, 
+            const int nz);
+    inline virtual 
+        void resize_in(double* memory, const int rowStride, 
+            const double aspectRatio, const int nx, const int nz);
     inline virtual 
         void reference(blitz::Array<double, 2> array);     
     inline virtual 
         void reference(FDArray array);       
 
+    // Non-owning view of the data for kernels, which is also used to pass 
+    // FDArrays to functions taking FDViews
+    inline FDView view();
+    inline operator FDView() { return view(); }
+
+    // Views of other arrays with the same shape (or a component of a vector
+    // array) with the geometry of this one, e.g. for results of kernels
+    inline FDView view(ArrayType& array);
+    inline FDView view(VecArrayType& array, const int component);
+
     // Gradient etc...
     void gradient(VecArrayType& result);       
     void gradient_magnitude(ArrayType& result);   
@@ -45,8 +63,10 @@ public:
     // Integration
     double calculate_flux();  
 
-    // Add a simple function to calculate the Frobenius norm of an array
+    // Add a simple function to calculate the Frobenius norm of an array, and 
+    // the largest absolute value (see reduction.hpp)
     inline double norm();
+    inline double max_norm();
 
     // Explicitly inherit operators from blitz::Array, since 
     // these are not inherited by default.          
@@ -95,6 +115,28 @@ inline void FDArray::resize(const double aspectRatio, const int nx, const int nz
     blitz::Array<double, 2>::resize(nx, nz);
     boundaryConditions.resize(nx, nz);        
 }      
+inline void FDArray::resize_block(const double hx, const double hz, 
+    const int nx, const int nz) 
+{
+    // One block of a larger grid, e.g. for domain decomposition. Derivatives
+    // are one-sided on the edges of the block, so the block should either 
+    // end on the edge of the grid or have a halo of points around it.
+    calculate_block_geometry(hx, hz, nx, nz);
+    blitz::Array<double, 2>::resize(nx, nz);
+    boundaryConditions.resize(nx, nz);        
+}
+inline void FDArray::resize_in(double* memory, const int rowStride, 
+    const double aspectRatio, const int nx, const int nz) 
+{
+    // Use memory owned by someone else (e.g. a Stack's arena), with rows 
+    // rowStride apart. The memory must outlive this array and any references
+    // to it, and isn't initialised.
+    calculate_geometry(aspectRatio, nx, nz);
+    blitz::Array<double, 2>::reference(blitz::Array<double, 2>(memory, 
+        blitz::shape(nx, nz), blitz::shape(rowStride, 1), 
+        blitz::neverDeleteData));
+    boundaryConditions.resize(nx, nz);        
+}
 inline void FDArray::reference(FDArray referent) {
     calculate_geometry(referent.aspectRatio, referent.rows(), referent.columns());
     boundaryConditions.reference(referent.boundaryConditions);
@@ -104,6 +146,18 @@ inline void FDArray::reference(blitz::Array<double, 2> referent) {
     blitz::Array<double, 2>::reference(referent);
 }      
 
+inline FDView FDArray::view() {
+    return FDView(data(), rows(), columns(), stride(0), stride(1), hx, hz);
+}
+inline FDView FDArray::view(ArrayType& array) {
+    return FDView(array.data(), array.rows(), array.columns(), 
+        array.stride(0), array.stride(1), hx, hz);
+}
+inline FDView FDArray::view(VecArrayType& array, const int component) {
+    return FDView(&array(0, 0, component), array.extent(0), array.extent(1), 
+        array.stride(0), array.stride(1), hx, hz);
+}
+
 // Overloaded array operators for FDArray
 inline FDArray& FDArray::operator=(const FDArray& x) {
     using namespace blitz;
@@ -347,29 +401,27 @@ inline double FDArray::dxzu(const int i, const int j) {
 
 // Array-wide derivatives methods
 inline void FDArray::dx(ArrayType& result) {
-    ARRAY_LOOP((*this)) 
-        result(i, j) = (*this).dx(i, j);
+    view().dx(view(result));
 }
 inline void FDArray::dz(ArrayType& result) {
-    ARRAY_LOOP((*this)) 
-        result(i, j) = (*this).dz(i, j);
+    view().dz(view(result));
 }
 inline void FDArray::dxx(ArrayType& result) {
-    ARRAY_LOOP((*this)) 
-        result(i, j) = (*this).dxx(i, j);
+    view().dxx(view(result));
 }
 inline void FDArray::dzz(ArrayType& result) {
-    ARRAY_LOOP((*this)) 
-        result(i, j) = (*this).dzz(i, j);
+    view().dzz(view(result));
 }
 inline void FDArray::dxz(ArrayType& result) {
-    ARRAY_LOOP((*this)) 
-        result(i, j) = (*this).dxz(i, j);
+    view().dxz(view(result));
 }
 
 // Other inline functions
 inline double FDArray::norm() {
-    return sqrt(blitz::sum((*this)*(*this))/blitz::dot(shape(), shape()));
+    return sqrt(sum_of_squares(view())/blitz::dot(shape(), shape()));
+}
+inline double FDArray::max_norm() {
+    return mgrid::max_norm(view());
 }       
 
 } // end namespace mgrid
@@ -21,4 +21,19 @@ void mgrid::FDBase::calculate_geometry(const double aspectRatio, const int nx, c
     xfactor = 1.0/(2*hx);       zfactor = 1.0/(2*hz);
     xxfactor = 1.0/(hx*hx);     zzfactor = 1.0/(hz*hz);
     xzfactor = 1.0/(4*hx*hz);         
-}   
+}
+void mgrid::FDBase::calculate_block_geometry(const double hx, const double hz, 
+    const int nx, const int nz) 
+{
+    // Copy over data
+    (*this).nx = nx; 
+    (*this).nz = nz;
+    (*this).hx = hx;
+    (*this).hz = hz;
+    aspectRatio = hx*(nx-1);
+    
+    // Pre-calculate factors for derivatives   
+    xfactor = 1.0/(2*hx);       zfactor = 1.0/(2*hz);
+    xxfactor = 1.0/(hx*hx);     zzfactor = 1.0/(hz*hz);
+    xzfactor = 1.0/(4*hx*hz);         
+}
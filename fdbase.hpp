@@ -23,6 +23,10 @@ public:
     // Function to calculate spacing and resolution
     void calculate_geometry(const double aspectRatio, const int nx, const int nz);
     
+    // As above, for a block of a larger grid with the given spacing
+    void calculate_block_geometry(const double hx, const double hz, 
+        const int nx, const int nz);
+    
     // Override base methods for array resizing
     virtual void resize(double aspectRatio, const int nx, const int nz)=0; 
         
@@ -31,6 +35,7 @@ public:
         if (n == 0) return hx;
         else return hz; 
     }   
+    inline const double aspect_ratio() { return aspectRatio; }
                     
 protected:
     // Geometry attributes
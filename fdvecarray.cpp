@@ -4,6 +4,7 @@
 */                            
 
 #include "fdvecarray.hpp"
+#include "output.hpp"
 
 // Ctor   
 mgrid::FDVecArray::FDVecArray(const double aspectRatio, const int nx, const int nz): 
@@ -22,20 +23,19 @@ mgrid::FDVecArray::FDVecArray(const double aspectRatio, const int nx, const int
 // Write method
 void mgrid::FDVecArray::write(std::string fileString) {
     fileString.append(".nc");   // Add suffix to filename
-    std::auto_ptr<NcFile> file(new NcFile(fileString.c_str(), NcFile::Replace));
+    const OutputSettings settings;
+    std::auto_ptr<NcFile> file = open_output_file(fileString, settings);
     if (file->is_valid()) {
         // Define and add dimentions and variable
         NcDim* xDim = file->add_dim("x", nx);
         NcDim* zDim = file->add_dim("z", nz); 
-        NcVar* xComp = file->add_var("u_x", ncDouble, xDim, zDim);
-        NcVar* zComp = file->add_var("u_z", ncDouble, xDim, zDim);
+        NcVar* xComp = add_field(*file, "u_x", xDim, zDim, settings);
+        NcVar* zComp = add_field(*file, "u_z", xDim, zDim, settings);
         
-        // Push data to file - data copied to ensure its contiguous and double
-        // prescision, since NetCDF doesn't like anything bigger than a double
-        blitz::Array<double, 2> xValues = (*this).first.copy();    
-        blitz::Array<double, 2> zValues = (*this).second.copy();
-        xComp->put(&xValues(0,0), nx, nz);        
-        zComp->put(&zValues(0,0), nx, nz);
+        // Push each component to file a block of rows at a time, since the 
+        // components are interleaved
+        put_field(xComp, first.view(), settings);
+        put_field(zComp, second.view(), settings);
     }
 }
 
@@ -45,6 +45,5 @@ void mgrid::FDVecArray::magnitude(ArrayType& result) {
         result(i, j) = sqrt(power<2>((*this)(i, j, 0)) + power<2>((*this)(i, j, 1)));                 
 }  
 void mgrid::FDVecArray::divergence(ArrayType& result) { 
-    ARRAY_LOOP(result) 
-        result(i, j) = first.dx(i, j) + second.dz(i, j);
+    mgrid::divergence(first, second, first.view(result));
 }
\ No newline at end of file
@@ -34,6 +34,9 @@ public:
     void magnitude(ArrayType& result);
     void divergence(ArrayType& result);    
     
+    // Frobenius norm, as for FDArray
+    inline double norm();
+    
     // Writing method
     void write(std::string filestring);        
     
@@ -73,6 +76,10 @@ inline void FDVecArray::reference(blitz::Array<double, 3> array) {
     blitz::Array<double, 3>::reference(array);
 }
 
+inline double FDVecArray::norm() {
+    return sqrt(sum_of_squares(first, second)/(nx*nx + nz*nz));
+}
+
 // Overloaded operators for FDVecArray  
 inline FDVecArray& FDVecArray::operator=(const FDVecArray& x) {
     using namespace blitz;
@@ -0,0 +1,354 @@
+/*
+    fdview.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Lightweight non-owning view of a two-dimensional array, for kernels
+*/
+
+#ifndef FDVIEW_HPP_6RW4NC1J
+#define FDVIEW_HPP_6RW4NC1J
+
+#include <math.h>
+#include <algorithm>
+
+#include "types.hpp"
+#include "kernels.hpp"
+
+namespace mgrid {
+
+// = FDView class interface =
+/*  An FDView is just a pointer to the first point, the strides and extents,
+    and the derivative factors of the array it looks at, so it's trivially
+    copyable and cheap to pass by value - unlike an FDArray, which carries a
+    reference count and boundary conditions around with it. Kernels should
+    take FDViews, and get them from FDArray::view() (or by passing an FDArray,
+    which converts implicitly).
+
+    A view doesn't own its data, so it must not outlive the array it came
+    from. Assigning one view to another rebinds it rather than copying
+    elements.
+
+    block gives a view of part of the array (e.g. a tile for one thread),
+    indexed from the corner of the block. Derivatives in a block use the same
+    one-sided differences as the whole array at the edges of the whole array,
+    and centred differences everywhere else, so they match the derivatives of
+    the whole array as long as the block has a halo of one point (or ends on
+    the edge of the array). The array-wide centred differences in x and z
+    are worked out a row at a time by the kernels in kernels.hpp.
+*/
+class FDView {
+public:
+    FDView(): origin(0), nx(0), nz(0), xStride(0), zStride(0),
+        iFirst(0), iLast(-1), jFirst(0), jLast(-1),
+        hx(0), hz(0), xfactor(0), zfactor(0), xxfactor(0), zzfactor(0),
+        xzfactor(0) {};
+    inline FDView(double* origin, const int nx, const int nz,
+        const int xStride, const int zStride, const double hx,
+        const double hz);
+
+    // Element access
+    inline double& operator()(const int i, const int j) const {
+        return origin[i*xStride + j*zStride];
+    }
+    inline double* data() const { return origin; }
+    inline int rows() const { return nx; }
+    inline int columns() const { return nz; }
+    inline int stride(const int n) const { return n == 0 ? xStride : zStride; }
+    inline double spacing(const int n) const { return n == 0 ? hx : hz; }
+
+    // Sub-views
+    inline FDView block(const int i, const int j, const int nx,
+        const int nz) const;
+
+    // Derivatives methods, as for FDArray
+    inline double dx(const int i, const int j) const;
+    inline double dz(const int i, const int j) const;
+    inline double dxx(const int i, const int j) const;
+    inline double dzz(const int i, const int j) const;
+    inline double dxz(const int i, const int j) const;
+
+    // Array-wide derivative methods, which write to a view of the same shape.
+    // These run branch-free centred differences over the interior, and only
+    // use the per-point methods above on the edges, so the results are the
+    // same as calling them at every point.
+    inline void dx(const FDView& result) const;
+    inline void dz(const FDView& result) const;
+    inline void dxx(const FDView& result) const;
+    inline void dzz(const FDView& result) const;
+    inline void dxz(const FDView& result) const;
+    inline void gradient_magnitude(const FDView& result) const;
+
+private:
+    double* origin;
+    int nx, nz, xStride, zStride;
+    int iFirst, iLast, jFirst, jLast;     // Edges of the whole array
+    double hx, hz;
+    double xfactor, zfactor;              // Denominators (like 1/hx) used
+    double xxfactor, zzfactor, xzfactor;  // for calculating derivatives
+
+    // Centred differences, used away from the edges
+    inline double _centred_dx(const int i, const int j) const {
+        return ((*this)(i-1,j) - (*this)(i+1,j))*xfactor;
+    }
+    inline double _centred_dz(const int i, const int j) const {
+        return -((*this)(i,j+1) - (*this)(i,j-1))*zfactor;
+    }
+
+    // Rows and columns of the view where centred differences are used
+    inline int _first_interior_row() const { return std::max(0, iFirst+1); }
+    inline int _end_interior_row() const { return std::min(nx, iLast); }
+    inline int _first_interior_column() const { return std::max(0, jFirst+1); }
+    inline int _end_interior_column() const { return std::min(nz, jLast); }
+
+    // Apply a per-point method everywhere outside the given interior
+    typedef double (FDView::*PointMethod)(const int, const int) const;
+    inline void _apply_edges(const FDView& result, PointMethod method,
+        const int i0, const int i1, const int j0, const int j1) const;
+
+    friend inline void divergence(const FDView& first, const FDView& second,
+        const FDView& result);
+};
+
+// Divergence of the vector field with the given components (which should
+// have the same shape)
+inline void divergence(const FDView& first, const FDView& second,
+    const FDView& result);
+
+// Ctor
+inline FDView::FDView(double* origin, const int nx, const int nz,
+    const int xStride, const int zStride, const double hx, const double hz):
+    origin(origin), nx(nx), nz(nz), xStride(xStride), zStride(zStride),
+    iFirst(0), iLast(nx-1), jFirst(0), jLast(nz-1), hx(hx), hz(hz)
+{
+    // Pre-calculate factors for derivatives (as in FDBase)
+    xfactor = 1.0/(2*hx);       zfactor = 1.0/(2*hz);
+    xxfactor = 1.0/(hx*hx);     zzfactor = 1.0/(hz*hz);
+    xzfactor = 1.0/(4*hx*hz);
+}
+
+// Sub-views
+inline FDView FDView::block(const int i, const int j, const int nx,
+    const int nz) const
+{
+    FDView result = (*this);
+    result.origin = &(*this)(i, j);
+    result.nx = nx;
+    result.nz = nz;
+    result.iFirst -= i;
+    result.iLast -= i;
+    result.jFirst -= j;
+    result.jLast -= j;
+    return result;
+}
+
+// FDView derivatives calculation methods - these are the same differences
+// as the FDArray methods
+inline double FDView::dx(const int i, const int j) const {
+    const FDView& u = (*this);
+    if (i == iFirst) {
+        // forward difference in i
+        return (3*u(i,j) - 4*u(i+1,j) + u(i+2,j))*xfactor;
+    } else if (i == iLast) {
+        // backward difference in i
+        return (-u(i-2,j) + 4*u(i-1,j) - 3*u(i,j))*xfactor;
+    } else {
+        // centered difference in i
+        return u._centred_dx(i, j);
+    }
+}
+inline double FDView::dz(const int i, const int j) const {
+    const FDView& u = (*this);
+    if (j == jFirst) {
+        // forward difference in j
+        return (-4*u(i,j+1) + 3*u(i,j) + u(i,j+2))*zfactor;
+    } else if (j == jLast) {
+        // backward difference in j
+        return (-u(i,j-2) + 4*u(i,j-1) - 3*u(i,j))*zfactor;
+    } else {
+        // centered difference in j
+        return u._centred_dz(i, j);
+    }
+}
+inline double FDView::dxx(const int i, const int j) const {
+    const FDView& u = (*this);
+    if (i == iFirst) {
+        // forward difference in i
+        return (-u(i+3,j) + 4*u(i+2,j) - 5*u(i+1,j) + 2*u(i,j))*xxfactor;
+    } else if (i == iLast) {
+        // backward difference in i
+        return (-u(i-3,j) + 4*u(i-2,j) - 5*u(i-1,j) + 2*u(i,j))*xxfactor;
+    } else {
+        // centered difference in i
+        return (u(i-1,j) - 2*u(i,j) + u(i+1,j))*xxfactor;
+    }
+}
+inline double FDView::dzz(const int i, const int j) const {
+    const FDView& u = (*this);
+    if (j == jFirst) {
+        // forward difference in j
+        return (-u(i,j+3) + 4*u(i,j+2) - 5*u(i,j+1) + 2*u(i,j))*zzfactor;
+    } else if (j == jLast) {
+        // backward difference in j
+        return (-u(i,j-3) + 4*u(i,j-2) - 5*u(i,j-1) + 2*u(i,j))*zzfactor;
+    } else {
+        // centered difference in j
+        return (u(i,j-1) - 2*u(i,j) + u(i,j+1))*zzfactor;
+    }
+}
+inline double FDView::dxz(const int i, const int j) const {
+    const FDView& u = (*this);
+    if (j == jFirst) {
+        if (i == iFirst) {
+            // forward difference in i, forward difference in j
+            return (16*u(i+1,j+1) - 12*(u(i+1,j) + u(i,j+1))
+                + 9*u(i,j) - 4*(u(i+1,j+2) + u(i+2,j+1))
+                + 3*(u(i+2,j) + u(i,j+2)) + u(i+2,j+2))*xzfactor;
+        } else if (i == iLast) {
+            // backward difference in i, forward difference in j
+            return (-16*u(i-1,j+1) + 12*(u(i-1,j) + u(i,j+1))
+                - 9*u(i,j) + 4*(u(i-1,j+2) + u(i-2,j+1))
+                - 3*(u(i-2,j) - u(i,j+2)) - u(i-2,j+2))*xzfactor;
+        } else {
+            // centered difference in i, forward difference in j
+            return (4*(u(i+1,j+1) - u(i-1,j+1))
+                + 3*(u(i-1,j) - u(i+1,j)) + u(i-1,j+2)
+                - u(i+1,j+2))*xzfactor;
+        }
+    } else if (j == jLast) {
+        if (i == iFirst) {
+            // forward difference in i, backward difference in j
+            return (-16*u(i+1,j-1) + 12*(u(i+1,j) + u(i,j-1))
+                - 9*u(i,j) + 4*(u(i+2,j-1) + u(i+1,j-2))
+                - 3*(u(i+2,j) + u(i,j-2)) - u(i+2,j-2))*xzfactor;
+        } else if (i == iLast) {
+            // backward difference in i, backward difference in j
+            return (16*u(i-1,j-1) - 12*(u(i-1,j) + u(i,j-1))
+                + 9*u(i,j) - 4*(u(i-1,j-2) + u(i-2,j-1))
+                + 3*(u(i-2,j) + u(i,j-2)) + u(i-2,j-2))*xzfactor;
+        } else {
+            // centered difference in i, backward difference in j
+            return (4*(u(i-1,j-1) - u(i+1,j-1))
+                + 3*(u(i+1,j) - u(i-1,j))
+                - u(i-1,j-2) + u(i+1,j-2))*xzfactor;
+        }
+    } else {
+        if (i == iFirst) {
+            // forward difference in i, centered difference in j
+            return (3*(u(i,j-1) - u(i,j+1))
+                - 4*(u(i+1,j-1) - u(i+1,j+1))
+                + u(i+2,j-1) - u(i+2,j+1))*xzfactor;
+        } else if (i == iLast) {
+            // backward difference in i, centered difference in j
+            return (3*(u(i,j+1) - u(i,j-1))
+                - 4*(u(i-1,j+1) - u(i-1,j-1))
+                + u(i-2,j+1) - u(i-2,j-1))*xzfactor;
+        } else {
+            // centered difference in i, centered difference in j
+            return (u(i-1,j-1) - u(i-1,j+1) - u(i+1,j-1)
+                + u(i+1,j+1))*xzfactor;
+        }
+    }
+}
+
+// Array-wide derivatives methods
+inline void FDView::_apply_edges(const FDView& result, PointMethod method,
+    const int i0, const int i1, const int j0, const int j1) const
+{
+    for (int i=0; i < nx; i++) {
+        // Columns before and after the interior, which is all of them on 
+        // the edge rows
+        const bool interiorRow = (i >= i0 && i < i1);
+        const int before = interiorRow ? j0 : nz, after = interiorRow ? j1 : nz;
+        for (int j=0; j < before; j++) 
+            result(i, j) = (this->*method)(i, j);
+        for (int j=std::max(after, before); j < nz; j++) 
+            result(i, j) = (this->*method)(i, j);
+    }
+}
+inline void FDView::dx(const FDView& result) const {
+    const KernelTable& k = kernels();
+    const int i0 = _first_interior_row(), i1 = _end_interior_row();
+    for (int i=i0; i < i1; i++)
+        k.centred_difference_across(&(*this)(i-1, 0), &(*this)(i+1, 0),
+            zStride, &result(i, 0), result.zStride, nz, xfactor);
+    _apply_edges(result, &FDView::dx, i0, i1, 0, nz);
+}
+inline void FDView::dz(const FDView& result) const {
+    const KernelTable& k = kernels();
+    const int j0 = _first_interior_column(), j1 = _end_interior_column();
+    for (int i=0; i < nx; i++)
+        k.centred_difference_along(&(*this)(i, j0), zStride, &result(i, j0),
+            result.zStride, j1 - j0, zfactor);
+    _apply_edges(result, &FDView::dz, 0, nx, j0, j1);
+}
+inline void FDView::dxx(const FDView& result) const {
+    const FDView& u = (*this);
+    const KernelTable& k = kernels();
+    const int i0 = _first_interior_row(), i1 = _end_interior_row();
+    for (int i=i0; i < i1; i++)
+        k.second_difference_across(&u(i-1, 0), &u(i, 0), &u(i+1, 0),
+            zStride, &result(i, 0), result.zStride, nz, xxfactor);
+    _apply_edges(result, &FDView::dxx, i0, i1, 0, nz);
+}
+inline void FDView::dzz(const FDView& result) const {
+    const FDView& u = (*this);
+    const KernelTable& k = kernels();
+    const int j0 = _first_interior_column(), j1 = _end_interior_column();
+    for (int i=0; i < nx; i++)
+        k.second_difference_along(&u(i, j0), zStride, &result(i, j0),
+            result.zStride, j1 - j0, zzfactor);
+    _apply_edges(result, &FDView::dzz, 0, nx, j0, j1);
+}
+inline void FDView::dxz(const FDView& result) const {
+    const FDView& u = (*this);
+    const int i0 = _first_interior_row(), i1 = _end_interior_row();
+    const int j0 = _first_interior_column(), j1 = _end_interior_column();
+    for (int i=i0; i < i1; i++)
+        for (int j=j0; j < j1; j++)
+            result(i, j) = (u(i-1,j-1) - u(i-1,j+1) - u(i+1,j-1)
+                + u(i+1,j+1))*xzfactor;
+    _apply_edges(result, &FDView::dxz, i0, i1, j0, j1);
+}
+inline void FDView::gradient_magnitude(const FDView& result) const {
+    const int i0 = _first_interior_row(), i1 = _end_interior_row();
+    const int j0 = _first_interior_column(), j1 = _end_interior_column();
+    for (int i=0; i < nx; i++) {
+        const bool interiorRow = (i >= i0 && i < i1);
+        const int before = interiorRow ? j0 : nz, after = interiorRow ? j1 : nz;
+        for (int j=before; j < after; j++) {
+            const double ux = _centred_dx(i, j), uz = _centred_dz(i, j);
+            result(i, j) = sqrt(ux*ux + uz*uz);
+        }
+        for (int j=0; j < before; j++) {
+            const double ux = dx(i, j), uz = dz(i, j);
+            result(i, j) = sqrt(ux*ux + uz*uz);
+        }
+        for (int j=std::max(after, before); j < nz; j++) {
+            const double ux = dx(i, j), uz = dz(i, j);
+            result(i, j) = sqrt(ux*ux + uz*uz);
+        }
+    }
+}
+inline void divergence(const FDView& first, const FDView& second,
+    const FDView& result) 
+{
+    const int nx = first.rows(), nz = first.columns();
+    const int i0 = first._first_interior_row(), i1 = first._end_interior_row();
+    const int j0 = second._first_interior_column();
+    const int j1 = second._end_interior_column();
+    for (int i=0; i < nx; i++) {
+        // Centred in both directions between before and after
+        const bool interiorRow = (i >= i0 && i < i1);
+        const int before = interiorRow ? j0 : nz, after = interiorRow ? j1 : nz;
+        for (int j=before; j < after; j++)
+            result(i, j) = first._centred_dx(i, j) + second._centred_dz(i, j);
+        for (int j=0; j < before; j++)
+            result(i, j) = first.dx(i, j) + second.dz(i, j);
+        for (int j=std::max(after, before); j < nz; j++)
+            result(i, j) = first.dx(i, j) + second.dz(i, j);
+    }
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: FDVIEW_HPP_6RW4NC1J */
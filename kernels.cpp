@@ -0,0 +1,142 @@
+/*
+    kernels.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Builds each variant of the kernels from kernels_variant.hpp, and chooses
+    one from what the CPU supports.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <boost/thread/once.hpp>
+
+#include "multigrid_exceptions.hpp"
+#include "kernels.hpp"
+
+// Instruction set variants can only be built by GCC and compatible
+// compilers, for x86
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MULTIGRID_KERNEL_VARIANTS
+#endif
+
+// Each variant is compiled without contracting multiplies and adds into
+// fused multiply-adds (which AVX-512 would otherwise do), so that they all
+// round the same way
+namespace genericVariant {
+using namespace mgrid;
+const KernelISA variantISA = genericKernels;
+#pragma GCC push_options
+#pragma GCC optimize ("fp-contract=off")
+#include "kernels_variant.hpp"
+#pragma GCC pop_options
+}
+
+#ifdef MULTIGRID_KERNEL_VARIANTS
+namespace sse2Variant {
+using namespace mgrid;
+const KernelISA variantISA = sse2Kernels;
+#pragma GCC push_options
+#pragma GCC target ("sse2")
+#pragma GCC optimize ("fp-contract=off")
+#include "kernels_variant.hpp"
+#pragma GCC pop_options
+}
+namespace avx2Variant {
+using namespace mgrid;
+const KernelISA variantISA = avx2Kernels;
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#pragma GCC optimize ("fp-contract=off")
+#include "kernels_variant.hpp"
+#pragma GCC pop_options
+}
+namespace avx512Variant {
+using namespace mgrid;
+const KernelISA variantISA = avx512Kernels;
+#pragma GCC push_options
+#pragma GCC target ("avx512f")
+#pragma GCC optimize ("fp-contract=off")
+#include "kernels_variant.hpp"
+#pragma GCC pop_options
+}
+#endif
+
+// The kernels in use, chosen the first time they're asked for
+static const mgrid::KernelTable* selectedKernels = 0;
+static boost::once_flag selectOnce = BOOST_ONCE_INIT;
+
+static const mgrid::KernelTable& kernel_table(const mgrid::KernelISA isa) {
+#ifdef MULTIGRID_KERNEL_VARIANTS
+    switch (isa) {
+        case mgrid::sse2Kernels: return sse2Variant::table;
+        case mgrid::avx2Kernels: return avx2Variant::table;
+        case mgrid::avx512Kernels: return avx512Variant::table;
+        default: break;
+    }
+#endif
+    return genericVariant::table;
+}
+
+static void select_kernels() {
+    mgrid::KernelISA isa = mgrid::best_kernel_isa();
+    if (const char* name = std::getenv("MULTIGRID_KERNELS")) {
+        mgrid::KernelISA requested;
+        if (not(mgrid::parse_kernel_isa(name, requested))) {
+            mgrid::Message msg(mgrid::WarningMessage);
+            msg << "Unknown kernels " << name << " in MULTIGRID_KERNELS, "
+                << "using " << mgrid::kernelISANames[isa] << std::endl;
+            std::cout << msg.str();
+        } else if (not(mgrid::kernel_isa_supported(requested))) {
+            mgrid::Message msg(mgrid::WarningMessage);
+            msg << "This CPU can't run the " << name << " kernels, using "
+                << mgrid::kernelISANames[isa] << std::endl;
+            std::cout << msg.str();
+        } else {
+            isa = requested;
+        }
+    }
+    selectedKernels = &kernel_table(isa);
+}
+
+// = Kernel selection =
+const mgrid::KernelTable& mgrid::kernels() {
+    boost::call_once(selectOnce, &select_kernels);
+    return *selectedKernels;
+}
+
+bool mgrid::kernel_isa_supported(const KernelISA isa) {
+#ifdef MULTIGRID_KERNEL_VARIANTS
+    // These check that the operating system saves the wider registers too
+    __builtin_cpu_init();
+    switch (isa) {
+        case genericKernels: return true;
+        case sse2Kernels: return __builtin_cpu_supports("sse2");
+        case avx2Kernels: return __builtin_cpu_supports("avx2");
+        case avx512Kernels: return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == genericKernels;
+#endif
+}
+
+mgrid::KernelISA mgrid::best_kernel_isa() {
+    for (int isa=numberOfKernelISAs-1; isa>genericKernels; isa--)
+        if (kernel_isa_supported(KernelISA(isa))) return KernelISA(isa);
+    return genericKernels;
+}
+
+bool mgrid::use_kernels(const KernelISA isa) {
+    kernels();
+    if (not(kernel_isa_supported(isa))) return false;
+    selectedKernels = &kernel_table(isa);
+    return true;
+}
+
+bool mgrid::parse_kernel_isa(const std::string& name, KernelISA& isa) {
+    const char* const* end = kernelISANames + numberOfKernelISAs;
+    const char* const* found = std::find(kernelISANames, end, name);
+    if (found == end) return false;
+    isa = KernelISA(found - kernelISANames);
+    return true;
+}
@@ -0,0 +1,122 @@
+/*
+    kernels.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    The library's hot loops over rows of grid points, compiled for several
+    x86 instruction sets, with the best one the CPU supports chosen once at
+    startup.
+*/
+
+#ifndef KERNELS_HPP_W8NF3C5J
+#define KERNELS_HPP_W8NF3C5J
+
+#include <string>
+
+#include "types.hpp"
+
+namespace mgrid {
+
+// = Instruction sets =
+/*  genericKernels are built with the compiler flags the library was built
+    with (SSE2 on x86-64), and are the only ones on other processors.
+    sse2Kernels are the same on x86-64, but not on 32 bit builds.
+*/
+enum KernelISA {genericKernels, sse2Kernels, avx2Kernels, avx512Kernels};
+const int numberOfKernelISAs = 4;
+const char* const kernelISANames[numberOfKernelISAs] =
+    {"generic", "sse2", "avx2", "avx512"};
+
+// = Kernel table =
+/*  Each kernel works along a row of points (or, for the relaxation, down a
+    column), given by a pointer to its first point and the stride between
+    points, which is 1 for FDArrays and Stack levels (the loops are
+    vectorised for this case) and more for FDVecArray components. Rows
+    above and below are i-1 and i+1. The arithmetic in each variant is the
+    same, in the same order, and floating point contraction into fused
+    multiply-adds is turned off, so every variant gives the same results
+    to the last bit.
+
+    -- centred_difference_across: r[j] = (above[j] - below[j])*factor
+    -- second_difference_across:  r[j] = (above[j] - 2u[j] + below[j])*factor
+    -- centred_difference_along:  r[j] = -(u[j+1] - u[j-1])*factor
+    -- second_difference_along:   r[j] = (u[j-1] - 2u[j] + u[j+1])*factor
+       These are the centred differences of FDView::dx, dxx, dz and dzz.
+    -- restrict_row: full weighting of the fine rows about a fine row onto
+       n coarse points, the fine pointers being at the fine point under the
+       first coarse point (as in restriction_operator).
+    -- interpolate_on_row: fine[j] for j0 <= j < j1 on a fine row which
+       lies on the coarse row c, and interpolate_between_rows: on a fine
+       row halfway between coarse rows c and cNext (as in
+       interpolation_operator). nzf is the length of the fine row.
+    -- stencil_residual_row: r[j] = f[j] - (a u)[j] for a nine-point
+       stencil, where a points at the first point's nine coefficients
+       (which are contiguous, as in a StencilArray) and aStride is the
+       distance to the next point's.
+    -- stencil_relax_column: Gauss-Seidel updates of n points of a column,
+       every other one, of the same colour. Points of one colour in a
+       column don't depend on each other, so this is the same as the
+       updates of StencilStack::relaxation_updater in RED_BLACK_LOOP order.
+       The strides are those of the arrays' rows and columns (and of the
+       stencil coefficients from one row to the next).
+    -- accumulate_products: lanes[j & 3] += a[j]*b[j], the inner loop of
+       the blocked reductions in reduction.hpp.
+*/
+struct KernelTable {
+    KernelISA isa;
+    void (*centred_difference_across)(const double* above,
+        const double* below, const int uStride, double* result,
+        const int resultStride, const int n, const double factor);
+    void (*second_difference_across)(const double* above, const double* u,
+        const double* below, const int uStride, double* result,
+        const int resultStride, const int n, const double factor);
+    void (*centred_difference_along)(const double* u, const int uStride,
+        double* result, const int resultStride, const int n,
+        const double factor);
+    void (*second_difference_along)(const double* u, const int uStride,
+        double* result, const int resultStride, const int n,
+        const double factor);
+    void (*restrict_row)(const double* above, const double* fine,
+        const double* below, const int fineStride, double* coarse,
+        const int coarseStride, const int n);
+    void (*interpolate_on_row)(const double* c, const int coarseStride,
+        double* fine, const int fineStride, const int j0, const int j1,
+        const int nzf);
+    void (*interpolate_between_rows)(const double* c, const double* cNext,
+        const int coarseStride, double* fine, const int fineStride,
+        const int j0, const int j1, const int nzf);
+    void (*stencil_residual_row)(const double* a, const int aStride,
+        const double* above, const double* u, const double* below,
+        const int uStride, const double* f, const int fStride,
+        double* result, const int resultStride, const int n);
+    void (*stencil_relax_column)(const double* a, const int aRowStride,
+        double* u, const int uRowStride, const int uColumnStride,
+        const double* f, const int fRowStride, const int n);
+    void (*accumulate_products)(const double* a, const int aStride,
+        const double* b, const int bStride, const int n, double lanes[4]);
+};
+
+// = Kernel selection =
+/*  The kernels are chosen the first time they're asked for: the best the
+    CPU (and operating system) supports, unless $MULTIGRID_KERNELS names
+    another (generic, sse2, avx2 or avx512), for benchmarking. Asking for
+    kernels the CPU can't run falls back to the best it can, with a
+    warning.
+
+    -- kernels gives the table in use. Loops should look it up once, not
+       once per row.
+    -- kernel_isa_supported tells whether this CPU can run a variant, and
+       best_kernel_isa gives the best one it can.
+    -- use_kernels switches to another variant (if the CPU supports it,
+       otherwise it returns false). It mustn't be called during a solve.
+*/
+const KernelTable& kernels();
+bool kernel_isa_supported(const KernelISA isa);
+KernelISA best_kernel_isa();
+bool use_kernels(const KernelISA isa);
+
+// Parses an instruction set name, returning false if it isn't one
+bool parse_kernel_isa(const std::string& name, KernelISA& isa);
+
+} // end namespace mgrid
+
+#endif /* end of include guard: KERNELS_HPP_W8NF3C5J */
@@ -0,0 +1,211 @@
+/*
+    kernels_variant.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Bodies of the kernels in kernels.hpp. This isn't a normal header:
+    kernels.cpp includes it once for each instruction set, inside a
+    namespace and with the compiler targeting that instruction set, so there
+    is no include guard. Each kernel has a loop for unit strides, which the
+    compiler vectorises, and one for any other strides.
+*/
+
+static void centred_difference_across(const double* above,
+    const double* below, const int uStride, double* result,
+    const int resultStride, const int n, const double factor)
+{
+    if (uStride == 1 && resultStride == 1) {
+        for (int j=0; j<n; j++)
+            result[j] = (above[j] - below[j])*factor;
+    } else {
+        for (int j=0; j<n; j++)
+            result[j*resultStride]
+                = (above[j*uStride] - below[j*uStride])*factor;
+    }
+}
+
+static void second_difference_across(const double* above, const double* u,
+    const double* below, const int uStride, double* result,
+    const int resultStride, const int n, const double factor)
+{
+    if (uStride == 1 && resultStride == 1) {
+        for (int j=0; j<n; j++)
+            result[j] = (above[j] - 2*u[j] + below[j])*factor;
+    } else {
+        for (int j=0; j<n; j++) {
+            const int p = j*uStride;
+            result[j*resultStride]
+                = (above[p] - 2*u[p] + below[p])*factor;
+        }
+    }
+}
+
+static void centred_difference_along(const double* u, const int uStride,
+    double* result, const int resultStride, const int n,
+    const double factor)
+{
+    if (uStride == 1 && resultStride == 1) {
+        for (int j=0; j<n; j++)
+            result[j] = -(u[j+1] - u[j-1])*factor;
+    } else {
+        for (int j=0; j<n; j++) {
+            const int p = j*uStride;
+            result[j*resultStride]
+                = -(u[p+uStride] - u[p-uStride])*factor;
+        }
+    }
+}
+
+static void second_difference_along(const double* u, const int uStride,
+    double* result, const int resultStride, const int n,
+    const double factor)
+{
+    if (uStride == 1 && resultStride == 1) {
+        for (int j=0; j<n; j++)
+            result[j] = (u[j-1] - 2*u[j] + u[j+1])*factor;
+    } else {
+        for (int j=0; j<n; j++) {
+            const int p = j*uStride;
+            result[j*resultStride]
+                = (u[p-uStride] - 2*u[p] + u[p+uStride])*factor;
+        }
+    }
+}
+
+static void restrict_row(const double* above, const double* fine,
+    const double* below, const int fineStride, double* coarse,
+    const int coarseStride, const int n)
+{
+    if (fineStride == 1 && coarseStride == 1) {
+        for (int c=0, f=0; c<n; c++, f+=2)
+            coarse[c] = (4*(fine[f])
+                + 2*(below[f] + above[f] + fine[f+1] + fine[f-1])
+                + 1*(below[f+1] + below[f-1] + above[f+1]
+                    + above[f-1]))/16.0;
+    } else {
+        const int s = fineStride;
+        for (int c=0, f=0; c<n; c++, f+=2*s)
+            coarse[c*coarseStride] = (4*(fine[f])
+                + 2*(below[f] + above[f] + fine[f+s] + fine[f-s])
+                + 1*(below[f+s] + below[f-s] + above[f+s]
+                    + above[f-s]))/16.0;
+    }
+}
+
+static void interpolate_on_row(const double* c, const int coarseStride,
+    double* fine, const int fineStride, const int j0, const int j1,
+    const int nzf)
+{
+    const int jEnd = std::min(j1, nzf-1);
+    if (coarseStride == 1 && fineStride == 1) {
+        for (int j=j0; j<j1; j+=2)
+            fine[j] = c[j/2];
+        for (int j=j0+1; j<jEnd; j+=2)
+            fine[j] = 0.5*(c[j/2] + c[j/2+1]);
+    } else {
+        const int s = coarseStride;
+        for (int j=j0; j<j1; j+=2)
+            fine[j*fineStride] = c[(j/2)*s];
+        for (int j=j0+1; j<jEnd; j+=2)
+            fine[j*fineStride] = 0.5*(c[(j/2)*s] + c[(j/2+1)*s]);
+    }
+}
+
+static void interpolate_between_rows(const double* c, const double* cNext,
+    const int coarseStride, double* fine, const int fineStride,
+    const int j0, const int j1, const int nzf)
+{
+    const int jEnd = std::min(j1, nzf-1);
+    if (coarseStride == 1 && fineStride == 1) {
+        for (int j=j0; j<j1; j+=2)
+            fine[j] = 0.5*(c[j/2] + cNext[j/2]);
+        for (int j=j0+1; j<jEnd; j+=2)
+            fine[j] = 0.25*(cNext[j/2+1] + cNext[j/2] + c[j/2+1] + c[j/2]);
+    } else {
+        const int s = coarseStride;
+        for (int j=j0; j<j1; j+=2)
+            fine[j*fineStride] = 0.5*(c[(j/2)*s] + cNext[(j/2)*s]);
+        for (int j=j0+1; j<jEnd; j+=2)
+            fine[j*fineStride] = 0.25*(cNext[(j/2+1)*s] + cNext[(j/2)*s]
+                + c[(j/2+1)*s] + c[(j/2)*s]);
+    }
+}
+
+static void stencil_residual_row(const double* a, const int aStride,
+    const double* above, const double* u, const double* below,
+    const int uStride, const double* f, const int fStride,
+    double* result, const int resultStride, const int n)
+{
+    if (uStride == 1 && fStride == 1 && resultStride == 1) {
+        for (int j=0; j<n; j++) {
+            const double* s = a + j*aStride;
+            result[j] = f[j] - (s[0]*above[j-1] + s[1]*above[j]
+                + s[2]*above[j+1] + s[3]*u[j-1] + s[4]*u[j] + s[5]*u[j+1]
+                + s[6]*below[j-1] + s[7]*below[j] + s[8]*below[j+1]);
+        }
+    } else {
+        for (int j=0; j<n; j++) {
+            const double* s = a + j*aStride;
+            const int p = j*uStride, l = p - uStride, r = p + uStride;
+            result[j*resultStride] = f[j*fStride] - (s[0]*above[l]
+                + s[1]*above[p] + s[2]*above[r] + s[3]*u[l] + s[4]*u[p]
+                + s[5]*u[r] + s[6]*below[l] + s[7]*below[p] + s[8]*below[r]);
+        }
+    }
+}
+
+static void stencil_relax_column(const double* a, const int aRowStride,
+    double* u, const int uRowStride, const int uColumnStride,
+    const double* f, const int fRowStride, const int n)
+{
+    const int up = -uRowStride, down = uRowStride;
+    const int left = -uColumnStride, right = uColumnStride;
+    for (int k=0; k<n; k++) {
+        const double* s = a + 2*k*aRowStride;
+        double* p = u + 2*k*uRowStride;
+        const double applied = s[0]*p[up+left] + s[1]*p[up]
+            + s[2]*p[up+right] + s[3]*p[left] + s[4]*p[0] + s[5]*p[right]
+            + s[6]*p[down+left] + s[7]*p[down] + s[8]*p[down+right];
+        p[0] += (f[2*k*fRowStride] - applied)/s[4];
+    }
+}
+
+static void accumulate_products(const double* a, const int aStride,
+    const double* b, const int bStride, const int n, double lanes[4])
+{
+    double l0 = lanes[0], l1 = lanes[1], l2 = lanes[2], l3 = lanes[3];
+    int j = 0;
+    if (aStride == 1 && bStride == 1) {
+        for (; j+3 < n; j+=4) {
+            l0 += a[j]*b[j];
+            l1 += a[j+1]*b[j+1];
+            l2 += a[j+2]*b[j+2];
+            l3 += a[j+3]*b[j+3];
+        }
+    } else {
+        for (; j+3 < n; j+=4) {
+            l0 += a[j*aStride]*b[j*bStride];
+            l1 += a[(j+1)*aStride]*b[(j+1)*bStride];
+            l2 += a[(j+2)*aStride]*b[(j+2)*bStride];
+            l3 += a[(j+3)*aStride]*b[(j+3)*bStride];
+        }
+    }
+    lanes[0] = l0;
+    lanes[1] = l1;
+    lanes[2] = l2;
+    lanes[3] = l3;
+    for (; j < n; j++) lanes[j & 3] += a[j*aStride]*b[j*bStride];
+}
+
+static const KernelTable table = {
+    variantISA,
+    centred_difference_across,
+    second_difference_across,
+    centred_difference_along,
+    second_difference_along,
+    restrict_row,
+    interpolate_on_row,
+    interpolate_between_rows,
+    stencil_residual_row,
+    stencil_relax_column,
+    accumulate_products
+};
@@ -0,0 +1,235 @@
+/*
+    lfa.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <algorithm>
+
+#include "lfa.hpp"
+
+typedef std::complex<double> Complex;
+
+// Operators on the four harmonics which share a coarse grid mode: theta,
+// then theta shifted by (pi, 0), (0, pi) and (pi, pi). Multiplying by
+// (-1)^(i+j) shifts by (pi, pi), which swaps harmonics 0 and 3, and 1 and 2.
+static const int harmonics = 4;
+static const int shifted[harmonics] = {3, 2, 1, 0};
+
+struct FourierMatrix {
+    Complex a[harmonics][harmonics];
+
+    FourierMatrix(const Complex diagonal=0) {
+        for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+            a[m][n] = (m == n) ? diagonal : Complex(0);
+    }
+    FourierMatrix operator*(const FourierMatrix& other) const {
+        FourierMatrix result;
+        for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+            for (int k=0; k<harmonics; k++)
+                result.a[m][n] += a[m][k]*other.a[k][n];
+        return result;
+    }
+    double norm() const {
+        double sum = 0;
+        for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+            sum += std::norm(a[m][n]);
+        return std::sqrt(sum);
+    }
+};
+
+static FourierMatrix power(const FourierMatrix& matrix, unsigned long n) {
+    FourierMatrix result(1), square = matrix;
+    for (; n > 0; n /= 2, square = square*square)
+        if (n % 2) result = result*square;
+    return result;
+}
+
+// Spectral radius, as the limit of |M^k|^(1/k), with M squared repeatedly
+// and rescaled each time: M^(2^s) = exp(logScale) A. Ten squarings give
+// the radius to well within a percent.
+static double spectral_radius(const FourierMatrix& matrix) {
+    const int squarings = 10;
+    FourierMatrix A = matrix;
+    double scale = A.norm();
+    if (scale == 0) return 0;
+    double logScale = std::log(scale);
+    for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+        A.a[m][n] /= scale;
+    for (int s=0; s<squarings; s++) {
+        A = A*A;
+        scale = A.norm();
+        if (scale == 0) return 0;
+        logScale = 2*logScale + std::log(scale);
+        for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+            A.a[m][n] /= scale;
+    }
+    return std::exp(logScale/(1 << squarings));
+}
+
+// Symbol of a stencil at frequencies (tx, tz)
+static Complex symbol(const mgrid::PointStencil& stencil, const double tx,
+    const double tz)
+{
+    Complex result = 0;
+    for (int di=-1; di<=1; di++) for (int dj=-1; dj<=1; dj++)
+        result += stencil[mgrid::stencil_index(di, dj)]
+            *std::polar(1.0, di*tx + dj*tz);
+    return result;
+}
+
+// Symbols of the fine operator, and of the restriction and interpolation
+// (which are the same, for full weighting and bilinear interpolation), for
+// each harmonic of theta
+struct Harmonics {
+    Complex operatorSymbol[harmonics];
+    double transfer[harmonics];
+
+    Harmonics(const mgrid::PointStencil& stencil, const double tx,
+        const double tz)
+    {
+        for (int h=0; h<harmonics; h++) {
+            const double sx = tx + ((h & 1) ? M_PI : 0);
+            const double sz = tz + ((h & 2) ? M_PI : 0);
+            operatorSymbol[h] = symbol(stencil, sx, sz);
+            transfer[h] = (1 + std::cos(sx))*(1 + std::cos(sz))/4;
+        }
+    }
+};
+
+// Low frequencies are sampled at samples + 1 points from -pi/2 to pi/2 in
+// each direction
+static double frequency(const int p, const int samples) {
+    return M_PI*(double(p)/samples - 0.5);
+}
+
+// One red-black sweep, red points (i + j even) first
+static FourierMatrix red_black_sweep(const Harmonics& modes,
+    const double centre)
+{
+    FourierMatrix colour[2];
+    for (int c=0; c<2; c++) {
+        // Points of this colour take their update, so the error changes
+        // by -mask(L e)/centre, where the mask is (1 +- shift)/2
+        const double sign = (c == 0) ? 1 : -1;
+        colour[c] = FourierMatrix(1);
+        for (int h=0; h<harmonics; h++) {
+            const Complex update = modes.operatorSymbol[h]/centre;
+            colour[c].a[h][h] -= 0.5*update;
+            colour[c].a[shifted[h]][h] -= 0.5*sign*update;
+        }
+    }
+    return colour[1]*colour[0];
+}
+
+// = LocalFourierAnalysis =
+mgrid::LocalFourierAnalysis::LocalFourierAnalysis(const PointStencil& fine,
+    const PointStencil& coarse, const int samples):
+    fine(fine),
+    coarse(coarse),
+    samples(std::max(2, samples))
+{}
+
+double mgrid::LocalFourierAnalysis::smoothing_factor(
+    const unsigned long sweeps) const
+{
+    const double centre = fine[stencilCentre];
+    double result = 0;
+    for (int p=0; p<=samples; p++) for (int q=0; q<=samples; q++) {
+        const Harmonics modes(fine, frequency(p, samples),
+            frequency(q, samples));
+        FourierMatrix smoothed = power(red_black_sweep(modes, centre),
+            sweeps);
+        for (int n=0; n<harmonics; n++) smoothed.a[0][n] = 0;
+        result = std::max(result, spectral_radius(smoothed));
+    }
+    return std::pow(result, 1.0/std::max(1ul, sweeps));
+}
+
+double mgrid::LocalFourierAnalysis::two_grid_factor(
+    const unsigned long preRelax, const unsigned long postRelax,
+    const CoarseOperatorType coarseOperator) const
+{
+    const double centre = fine[stencilCentre];
+    double result = 0;
+    for (int p=0; p<=samples; p++) for (int q=0; q<=samples; q++) {
+        const double tx = frequency(p, samples), tz = frequency(q, samples);
+        const Harmonics modes(fine, tx, tz);
+
+        // Coarse operator, at the coarse grid frequency 2 theta
+        Complex coarseSymbol = 0;
+        if (coarseOperator == galerkinOperator) {
+            for (int h=0; h<harmonics; h++)
+                coarseSymbol += modes.transfer[h]*modes.operatorSymbol[h]
+                    *modes.transfer[h];
+        } else {
+            coarseSymbol = symbol(coarse, 2*tx, 2*tz);
+        }
+        // The coarse operator is usually singular at theta = 0, where the
+        // cycle doesn't do anything anyway
+        if (std::abs(coarseSymbol) < 1e-12*std::abs(centre)) continue;
+
+        // Coarse grid correction, I - P (L_H)^-1 R L_h
+        FourierMatrix correction(1);
+        for (int m=0; m<harmonics; m++) for (int n=0; n<harmonics; n++)
+            correction.a[m][n] -= modes.transfer[m]*modes.transfer[n]
+                *modes.operatorSymbol[n]/coarseSymbol;
+        const FourierMatrix sweep = red_black_sweep(modes, centre);
+        result = std::max(result, spectral_radius(power(sweep, postRelax)
+            *correction*power(sweep, preRelax)));
+    }
+    return result;
+}
+
+void mgrid::LocalFourierAnalysis::report(std::ostream& out,
+    const unsigned long preRelax, const unsigned long postRelax) const
+{
+    char line[120];
+    out << "Local Fourier analysis (fine and coarse stencils):" << std::endl;
+    for (int di=-1; di<=1; di++) {
+        std::sprintf(line, "  %11.4e %11.4e %11.4e    %11.4e %11.4e %11.4e\n",
+            fine[stencil_index(di, -1)], fine[stencil_index(di, 0)],
+            fine[stencil_index(di, 1)], coarse[stencil_index(di, -1)],
+            coarse[stencil_index(di, 0)], coarse[stencil_index(di, 1)]);
+        out << line;
+    }
+    const unsigned long sweeps = preRelax + postRelax;
+    std::sprintf(line, "  smoothing factor: %.4f per sweep, %.4f for %lu "
+        "sweeps\n", smoothing_factor(1), smoothing_factor(sweeps), sweeps);
+    out << line;
+    std::sprintf(line, "  two-grid factor (%lu/%lu sweeps): %.4f "
+        "rediscretised, %.4f Galerkin\n", preRelax, postRelax,
+        two_grid_factor(preRelax, postRelax, rediscretisedOperator),
+        two_grid_factor(preRelax, postRelax, galerkinOperator));
+    out << line;
+}
+
+// Stencils of a solver's operator, from probe_operator on two levels
+mgrid::LocalFourierAnalysis mgrid::fourier_analysis(MultigridBase& solver,
+    const double x, const double z, const int samples)
+{
+    Stack& stack = solver.get_solution();
+    const Level finest = stack.finestLevel;
+    if (finest < 1)
+        throw std::runtime_error(
+            "Local Fourier analysis needs at least two grids");
+
+    // The nearest fine point which is also on the coarse grid
+    const int nx = stack[finest].rows(), nz = stack[finest].columns();
+    const int nxc = stack[finest-1].rows(), nzc = stack[finest-1].columns();
+    const int ic = std::min(std::max(int(x*(nxc-1) + 0.5), 1), nxc-2);
+    const int jc = std::min(std::max(int(z*(nzc-1) + 0.5), 1), nzc-2);
+
+    StencilArray fineStencils(nx, nz, stencilSize);
+    StencilArray coarseStencils(nxc, nzc, stencilSize);
+    solver.probe_operator(finest, fineStencils);
+    solver.probe_operator(finest-1, coarseStencils);
+    PointStencil fine, coarse;
+    for (int n=0; n<stencilSize; n++) {
+        fine[n] = fineStencils(2*ic, 2*jc, n);
+        coarse[n] = coarseStencils(ic, jc, n);
+    }
+    return LocalFourierAnalysis(fine, coarse, samples);
+}
@@ -0,0 +1,86 @@
+/*
+    lfa.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Local Fourier analysis of the library's red-black relaxation and
+    two-grid cycles, to predict how well multigrid will converge for an
+    operator without running it.
+*/
+
+#ifndef LFA_HPP_H4TC9R2Z
+#define LFA_HPP_H4TC9R2Z
+
+#include <iostream>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "stencil.hpp"
+#include "settings.hpp"
+#include "multigrid_base.hpp"
+
+namespace mgrid {
+
+// A nine-point stencil at one point, indexed by stencil_index(di, dj)
+typedef blitz::TinyVector<double, stencilSize> PointStencil;
+
+// = LocalFourierAnalysis class interface =
+/*  Treats the operator as having the same stencil everywhere on an
+    infinite (or periodic) grid, so that the relaxation and coarse grid
+    correction act on each group of four Fourier modes which share a
+    coarse grid mode independently. The stencils are a fine grid stencil
+    and a coarse one, which is used for rediscretised coarse operators
+    (Galerkin coarse operators are worked out from the fine stencil).
+
+    -- smoothing_factor is the largest factor by which the given number of
+       red-black sweeps reduce the high frequencies, per sweep, assuming
+       the coarse grid takes care of the low frequencies exactly.
+    -- two_grid_factor is the spectral radius of a cycle with the given
+       sweeps before and after an exact coarse grid correction, using full
+       weighting restriction and bilinear interpolation (as in stack.hpp).
+       It's an estimate of the residual reduction of each cycle.
+    Each is the worst over a grid of samples + 1 low frequencies in each
+    direction. Red-black relaxation is modelled as updating all the points
+    of one colour at once, which is exact for five-point stencils (points
+    of one colour don't then couple) and a close approximation for
+    nine-point ones.
+*/
+class LocalFourierAnalysis {
+public:
+    LocalFourierAnalysis(const PointStencil& fine, const PointStencil& coarse,
+        const int samples=64);
+
+    double smoothing_factor(const unsigned long sweeps=1) const;
+    double two_grid_factor(const unsigned long preRelax,
+        const unsigned long postRelax,
+        const CoarseOperatorType coarseOperator) const;
+
+    // Prints the stencils and the factors for the given sweeps, with both
+    // kinds of coarse operator
+    void report(std::ostream& out, const unsigned long preRelax,
+        const unsigned long postRelax) const;
+
+    inline const PointStencil& fine_stencil() const;
+    inline const PointStencil& coarse_stencil() const;
+
+private:
+    PointStencil fine, coarse;
+    const int samples;
+};
+
+// Analysis of a solver's differential operator, from its stencils at the
+// grid point nearest (x, z) (as fractions of the width and height) on the
+// finest grid and on the next coarsest, found with probe_operator
+LocalFourierAnalysis fourier_analysis(MultigridBase& solver,
+    const double x=0.5, const double z=0.5, const int samples=64);
+
+// = Inline methods =
+inline const PointStencil& LocalFourierAnalysis::fine_stencil() const {
+    return fine;
+}
+inline const PointStencil& LocalFourierAnalysis::coarse_stencil() const {
+    return coarse;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: LFA_HPP_H4TC9R2Z */
@@ -12,12 +12,32 @@
 #include "multigrid_exceptions.hpp"
 #include "utilities.hpp"
 #include "fdbase.hpp"                 
+#include "kernels.hpp"
+#include "fdview.hpp"
+#include "reduction.hpp"
 #include "fdarray.hpp"   
 #include "fdvecarray.hpp" 
+#include "arena.hpp"
+#include "checkpoint.hpp"
+#include "perf_counters.hpp"
+#include "tracer.hpp"
+#include "profiler.hpp"
+#include "solve_result.hpp"
 #include "stack.hpp"
+#include "stencil.hpp"
+#include "workspace.hpp"
+#include "thread_pool.hpp"
 #include "settings.hpp" 
+#include "output.hpp"
 #include "multigrid_base.hpp"
 #include "multigrid_linear.hpp"
 #include "multigrid_nonlinear.hpp"
+#include "multigrid_batched.hpp"
+#include "lfa.hpp"
+#include "sweep.hpp"
+#include "tuner.hpp"
+#ifdef MULTIGRID_MPI
+#include "multigrid_distributed.hpp"
+#endif
 
 #endif /* end of include guard: MULTIGRID_HPP_9IST4LP5 */
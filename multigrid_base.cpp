@@ -5,48 +5,121 @@
     Base class for multigrid solvers
 */                            
 
+#include <algorithm>
+#include <fstream>
+#include <boost/bind.hpp>
+
 #include "multigrid_base.hpp"
 
 // Ctor
 mgrid::MultigridBase::MultigridBase(const Settings& settings):  
     solution(settings),
     source(settings),
-    temp(settings),       
+    workspace(new Workspace()),
     cycleType(settings.mgCycleType),
     preRelax(settings.preMGRelaxIter), 
     postRelax(settings.postMGRelaxIter), 
     residualTolerance(settings.residualTolerance), 
     maxIterations(settings.maximumIterations),  
     aspect(settings.aspectRatio),
+    coarseOperatorType(settings.coarseOperator),
+    tileSize(settings.tileSize),
+    outputSettings(settings.output),
     sourceIsSet(false),
-    initialIsSet(false)
+    initialIsSet(false),
+    coarseOperatorsAreSet(false),
+    restoredFromCheckpoint(false),
+    finalResidualPending(false),
+    trackConvergence(settings.trackConvergence),
+    checkpointInterval(settings.checkpointInterval),
+    checkpointPath(settings.checkpointPath),
+    lastCheckpoint(boost::posix_time::microsec_clock::universal_time())
 {
     // Initialise some other variables
     finestLevel = solution.finestLevel;
     coarsestLevel = solution.coarsestLevel;  
     nxfine = solution[finestLevel].rows(); 
     nzfine = solution[finestLevel].columns(); 
+    
+    // Profile each level of the stacks
+    profiler.resize(finestLevel + 1);
+    for (Level level=coarsestLevel; level<=finestLevel; level++)
+        profiler.set_shape(level, solution[level].rows(), 
+            solution[level].columns());
+    solution.set_profiler(&profiler);
+    source.set_profiler(&profiler);
+    sweeps.resize(finestLevel + 1, 0);
+}
+
+// Warm starts
+bool mgrid::MultigridBase::initial_guess_from_file(const std::string& path,
+    std::string variable)
+{
+    // Look for the solution under the name write gives it, unless we're 
+    // told otherwise
+    std::vector<std::string> names;
+    if (variable.empty()) {
+        names.push_back(solution_name());
+        if (names.back() != "solution") names.push_back("solution");
+    } else {
+        names.push_back(variable);
+    }
+    std::vector<double> values;
+    int nx = 0, nz = 0;
+    if (not(read_field(path, names, values, nx, nz)) || nx < 2 || nz < 2) {
+        Message msg(WarningMessage);
+        msg << "Couldn't read an initial guess from " << path << std::endl;
+        std::cout << msg.str();
+        return false;
+    }
+    const FDView field(&values[0], nx, nz, nz, 1, 
+        solution[finestLevel].spacing(0), solution[finestLevel].spacing(1));
+    resample(field, solution[finestLevel]);
+    initialIsSet = true;
+    return true;
+}
+
+// Memory management
+void mgrid::MultigridBase::set_workspace(
+    boost::shared_ptr<Workspace> sharedWorkspace) 
+{
+    workspace = sharedWorkspace;
+}
+std::size_t mgrid::MultigridBase::peak_memory() {
+    std::size_t result = solution.memory() + source.memory();
+    for (Level level=coarsestLevel; level<Level(coarseOperators.size()); 
+        level++)
+        result += coarseOperators[level].size()*sizeof(double);
+    return result + workspace->memory();
 }
 
 // Relaxation methods
 void mgrid::MultigridBase::relax(const Level level, const unsigned long N) {
     // Relax for N iterations
+    sweeps[level] += N;
     for (unsigned long iter=0; iter<N; iter++) { 
-        RED_BLACK_LOOP(solution[level])
-            relaxation_updater(level, i, j); 
+        _relaxation_sweep(level);
         
         // Update boundaries
+        PROFILE_SCOPE(profile, &profiler, boundaryPhase, level);
+        PROFILE_WORK(profile, 
+            2*(solution[level].rows() + solution[level].columns()),
+            12*(solution[level].rows() + solution[level].columns())
+                *sizeof(double));
         solution[level].update_boundaries();
     }      
 }                                       
 void mgrid::MultigridBase::relax(const Level level, const double tolerance) {
     // Relax until specified tolerance
+    PROFILE_SCOPE(profile, &profiler, coarseSolvePhase, level);
     for (unsigned long iter=0; iter<maxIterations; iter++) {  
+        PROFILE_WORK(profile, solution[level].size(), 
+            solution[level].size()*_sweep_bytes(level));
         double residualSum = 0, normSum = 0, tmp;
         RED_BLACK_LOOP(solution[level]) {
      	    // Store current value, calculate update  
             tmp = solution[level](i, j);    
-            relaxation_updater(level, i, j);    
+            _relaxation_updater(level, i, j);    
                                                        
             // Calculate change and add to sum
             tmp = (solution[level](i, j) - tmp);          
@@ -58,57 +131,273 @@ void mgrid::MultigridBase::relax(const Level level, const double tolerance) {
         solution[level].update_boundaries();                                                           
      	
      	// Check for convergence
-     	if ((sqrt(residualSum)/sqrt(normSum)) < tolerance) return; 
+     	if ((sqrt(residualSum)/sqrt(normSum)) < tolerance) {
+            sweeps[level] += iter + 1;
+            solveResult.coarseIterations.push_back(iter + 1);
+            return; 
+        }
     } 
+    sweeps[level] += maxIterations;
+    solveResult.coarseIterations.push_back(maxIterations);
 }                      
+void mgrid::MultigridBase::_relaxation_sweep(const Level level) {
+    // One red-black sweep over the interior
+    PROFILE_SCOPE(profile, &profiler, relaxPhase, level);
+    PROFILE_WORK(profile, solution[level].size(), 
+        solution[level].size()*_sweep_bytes(level));
+    if (_is_galerkin_level(level)) {
+        if (tileSize > 0) {
+            TILED_RED_BLACK_LOOP(solution[level], tileSize)
+                coarseOperators.relaxation_updater(level, solution[level],
+                    source[level], i, j);
+        } else {
+            coarseOperators.relax(level, solution[level], source[level]);
+        }
+    } else if (tileSize > 0) {
+        TILED_RED_BLACK_LOOP(solution[level], tileSize)
+            relaxation_updater(level, i, j); 
+    } else {
+        RED_BLACK_LOOP(solution[level])
+            relaxation_updater(level, i, j); 
+    }
+}
 
-// Write method
-void mgrid::MultigridBase::write(int numOfVariables, std::string fileRoot) { 
-    // Get generated file name from settings instance
-    fileRoot.append(filename()).append(".nc");      
-    
-    // Generate new netCDF file using given fileString - replace the file if
-    // it already exists
-    std::auto_ptr<NcFile> file(new NcFile(fileRoot.c_str(), NcFile::Replace));
+// Solve statistics
+void mgrid::MultigridBase::_begin_solve() {
+    solveResult.clear();
+    finalResidualPending = false;
+    std::fill(sweeps.begin(), sweeps.end(), 0);
+}
+void mgrid::MultigridBase::_end_solve() {
+    // The final residual takes a residual evaluation, so it's left until
+    // solve_result asks for it unless convergence is being tracked
+    solveResult.workUnits = _work_units();
+    if (trackConvergence)
+        solveResult.finalResidual = _residual_norm(finestLevel);
+    else
+        finalResidualPending = true;
+}
+void mgrid::MultigridBase::_record_cycle(const Level level, const int cycle, 
+    double& residual) 
+{
+    if (not(trackConvergence)) return;
+    CycleRecord record;
+    record.level = level;
+    record.cycle = cycle;
+    record.residualBefore = residual;
+    record.residualAfter = residual = _residual_norm(level);
+    record.workUnits = _work_units();
+    solveResult.cycles.push_back(record);
+}
+double mgrid::MultigridBase::_residual_norm(const Level level) {
+    // RMS over the interior, since the boundary rows hold the conditions
+    const int nx = solution[level].rows(), nz = solution[level].columns();
+    if (nx < 3 || nz < 3) return 0;
+    ScratchArray residual(*workspace, solution[level]);
+    evaluate_residual(level, residual);
+    return sqrt(sum_of_squares(residual.view().block(1, 1, nx-2, nz-2))
+        /((nx - 2)*(nz - 2)));
+}
+double mgrid::MultigridBase::_work_units() {
+    double result = 0;
+    const double finePoints = double(nxfine)*nzfine;
+    for (Level level=coarsestLevel; level<=finestLevel; level++)
+        result += sweeps[level]*solution[level].rows()
+            *solution[level].columns()/finePoints;
+    return result;
+}
+
+// Galerkin coarse grid operators
+void mgrid::MultigridBase::build_coarse_operators() {
+    // Allocate coefficient arrays on first use
+    if (coarseOperators.empty()) coarseOperators.resize(solution);
+    coarseOperatorsAreSet = false;
     
-    // Check to see that file has been generated  
-    if (file->is_valid()) {
-        // Define and add dimentions and variables
-        NcDim* xDim = file->add_dim("x", nxfine);
-        NcDim* zDim = file->add_dim("z", nzfine);              
-        NcVar* XxVals = file->add_var("x", ncDouble, xDim);   
-        NcVar* ZzVals = file->add_var("z", ncDouble, zDim);
-        const double hx = solution[finestLevel].spacing(0);
-        const double hz = solution[finestLevel].spacing(1);
-        double XxArray[nxfine];
-        double ZzArray[nzfine];
-        for (int i=0; i<nxfine; i++) XxArray[i] = i*hx;
-        for (int j=0; j<nzfine; j++) ZzArray[j] = j*hz; 
-        XxVals->put(XxArray, nxfine);
-        ZzVals->put(ZzArray, nzfine);
-        
-        // Add solution
-        NcVar* variable = file->add_var("solution", ncDouble, xDim, zDim);
-        variable->put(&solution[finestLevel](0,0), nxfine, nzfine); 
+    // Coarsen the finest level stencil, then free the finest level since this 
+    // uses the user-supplied operator directly
+    probe_operator(coarseOperators[finestLevel]);
+    for (Level level=finestLevel; level>coarsestLevel; level--) 
+        coarseOperators.galerkin_coarsen(level);
+    coarseOperators[finestLevel].free();
+    coarseOperatorsAreSet = true;
+}
+void mgrid::MultigridBase::probe_operator(StencilArray& result) {
+    probe_operator(finestLevel, result);
+}
+void mgrid::MultigridBase::probe_operator(const Level level, 
+    StencilArray& result) 
+{
+    // Setting the solution to one on every third point in each direction 
+    // means that each interior point sees exactly one nonzero neighbour, so 
+    // nine evaluations recover all nine coefficients. The operator evaluated 
+    // on a zero solution is subtracted in case the operator has a constant 
+    // part.
+    FDArray& u = solution[level];
+    const int nx = u.rows(), nz = u.columns();
+    ScratchArray probed(*workspace, u), offset(*workspace, u);
+    ScratchArray saved(*workspace, u);
+    result = 0;
+    saved = u;
+    u = 0;
+    evaluate_operator(level, offset);
+    for (int pi=0; pi<3; pi++) for (int pj=0; pj<3; pj++) {
+        u = 0;
+        for (int i=pi; i<nx; i+=3) 
+            for (int j=pj; j<nz; j+=3) 
+                u(i, j) = 1;
+        evaluate_operator(level, probed);
+        for (int i=1; i<nx-1; i++) {
+            const int di = (pi - i%3 + 4)%3 - 1;   // offset in {-1, 0, 1}
+            for (int j=1; j<nz-1; j++) {
+                const int dj = (pj - j%3 + 4)%3 - 1;
+                result(i, j, stencil_index(di, dj)) 
+                    = probed(i, j) - offset(i, j);
+            }
+        }
+    }
+    u = saved;
+}
 
-        // Calculate gradient components
-        if (numOfVariables > 1) {
-            NcVar* modGrad = file->add_var("gradient", ncDouble, xDim, zDim);  
-            FDArray gradientValues(aspect, nxfine, nzfine); 
-            solution[finestLevel].gradient_magnitude(gradientValues);     
-            modGrad->put(&gradientValues(0,0), nxfine, nzfine);
-        } 
-        
-        // Calculate residual values
-        if (numOfVariables > 2) {
-            NcVar* resid = file->add_var("log_residual", ncDouble, xDim, zDim);
-            FDArray residualValues(aspect, nxfine, nzfine);
-            evaluate_residual(finestLevel, residualValues); 
-            residualValues = log10(residualValues);       
-            resid->put(&residualValues(0,0), nxfine, nzfine); 
-        } 
-        
-        // Add some attributes describing settings 
-        file->add_att("aspect_ratio", aspect);
+// Write methods
+mgrid::SolutionOutput mgrid::MultigridBase::_output(int numOfVariables, 
+    std::string fileRoot) 
+{
+    SolutionOutput output;
+    output.path = fileRoot.append(filename()).append(".nc");
+    output.settings = outputSettings;
+    output.numOfVariables = numOfVariables;
+    output.solutionName = solution_name();
+    output.attributes.push_back(std::make_pair("aspect_ratio", aspect));
+    if (outputSettings.solveStatistics) 
+        solve_result().add_attributes(output.attributes);
+    return output;
+}
+void mgrid::MultigridBase::write(int numOfVariables, std::string fileRoot) { 
+    // Write straight from the solution, and a scratch array for the residual
+    // (which is only borrowed if it's written)
+    SolutionOutput output = _output(numOfVariables, fileRoot);
+    output.solution.reference(solution[finestLevel]);
+    if (numOfVariables > 2) {
+        ScratchArray residualValues(*workspace, solution[finestLevel]);
+        evaluate_residual(finestLevel, residualValues); 
+        output.residual.reference(residualValues);
+        output.write();
+        output.residual.free();
+        return;
+    }
+    output.write();
+}
+boost::shared_ptr<mgrid::SolutionOutput> mgrid::MultigridBase::snapshot(
+    int numOfVariables, std::string fileRoot) 
+{ 
+    // Copy the solution and residual, since the solver may change them 
+    // before the file is written
+    boost::shared_ptr<SolutionOutput> output(
+        new SolutionOutput(_output(numOfVariables, fileRoot)));
+    output->solution.resize(aspect, nxfine, nzfine);
+    output->solution = solution[finestLevel];
+    if (numOfVariables > 2) {
+        output->residual.resize(aspect, nxfine, nzfine);
+        evaluate_residual(finestLevel, output->residual);
+    }
+    return output;
+}
+void mgrid::MultigridBase::write_async(OutputQueue& queue, 
+    int numOfVariables, std::string fileRoot) 
+{ 
+    // The queue holds the only reference to the copied arrays, so their 
+    // reference counts (which aren't locked) are only changed by the writer 
+    // thread, as with checkpoints
+    queue.push(boost::bind(&SolutionOutput::write, 
+        snapshot(numOfVariables, fileRoot)));
+}
+
+// Profiling
+void mgrid::MultigridBase::write_profile(std::string path) {
+    if (path.empty()) path = filename() + ".profile.json";
+    std::ofstream file(path.c_str());
+    if (not(file)) {
+        Message msg(WarningMessage);
+        msg << "Couldn't write a profile to " << path << std::endl;
+        std::cout << msg.str();
+        return;
+    }
+    profiler.write_json(file, filename());
+}
+void mgrid::MultigridBase::write_trace(std::string path) {
+    if (not(profiler.tracer())) {
+        Message msg(WarningMessage);
+        msg << "No trace to write (call profile().start_trace() first)" 
+            << std::endl;
+        std::cout << msg.str();
+        return;
+    }
+    if (path.empty()) path = filename() + ".trace.json";
+    std::ofstream file(path.c_str());
+    if (not(file)) {
+        Message msg(WarningMessage);
+        msg << "Couldn't write a trace to " << path << std::endl;
+        std::cout << msg.str();
+        return;
     }
-}
\ No newline at end of file
+    profiler.tracer()->write_json(file);
+}
+
+// Checkpointing
+void mgrid::MultigridBase::checkpoint(CheckpointWriter& checkpoint) {
+    // Grid geometry (to check against when restoring), flags and stacks
+    std::vector<double> state;
+    state.push_back(finestLevel + 1);
+    state.push_back(nxfine);
+    state.push_back(nzfine);
+    state.push_back(sourceIsSet);
+    state.push_back(initialIsSet);
+    checkpoint.add("multigrid_state", state);
+    solution.checkpoint(checkpoint, "solution");
+    source.checkpoint(checkpoint, "source");
+}
+void mgrid::MultigridBase::restore(CheckpointReader& checkpoint) {
+    std::vector<double> state;
+    checkpoint.read("multigrid_state", state);
+    if (state.size() != 5 || int(state[0]) != finestLevel + 1 
+        || int(state[1]) != nxfine || int(state[2]) != nzfine)
+        throw CheckpointException("the checkpoint is for different grids");
+    solution.restore(checkpoint, "solution");
+    source.restore(checkpoint, "source");
+    sourceIsSet = bool(state[3]);
+    initialIsSet = bool(state[4]);
+    
+    // Galerkin operators aren't saved, since they're cheap to rebuild
+    coarseOperatorsAreSet = false;
+    restoredFromCheckpoint = true;
+}
+std::string mgrid::MultigridBase::checkpoint_path() {
+    return checkpointPath.empty() ? filename() + ".checkpoint" 
+        : checkpointPath;
+}
+void mgrid::MultigridBase::write_checkpoint(std::string path) {
+    CheckpointWriter writer;
+    checkpoint(writer);
+    writer.write(path.empty() ? checkpoint_path() : path);
+}
+void mgrid::MultigridBase::restore_checkpoint(std::string path) {
+    CheckpointReader reader(path.empty() ? checkpoint_path() : path);
+    restore(reader);
+}
+void mgrid::MultigridBase::_checkpoint_if_due() {
+    using namespace boost::posix_time;
+    if (checkpointInterval <= 0) return;
+    const ptime now = microsec_clock::universal_time();
+    if ((now - lastCheckpoint).total_microseconds() 
+        < 1e6*checkpointInterval) return;
+    lastCheckpoint = now;
+    
+    // Snapshot the state now, and write it on the checkpoint thread. Only 
+    // one snapshot is kept waiting, so a slow disk holds the solver up 
+    // rather than filling memory.
+    boost::shared_ptr<CheckpointWriter> writer(new CheckpointWriter());
+    checkpoint(*writer);
+    if (not(checkpointQueue)) checkpointQueue.reset(new OutputQueue(1));
+    checkpointQueue->push(boost::bind(&CheckpointWriter::write, writer, 
+        checkpoint_path()));
+}
@@ -7,6 +7,8 @@
 #define MULTIGRID_BASE_HPP_TVC215N7
 
 #include <netcdfcpp.h> 
+#include <boost/shared_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "types.hpp" 
 #include "multigrid_exceptions.hpp"
@@ -14,7 +16,13 @@
 #include "fdarray.hpp"
 #include "fdvecarray.hpp"
 #include "stack.hpp" 
+#include "stencil.hpp"
+#include "workspace.hpp"
 #include "settings.hpp"
+#include "output.hpp"
+#include "checkpoint.hpp"
+#include "profiler.hpp"
+#include "solve_result.hpp"
 
 namespace mgrid {
 
@@ -25,10 +33,19 @@ public:
     
     // Setters and getters 
     inline FDArray& get_result(); 
+    inline Stack& get_solution();
     template <typename T> inline void initial_guess(T arg); 
     inline FDArray& source_term(); 
     template <typename T> inline void source_term(T arg);
     
+    // Warm starts: reads a solution written by write (or the named 
+    // variable) from a netCDF file, and resamples it onto the finest grid 
+    // as the initial guess (see resample), e.g. to start a run at a higher 
+    // resolution or nearby parameters from an old result. Returns false, 
+    // with a warning, if the file has no solution in it.
+    bool initial_guess_from_file(const std::string& path, 
+        std::string variable="");
+    
     // Evaluation methods 
     inline void evaluate_operator(Level level, FDArray& result); 
     inline void evaluate_residual(Level level, FDArray& result);                     
@@ -37,6 +54,17 @@ public:
     void relax(const Level level, const unsigned long N);
     void relax(const Level level, const double tolerance);        
     
+    // Builds Galerkin coarse grid operators from the differential operator
+    // on the finest level. Call this again if the operator's coefficients
+    // change between solves.
+    void build_coarse_operators();
+    
+    // Evaluates the nine-point stencil of the differential operator at each 
+    // interior point of the finest level (or of the given level, where 
+    // result must have that level's shape)
+    void probe_operator(StencilArray& result);
+    void probe_operator(const Level level, StencilArray& result);
+    
     // Multigrid solver method, overwritten by LinearMultigrid and 
     // NonlinearMultigrid classes, and solve method which should be 
     // overwritten by subclasses of Linear- and NonlinearMultigrid if
@@ -48,30 +76,129 @@ public:
     virtual double differential_operator(Level, int, int)=0;
     virtual void relaxation_updater(Level, int, int)=0;
     
-    // Writing methods & file name generator
+    // Scratch storage comes from a Workspace, which each solver has its own
+    // of unless it's given one to share
+    void set_workspace(boost::shared_ptr<Workspace> sharedWorkspace);
+    
+    // Most memory used by the solver's arrays at once, in bytes (including 
+    // the whole of the workspace, even if it's shared)
+    virtual std::size_t peak_memory();
+    
+    // How the last call of multigrid() went: residuals after each cycle (if 
+    // trackConvergence is set), work units and coarse solve iterations. See
+    // solve_result.hpp. Unless trackConvergence is set, the final residual
+    // is only worked out the first time this is called after a solve.
+    inline const SolveResult& solve_result();
+    
+    // Time spent in each phase on each level, if the library was built with
+    // MULTIGRID_PROFILING (see profiler.hpp). write_profile writes it as 
+    // JSON to the given file, or to filename() + ".profile.json".
+    inline Profiler& profile();
+    void write_profile(std::string path="");
+    
+    // Writes the timeline recorded since profile().start_trace() (or since
+    // the solver was built, if MULTIGRID_TRACE is set) as a Chrome trace, to 
+    // the given file or filename() + ".trace.json".
+    void write_trace(std::string path="");
+    
+    // Writing methods & file name generator. snapshot copies the solution 
+    // (and residual) into a description of the output file, which can be 
+    // written later or elsewhere (e.g. into a SweepDataset), and is shared 
+    // so that it can be handed to another thread (see SolutionOutput). 
+    // write_async hands a snapshot to the queue, so the solver can carry on 
+    // straight away.
     virtual void write(int numOfVariables, std::string root="");   
+    boost::shared_ptr<SolutionOutput> snapshot(int numOfVariables, 
+        std::string root="");
+    void write_async(OutputQueue& queue, int numOfVariables, 
+        std::string root="");
     virtual std::string filename(std::string root="")=0;
+    
+    // Checkpointing. checkpoint adds the solver's state (both stacks, and 
+    // anything a subclass adds) to a checkpoint, and restore reads it back, 
+    // after which solve should carry on where the checkpointed solve left 
+    // off. write_checkpoint and restore_checkpoint do the same with a file, 
+    // which is checkpoint_path() unless one is given.
+    virtual void checkpoint(CheckpointWriter& checkpoint);
+    virtual void restore(CheckpointReader& checkpoint);
+    void write_checkpoint(std::string path="");
+    void restore_checkpoint(std::string path="");
+    std::string checkpoint_path();
   
 protected:      
     // Data  
     Stack solution, source;         // Grids for solution and source term
-    Stack temp;                     // Extra storage for multigrid solver
+    boost::shared_ptr<Workspace> workspace; // Scratch storage
+    Profiler profiler;              // Timings of each phase on each level
+    StencilStack coarseOperators;   // Galerkin operators for coarse levels
     const int cycleType;            // Type of FMG-cycling used
     const unsigned long preRelax;   // Num of pre-corection relaxations to use
     const unsigned long postRelax;  // Num of post-corection relaxations to use    
     const double residualTolerance; // For convergence testing
     const double maxIterations;     // Maxium number of iterations allowed    
     const double aspect;            // Aspect ratio  
+    const CoarseOperatorType coarseOperatorType; 
+    const int tileSize;             // Tile width for sweeps (0 for untiled)
+    const OutputSettings outputSettings;  // File format for write methods
     int finestLevel, coarsestLevel, nxfine, nzfine;  // Grid geometry        
     bool sourceIsSet;               // Has the source term been provided?
     bool initialIsSet;              // Has an initial value for the solution
                                     // been provided? (This can be useful for 
                                     // solve routines, which may generate 
                                     // their own initial values otherwise).
+    bool coarseOperatorsAreSet;     // Have Galerkin operators been built?
+    bool restoredFromCheckpoint;    // Should solve resume from a checkpoint?
+    SolveResult solveResult;        // Convergence of the last solve
+    bool finalResidualPending;      // Is its final residual still to do?
+    const bool trackConvergence;    // Record residuals after each cycle?
+    std::vector<double> sweeps;     // Relaxation sweeps on each level during
+                                    // the current solve
+    
+    // Solve statistics. Multigrid methods call _begin_solve first and 
+    // _end_solve last, and _record_cycle after each cycle on a level with 
+    // the residual before it (which it updates to the one after).
+    void _begin_solve();
+    void _end_solve();
+    void _record_cycle(const Level level, const int cycle, double& residual);
+    double _residual_norm(const Level level);
+    double _work_units();
+    
+    // Do coarse levels use the stored Galerkin operators?
+    inline bool _is_galerkin_level(const Level level);  
+    inline void _relaxation_updater(Level level, int i, int j);
+    
+    // One red-black sweep over a level, without updating the boundaries
+    void _relaxation_sweep(const Level level);
+    
+    // Restriction of an array on the given level which isn't in a stack 
+    // (e.g. a residual), and an estimate of the bytes moved per point by 
+    // a sweep or residual on a level, for profiling
+    inline void _restrict(Level level, FDArray& fine, FDArray& result);
+    inline double _sweep_bytes(const Level level);
+    
+    // Describes the output file, apart from the solution and residual 
+    // arrays. Subclasses can override this to rename variables or add 
+    // attributes.
+    virtual SolutionOutput _output(int numOfVariables, std::string root);
+
+    // Name of the solution variable in the output file, which is also the
+    // one initial_guess_from_file looks for first
+    virtual std::string solution_name() { return "solution"; }
+    
+    // Writes a checkpoint in the background if checkpointInterval seconds 
+    // have passed since the last one (or since the solver was built). Call 
+    // this between the outer iterations of a long solve.
+    void _checkpoint_if_due();
     
 private: 
     double residualSum, normSum;  
     Deriv du;
+    
+    // Background checkpoints
+    const double checkpointInterval; 
+    const std::string checkpointPath;
+    boost::posix_time::ptime lastCheckpoint;
+    boost::shared_ptr<OutputQueue> checkpointQueue;
 };    
 
 // Setters and getters           
@@ -82,6 +209,19 @@ template <typename T> inline void MultigridBase::initial_guess(T arg) {
     solution[finestLevel] = arg;
     initialIsSet = true;
 } 
+inline Stack& MultigridBase::get_solution() {
+    return solution;
+}
+inline const SolveResult& MultigridBase::solve_result() {
+    if (finalResidualPending) {
+        solveResult.finalResidual = _residual_norm(finestLevel);
+        finalResidualPending = false;
+    }
+    return solveResult;
+}
+inline Profiler& MultigridBase::profile() {
+    return profiler;
+}
 inline FDArray& MultigridBase::source_term() {
     return source[finestLevel];
 } 
@@ -92,15 +232,55 @@ template <typename T> inline void MultigridBase::source_term(T arg) {
 
 // Evaluation methods
 inline void MultigridBase::evaluate_operator(Level level, FDArray& result) {
+    PROFILE_SCOPE(profile, &profiler, residualPhase, level);
+    PROFILE_WORK(profile, result.size(), result.size()*_sweep_bytes(level));
     ARRAY_LOOP(result) 
         result(i, j) = differential_operator(level, i, j); 
 }   
 inline void MultigridBase::evaluate_residual(Level level, FDArray& result) {
-    ARRAY_LOOP(result)  
-        result(i, j) = source[level](i, j) 
-            - differential_operator(level, i, j); 
+    PROFILE_SCOPE(profile, &profiler, residualPhase, level);
+    PROFILE_WORK(profile, result.size(), result.size()*_sweep_bytes(level));
+    if (_is_galerkin_level(level)) {
+        coarseOperators.evaluate_residual(level, solution[level], 
+            source[level], result);
+        return;
+    }
+    if (tileSize > 0) {
+        TILED_ARRAY_LOOP(result, tileSize)
+            result(i, j) = source[level](i, j) 
+                - differential_operator(level, i, j); 
+    } else {
+        ARRAY_LOOP(result)  
+            result(i, j) = source[level](i, j) 
+                - differential_operator(level, i, j); 
+    }
 }   
 
+// Galerkin operator helpers
+inline bool MultigridBase::_is_galerkin_level(const Level level) {
+    return coarseOperatorsAreSet && (level < finestLevel);
+}
+inline void MultigridBase::_relaxation_updater(Level level, int i, int j) {
+    if (_is_galerkin_level(level)) 
+        coarseOperators.relaxation_updater(level, solution[level], 
+            source[level], i, j);
+    else 
+        relaxation_updater(level, i, j);
+}
+inline void MultigridBase::_restrict(Level level, FDArray& fine, 
+    FDArray& result) 
+{
+    PROFILE_SCOPE(profile, &profiler, restrictPhase, level);
+    PROFILE_WORK(profile, result.size(), 
+        (fine.size() + result.size())*sizeof(double));
+    restriction_operator(result, fine, tileSize);
+}
+inline double MultigridBase::_sweep_bytes(const Level level) {
+    // Solution read and written, and source read (with neighbouring points 
+    // in cache), plus nine stencil coefficients on Galerkin levels
+    return (_is_galerkin_level(level) ? 12 : 3)*sizeof(double);
+}
+
 } // end namespace mgrid
 
 #endif /* end of include guard: MULTIGRID_BASE_HPP_TVC215N7 */
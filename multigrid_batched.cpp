@@ -0,0 +1,381 @@
+/*
+    multigrid_batched.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Implementation of batched linear multigrid solver
+*/
+
+#include <cstdlib>
+
+#include "multigrid_batched.hpp"
+
+// = Batched transfer operators =
+void mgrid::batched_restriction(BatchArray& coarse, BatchArray& fine) {
+    const int nxc = coarse.extent(0), nzc = coarse.extent(1);
+    const int nxf = fine.extent(0), nzf = fine.extent(1);
+    const int K = coarse.extent(2);
+
+    // Fully weighted restriction, with the weights of any points which fall
+    // outside the fine grid dropped and the remainder renormalised. This
+    // gives the same weights as restriction_operator at edges and corners.
+    for (int I=0; I<nxc; I++) {
+        for (int J=0; J<nzc; J++) {
+            double* c = &coarse(I, J, 0);
+            double weightSum = 0;
+            for (int k=0; k<K; k++) c[k] = 0;
+            for (int a=-1; a<=1; a++) {
+                const int fi = 2*I + a;
+                if (fi < 0 || fi > nxf-1) continue;
+                for (int b=-1; b<=1; b++) {
+                    const int fj = 2*J + b;
+                    if (fj < 0 || fj > nzf-1) continue;
+                    const double weight = (2 - abs(a))*(2 - abs(b));
+                    const double* f = &fine(fi, fj, 0);
+                    for (int k=0; k<K; k++) c[k] += weight*f[k];
+                    weightSum += weight;
+                }
+            }
+            const double normalisation = 1/weightSum;
+            for (int k=0; k<K; k++) c[k] *= normalisation;
+        }
+    }
+}
+void mgrid::batched_interpolation(BatchArray& coarse, BatchArray& fine,
+    const BatchMask& mask)
+{
+    const int nxf = fine.extent(0), nzf = fine.extent(1);
+    const int K = fine.extent(2);
+    const double* m = mask.data();
+
+    // Bilinear interpolation: even points are copied, odd points averaged
+    for (int i=0; i<nxf; i++) {
+        const int I = i/2, In = (i%2 == 0) ? I : I+1;
+        for (int j=0; j<nzf; j++) {
+            const int J = j/2, Jn = (j%2 == 0) ? J : J+1;
+            double* f = &fine(i, j, 0);
+            const double* c00 = &coarse(I, J, 0);
+            const double* c10 = &coarse(In, J, 0);
+            const double* c01 = &coarse(I, Jn, 0);
+            const double* c11 = &coarse(In, Jn, 0);
+            if (In == I && Jn == J) {
+                for (int k=0; k<K; k++)
+                    f[k] = (m[k] != 0) ? c00[k] : f[k];
+            } else if (Jn == J) {
+                for (int k=0; k<K; k++)
+                    f[k] = (m[k] != 0) ? 0.5*(c00[k] + c10[k]) : f[k];
+            } else if (In == I) {
+                for (int k=0; k<K; k++)
+                    f[k] = (m[k] != 0) ? 0.5*(c00[k] + c01[k]) : f[k];
+            } else {
+                for (int k=0; k<K; k++)
+                    f[k] = (m[k] != 0)
+                        ? 0.25*(c11[k] + c10[k] + c01[k] + c00[k]) : f[k];
+            }
+        }
+    }
+}
+
+// = Batched derivatives =
+// These use the same (one-sided at the boundaries) differences as FDArray
+void mgrid::batched_dx(BatchArray& u, const double hx, BatchArray& result) {
+    const int nx = u.extent(0), nz = u.extent(1), K = u.extent(2);
+    const double xfactor = 1.0/(2*hx);
+    for (int i=0; i<nx; i++) {
+        for (int j=0; j<nz; j++) {
+            double* r = &result(i, j, 0);
+            if (i == 0) {
+                // forward difference in i
+                const double *u0 = &u(i, j, 0), *u1 = &u(i+1, j, 0);
+                const double *u2 = &u(i+2, j, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = (3*u0[k] - 4*u1[k] + u2[k])*xfactor;
+            } else if (i == nx-1) {
+                // backward difference in i
+                const double *u0 = &u(i, j, 0), *u1 = &u(i-1, j, 0);
+                const double *u2 = &u(i-2, j, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = (-u2[k] + 4*u1[k] - 3*u0[k])*xfactor;
+            } else {
+                // centered difference in i
+                const double *um = &u(i-1, j, 0), *up = &u(i+1, j, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = (um[k] - up[k])*xfactor;
+            }
+        }
+    }
+}
+void mgrid::batched_dz(BatchArray& u, const double hz, BatchArray& result) {
+    const int nx = u.extent(0), nz = u.extent(1), K = u.extent(2);
+    const double zfactor = 1.0/(2*hz);
+    for (int i=0; i<nx; i++) {
+        for (int j=0; j<nz; j++) {
+            double* r = &result(i, j, 0);
+            if (j == 0) {
+                // forward difference in j
+                const double *u0 = &u(i, j, 0), *u1 = &u(i, j+1, 0);
+                const double *u2 = &u(i, j+2, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = (-4*u1[k] + 3*u0[k] + u2[k])*zfactor;
+            } else if (j == nz-1) {
+                // backward difference in j
+                const double *u0 = &u(i, j, 0), *u1 = &u(i, j-1, 0);
+                const double *u2 = &u(i, j-2, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = (-u2[k] + 4*u1[k] - 3*u0[k])*zfactor;
+            } else {
+                // centered difference in j
+                const double *um = &u(i, j-1, 0), *up = &u(i, j+1, 0);
+                for (int k=0; k<K; k++)
+                    r[k] = -(up[k] - um[k])*zfactor;
+            }
+        }
+    }
+}
+
+// = BatchedStack =
+// Ctor
+mgrid::BatchedStack::BatchedStack(const Settings& s, Stack& prototype,
+    const int nInstances):
+    finestLevel(prototype.finestLevel), nInstances(nInstances),
+    prototype(prototype), aspect(s.aspectRatio), allInstances(nInstances)
+{
+    // Generate grid stack with the same shapes as the prototype
+    resize(prototype.size());
+    for (Level level=coarsestLevel; level<=finestLevel; level++) {
+        (*this)[level].resize(prototype[level].rows(),
+            prototype[level].columns(), nInstances);
+        (*this)[level] = 0;
+    }
+    allInstances = 1;
+}
+
+// Reference to a single instance
+mgrid::FDArray mgrid::BatchedStack::instance(Level level, const int k) {
+    FDArray result;
+    result.calculate_geometry(aspect, (*this)[level].extent(0),
+        (*this)[level].extent(1));
+    result.reference(
+        (*this)[level](blitz::Range::all(), blitz::Range::all(), k));
+    return result;
+}
+
+// Boundary condition updates, pointwise from the prototype's conditions
+void mgrid::BatchedStack::update_boundaries(Level level) {
+    BatchArray& u = (*this)[level];
+    const int nx = u.extent(0), nz = u.extent(1), K = nInstances;
+    const double hx = prototype[level].spacing(0);
+    const double hz = prototype[level].spacing(1);
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags) {
+        // Assign variable values depending on which boundary we are at
+        int i0, j0, di, dj, dx, dz, sign, length; double spacing;
+        if (boundaryFlag == leftBoundary) {
+            i0 = 0; j0 = 0; di = 0; dj = 1; length = nz;
+            dx = 1; dz = 0; sign = -1; spacing = hx;
+        } else if (boundaryFlag == rightBoundary) {
+            i0 = nx-1; j0 = 0; di = 0; dj = 1; length = nz;
+            dx = -1; dz = 0; sign = 1; spacing = hx;
+        } else if (boundaryFlag == topBoundary) {
+            i0 = 0; j0 = 0; di = 1; dj = 0; length = nx;
+            dx = 0; dz = 1; sign = -1; spacing = hz;
+        } else {
+            i0 = 0; j0 = nz-1; di = 1; dj = 0; length = nx;
+            dx = 0; dz = -1; sign = 1; spacing = hz;
+        }
+
+        // Actually perform update
+        Boundary& boundary = prototype[level].boundaryConditions.get(boundaryFlag);
+        for (int n=0; n<length; n++) {
+            const int i = i0 + n*di, j = j0 + n*dj;
+            const BoundaryPoint& pt = boundary(n);
+            double* b = &u(i, j, 0);
+            if (pt.conditionType == dirichlet) {
+                for (int k=0; k<K; k++) b[k] = pt.value;
+            } else if (pt.conditionType == neumann) {
+                const double* u1 = &u(i+dx, j+dz, 0);
+                const double* u2 = &u(i+2*dx, j+2*dz, 0);
+                const double* u3 = &u(i+3*dx, j+3*dz, 0);
+                const double* u4 = &u(i+4*dx, j+4*dz, 0);
+                const double flux = sign*12*(pt.value)*spacing;
+                for (int k=0; k<K; k++)
+                    b[k] = (flux + 48*u1[k] - 36*u2[k] + 16*u3[k]
+                        - 3*u4[k])/25.0;
+            }
+        }
+    }
+}
+
+// = BatchedLinearMultigrid =
+// Ctor
+mgrid::BatchedLinearMultigrid::BatchedLinearMultigrid(const Settings& settings,
+    MultigridBase& prototype, const int nInstances):
+    nInstances(nInstances),
+    solution(settings, prototype.get_solution(), nInstances),
+    source(settings, prototype.get_solution(), nInstances),
+    temp(settings, prototype.get_solution(), nInstances),
+    activeMask(nInstances),
+    cycleType(settings.mgCycleType),
+    preRelax(settings.preMGRelaxIter),
+    postRelax(settings.postMGRelaxIter),
+    residualTolerance(settings.residualTolerance),
+    maxIterations(settings.maximumIterations),
+    finestLevel(solution.finestLevel),
+    coarsestLevel(solution.coarsestLevel),
+    sourceIsSet(false)
+{
+    // Take stencils on every level from the prototype's operator
+    operators.resize(prototype.get_solution());
+    prototype.probe_operator(operators[finestLevel]);
+    for (Level level=finestLevel; level>coarsestLevel; level--)
+        operators.galerkin_coarsen(level);
+    activeMask = 1;
+}
+
+// Convergence masks
+int mgrid::BatchedLinearMultigrid::number_active() {
+    int result = 0;
+    for (int k=0; k<nInstances; k++)
+        if (activeMask(k) != 0) result++;
+    return result;
+}
+
+// Residual evaluation, zero on the boundaries as for StencilStack
+void mgrid::BatchedLinearMultigrid::evaluate_residual(Level level,
+    BatchArray& result)
+{
+    BatchArray& u = solution[level];
+    BatchArray& f = source[level];
+    const StencilArray& a = operators[level];
+    const int nx = u.extent(0), nz = u.extent(1), K = nInstances;
+    result = 0;
+    for (int i=1; i<nx-1; i++) {
+        for (int j=1; j<nz-1; j++) {
+            const double* s = &a(i, j, 0);
+            const double *um = &u(i-1, j-1, 0), *u0 = &u(i, j-1, 0);
+            const double *up = &u(i+1, j-1, 0), *fp = &f(i, j, 0);
+            double* r = &result(i, j, 0);
+            for (int k=0; k<K; k++)
+                r[k] = fp[k]
+                    - (s[0]*um[k] + s[1]*um[k+K] + s[2]*um[k+2*K]
+                    + s[3]*u0[k] + s[4]*u0[k+K] + s[5]*u0[k+2*K]
+                    + s[6]*up[k] + s[7]*up[k+K] + s[8]*up[k+2*K]);
+        }
+    }
+}
+
+// Relaxation methods
+void mgrid::BatchedLinearMultigrid::_relaxation_sweep(Level level,
+    const BatchMask& mask, BatchMask& changeSum, BatchMask& normSum)
+{
+    BatchArray& u = solution[level];
+    BatchArray& f = source[level];
+    const StencilArray& a = operators[level];
+    const int K = nInstances;
+    const double* m = mask.data();
+    double* dsum = changeSum.data();
+    double* nsum = normSum.data();
+    changeSum = 0; normSum = 0;
+    RED_BLACK_LOOP(u) {
+        // Pointers to the start of each row of the 3x3 neighbourhood,
+        // with the instances of neighbouring columns K apart
+        const double* s = &a(i, j, 0);
+        double* um = &u(i-1, j-1, 0);
+        double* u0 = &u(i, j-1, 0);
+        double* up = &u(i+1, j-1, 0);
+        const double* fp = &f(i, j, 0);
+        for (int k=0; k<K; k++) {
+            const double update = (fp[k]
+                - (s[0]*um[k] + s[1]*um[k+K] + s[2]*um[k+2*K]
+                + s[3]*u0[k] + s[4]*u0[k+K] + s[5]*u0[k+2*K]
+                + s[6]*up[k] + s[7]*up[k+K] + s[8]*up[k+2*K]))/s[4];
+            const double value = (m[k] != 0) ? u0[k+K] + update : u0[k+K];
+            dsum[k] += power<2>(value - u0[k+K]);
+            nsum[k] += power<2>(value);
+            u0[k+K] = value;
+        }
+    }
+}
+void mgrid::BatchedLinearMultigrid::relax(const Level level,
+    const unsigned long N)
+{
+    // Relax active instances for N iterations
+    BatchMask changeSum(nInstances), normSum(nInstances);
+    for (unsigned long iter=0; iter<N; iter++) {
+        _relaxation_sweep(level, activeMask, changeSum, normSum);
+        solution.update_boundaries(level);
+    }
+}
+void mgrid::BatchedLinearMultigrid::relax(const Level level,
+    const double tolerance)
+{
+    // Relax until each active instance reaches the specified tolerance,
+    // masking off instances as they converge
+    BatchMask changeSum(nInstances), normSum(nInstances), mask(nInstances);
+    mask = activeMask;
+    for (unsigned long iter=0; iter<maxIterations; iter++) {
+        _relaxation_sweep(level, mask, changeSum, normSum);
+        solution.update_boundaries(level);
+
+        // Check for convergence
+        int nUnconverged = 0;
+        for (int k=0; k<nInstances; k++) {
+            if (mask(k) == 0) continue;
+            if ((sqrt(changeSum(k))/sqrt(normSum(k))) < tolerance) mask(k) = 0;
+            else nUnconverged++;
+        }
+        if (nUnconverged == 0) return;
+    }
+}
+
+// Multigrid method, following LinearMultigrid::multigrid
+void mgrid::BatchedLinearMultigrid::multigrid() {
+    // Check that source array has been set
+    if (not(sourceIsSet)) return;
+
+    // Initialise right-hand-side
+    for (Level level=finestLevel; level>0; level--) {
+        source.coarsen(level);
+        solution.coarsen(level);
+    }
+
+    // Solve on coarsest level
+    relax(coarsestLevel, residualTolerance);
+
+    // Full Multigrid loop
+    const int K = nInstances;
+    for (Level fineLevel=1; fineLevel<=finestLevel; fineLevel++) {
+        // V-cycle loop at each (successively finer) level
+        solution.refine(fineLevel-1, activeMask);
+        for (int cycle=0; cycle < cycleType; cycle++) {
+            // Downstroke of cycle
+            for (Level level=fineLevel; level>0; level--) {
+                relax(level, preRelax);
+                evaluate_residual(level, temp[level]);
+                temp.coarsen(level, source[level-1]);
+                solution[level-1] = 0; // initialise next level's residual
+            }
+
+            // Solve problem on coarsest level
+            relax(coarsestLevel, residualTolerance);
+
+            // Upstroke of cycle: correct active instances only
+            for (Level level=1; level<=fineLevel; level++) {
+                solution.refine(level-1, temp[level]);
+                BatchArray& u = solution[level];
+                BatchArray& correction = temp[level];
+                const double* m = activeMask.data();
+                const int nx = u.extent(0), nz = u.extent(1);
+                for (int i=0; i<nx; i++) for (int j=0; j<nz; j++) {
+                    double* up = &u(i, j, 0);
+                    const double* cp = &correction(i, j, 0);
+                    for (int k=0; k<K; k++)
+                        up[k] = (m[k] != 0) ? up[k] + cp[k] : up[k];
+                }
+                relax(level, postRelax);
+            }
+        }
+    }
+
+    // Do final update
+    relax(finestLevel, postRelax);
+    solution.update_boundaries(finestLevel);
+}
@@ -0,0 +1,173 @@
+/*
+    multigrid_batched.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Linear multigrid solver for a batch of problems which share a grid,
+    boundary conditions and differential operator, but differ in their
+    source terms (and so in their solutions).
+*/
+
+#ifndef MULTIGRID_BATCHED_HPP_8HB2WQ5N
+#define MULTIGRID_BATCHED_HPP_8HB2WQ5N
+
+#include <vector>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "utilities.hpp"
+#include "fdarray.hpp"
+#include "stack.hpp"
+#include "stencil.hpp"
+#include "settings.hpp"
+#include "multigrid_base.hpp"
+
+namespace mgrid {
+
+// Batched arrays store the instance index fastest, i.e. as [nx][nz][K], so
+// that every pointwise operation is a unit-stride loop over the instances.
+typedef blitz::Array<double, 3> BatchArray;
+typedef blitz::Array<double, 1> BatchMask;
+
+// = Batched transfer and derivative operators =
+/*  These mirror restriction_operator, interpolation_operator, FDArray::dx and
+    FDArray::dz, but act on all instances at each point. Interpolation only
+    overwrites instances with a nonzero mask entry.
+*/
+void batched_restriction(BatchArray& coarse, BatchArray& fine);
+void batched_interpolation(BatchArray& coarse, BatchArray& fine,
+    const BatchMask& mask);
+void batched_dx(BatchArray& u, const double hx, BatchArray& result);
+void batched_dz(BatchArray& u, const double hz, BatchArray& result);
+
+// = BatchedStack class interface =
+class BatchedStack: public std::vector<BatchArray> {
+public:
+    BatchedStack(const Settings& s, Stack& prototype, const int nInstances);
+    virtual ~BatchedStack() {};
+
+    // Some useful attributes
+    const Level finestLevel;              // level of finest grid
+    static const Level coarsestLevel = 0; // level of coarsest grid
+    const int nInstances;                 // number of problems in the batch
+
+    // The given instance on a level, as an FDArray referencing this stack
+    FDArray instance(Level level, const int k);
+
+    // Transfer methods
+    inline void coarsen(Level level);
+    inline void coarsen(Level level, BatchArray& result);
+    inline void refine(Level level, const BatchMask& mask);
+    inline void refine(Level level, BatchArray& result);
+
+    // Boundary conditions are those of the prototype stack
+    void update_boundaries(Level level);
+
+private:
+    Stack& prototype;
+    const double aspect;
+    BatchMask allInstances;
+};
+
+// = Inline methods for BatchedStack class =
+inline void BatchedStack::coarsen(Level level) {
+    batched_restriction((*this)[level - 1], (*this)[level]);
+}
+inline void BatchedStack::coarsen(Level level, BatchArray& result) {
+    batched_restriction(result, (*this)[level]);
+}
+inline void BatchedStack::refine(Level level, const BatchMask& mask) {
+    batched_interpolation((*this)[level], (*this)[level + 1], mask);
+}
+inline void BatchedStack::refine(Level level, BatchArray& result) {
+    batched_interpolation((*this)[level], result, allInstances);
+}
+
+// = BatchedLinearMultigrid class interface =
+/*  The operator is taken from a prototype solver: its differential operator
+    is probed on the finest level and coarsened with the Galerkin product, so
+    every level (including the finest) is relaxed with the stored stencils.
+    The prototype also provides the boundary conditions, so these should be
+    set before constructing the batch.
+
+    Instances can be switched off with set_active - their solutions are then
+    left untouched by multigrid(). The coarse grid solve also masks off each
+    instance as soon as it has converged.
+*/
+class BatchedLinearMultigrid {
+public:
+    BatchedLinearMultigrid(const Settings& settings, MultigridBase& prototype,
+        const int nInstances);
+    virtual ~BatchedLinearMultigrid() {};
+
+    // Setters and getters
+    inline FDArray get_result(const int k);
+    inline FDArray source_term(const int k);
+    template <typename T> inline void source_term(const int k, T arg);
+    template <typename T> inline void initial_guess(const int k, T arg);
+
+    // Convergence masks
+    inline void set_active(const int k, const bool active);
+    inline bool is_active(const int k);
+    int number_active();
+
+    // Evaluation and relaxation methods
+    void evaluate_residual(Level level, BatchArray& result);
+    void relax(const Level level, const unsigned long N);
+    void relax(const Level level, const double tolerance);
+
+    // Multigrid solver method
+    virtual void multigrid();
+
+    // Number of instances in the batch
+    const int nInstances;
+
+protected:
+    // Data
+    BatchedStack solution, source;  // Grids for solution and source term
+    BatchedStack temp;              // Extra storage for multigrid solver
+    StencilStack operators;         // Stencils on every level
+    BatchMask activeMask;           // One for active instances, else zero
+    const int cycleType;            // Type of FMG-cycling used
+    const unsigned long preRelax;   // Num of pre-corection relaxations to use
+    const unsigned long postRelax;  // Num of post-corection relaxations to use
+    const double residualTolerance; // For convergence testing
+    const double maxIterations;     // Maxium number of iterations allowed
+    int finestLevel, coarsestLevel;
+    bool sourceIsSet;               // Have the source terms been provided?
+
+    // Red-black sweep over active instances, accumulating the squared change
+    // and squared solution for each instance
+    void _relaxation_sweep(Level level, const BatchMask& mask,
+        BatchMask& changeSum, BatchMask& normSum);
+};
+
+// Setters and getters
+inline FDArray BatchedLinearMultigrid::get_result(const int k) {
+    return solution.instance(finestLevel, k);
+}
+inline FDArray BatchedLinearMultigrid::source_term(const int k) {
+    return source.instance(finestLevel, k);
+}
+template <typename T>
+inline void BatchedLinearMultigrid::source_term(const int k, T arg) {
+    FDArray instance = source.instance(finestLevel, k);
+    instance = arg;
+    sourceIsSet = true;
+}
+template <typename T>
+inline void BatchedLinearMultigrid::initial_guess(const int k, T arg) {
+    FDArray instance = solution.instance(finestLevel, k);
+    instance = arg;
+}
+
+// Convergence masks
+inline void BatchedLinearMultigrid::set_active(const int k, const bool active) {
+    activeMask(k) = active ? 1 : 0;
+}
+inline bool BatchedLinearMultigrid::is_active(const int k) {
+    return activeMask(k) != 0;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: MULTIGRID_BATCHED_HPP_8HB2WQ5N */
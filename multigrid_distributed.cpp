@@ -0,0 +1,668 @@
+/*
+    multigrid_distributed.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Implementation of DistributedStack and DistributedLinearMultigrid classes
+*/
+
+#include <algorithm>
+
+#include "multigrid_distributed.hpp"
+
+// = Point operators =
+// Full weighting restriction onto the coarse point above fine point (i, j),
+// with the same arithmetic as restriction_operator. The flags say which
+// edges of the grid the coarse point is on.
+static inline double restrict_point(blitz::Array<double, 2>& f,
+    const int i, const int j, const bool left, const bool right,
+    const bool top, const bool bottom)
+{
+    if (left && top)
+        return (4*f(i,j) + 2*(f(i+1,j) + f(i,j+1)) + 1*f(i+1,j+1))/9.0;
+    else if (right && top)
+        return (4*f(i,j) + 2*(f(i-1,j) + f(i,j+1)) + 1*f(i-1,j+1))/9.0;
+    else if (left && bottom)
+        return (4*f(i,j) + 2*(f(i+1,j) + f(i,j-1)) + 1*f(i+1,j-1))/9.0;
+    else if (right && bottom)
+        return (4*f(i,j) + 2*(f(i-1,j) + f(i,j-1)) + 1*f(i-1,j-1))/9.0;
+    else if (top)
+        return (4*f(i,j) + 2*(f(i-1,j) + f(i+1,j) + f(i,j+1))
+            + 1*(f(i-1,j+1) + f(i+1,j+1)))/12.0;
+    else if (bottom)
+        return (4*f(i,j) + 2*(f(i-1,j) + f(i+1,j) + f(i,j-1))
+            + 1*(f(i-1,j-1) + f(i+1,j-1)))/12.0;
+    else if (left)
+        return (4*f(i,j) + 2*(f(i,j-1) + f(i,j+1) + f(i+1,j))
+            + 1*(f(i+1,j-1) + f(i+1,j+1)))/12.0;
+    else if (right)
+        return (4*f(i,j) + 2*(f(i,j-1) + f(i,j+1) + f(i-1,j))
+            + 1*(f(i-1,j-1) + f(i-1,j+1)))/12.0;
+    else
+        return (4*(f(i,j))
+            + 2*(f(i+1,j) + f(i-1,j)+ f(i,j+1) + f(i,j-1))
+            + 1*(f(i+1,j+1) + f(i+1,j-1) + f(i-1,j+1) + f(i-1,j-1)))/16.0;
+}
+
+// Bilinear interpolation onto fine point (i, j) in global indices, with the
+// same arithmetic as interpolation_operator. (ox, oz) is the global index of
+// the coarse block's first point.
+static inline double interpolate_point(blitz::Array<double, 2>& c,
+    const int i, const int j, const int ox, const int oz)
+{
+    const int I = i/2 - ox, J = j/2 - oz;
+    if (i % 2 == 0) {
+        if (j % 2 == 0) return c(I, J);
+        else return 0.5*(c(I, J) + c(I, J+1));
+    } else {
+        if (j % 2 == 0) return 0.5*(c(I, J) + c(I+1, J));
+        else return 0.25*(c(I+1, J+1) + c(I+1, J) + c(I, J+1) + c(I, J));
+    }
+}
+
+// Swap one line of the array with a neighbour. Lines run along the other
+// dimension from dim, and cover the whole local array including halos.
+static void exchange_line(mgrid::FDArray& array, const int dim,
+    const int sendLine, const int receiveLine, const int destination,
+    const int origin, MPI_Comm comm)
+{
+    const int length = array.extent(1 - dim);
+    std::vector<double> sendBuffer(length), receiveBuffer(length);
+    for (int k=0; k<length; k++)
+        sendBuffer[k] = (dim == 0) ? array(sendLine, k) : array(k, sendLine);
+    MPI_Sendrecv(&sendBuffer[0], length, MPI_DOUBLE, destination, 0,
+        &receiveBuffer[0], length, MPI_DOUBLE, origin, 0, comm,
+        MPI_STATUS_IGNORE);
+    if (origin == MPI_PROC_NULL) return;
+    for (int k=0; k<length; k++) {
+        if (dim == 0) array(receiveLine, k) = receiveBuffer[k];
+        else array(k, receiveLine) = receiveBuffer[k];
+    }
+}
+
+// = DistributedStack =
+// Ctor
+mgrid::DistributedStack::DistributedStack(const Settings& s, MPI_Comm comm):
+    finestLevel(s.numberOfGrids-1)
+{
+    // Set up a grid of processes to suit the finest level
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &numberOfProcesses);
+    int nx, nz;
+    boost::tie(nx, nz) = grid_shape(s, finestLevel);
+    _choose_process_grid(nx, nz);
+    int periods[2] = {0, 0};
+    MPI_Cart_create(comm, 2, dims, periods, 0, &gridComm);
+    MPI_Cart_coords(gridComm, rank, 2, coords);
+    for (int dim=0; dim<2; dim++)
+        MPI_Cart_shift(gridComm, dim, 1,
+            &lowerNeighbour[dim], &upperNeighbour[dim]);
+
+    // Boundary conditions need five points normal to each edge to be on one
+    // process
+    const int minimumSize = std::max(5, s.agglomerationSize);
+
+    // Decompose levels from finest to coarsest, agglomerating once blocks
+    // get too small
+    resize(s.numberOfGrids);
+    layouts.resize(s.numberOfGrids);
+    bool distributed = true;
+    for (Level level=finestLevel; level>=coarsestLevel; level--) {
+        BlockLayout& layout = layouts[level];
+        boost::tie(layout.nx, layout.nz) = grid_shape(s, level);
+        layout.xStarts.resize(dims[0] + 1);
+        layout.zStarts.resize(dims[1] + 1);
+        for (int p=0; p<=dims[0]; p++) layout.xStarts[p] =
+            (level == finestLevel) ? int(long(p)*layout.nx/dims[0])
+                : (layouts[level+1].xStarts[p] + 1)/2;
+        for (int p=0; p<=dims[1]; p++) layout.zStarts[p] =
+            (level == finestLevel) ? int(long(p)*layout.nz/dims[1])
+                : (layouts[level+1].zStarts[p] + 1)/2;
+        for (int p=0; p<dims[0]; p++)
+            if (layout.xStarts[p+1] - layout.xStarts[p] < minimumSize)
+                distributed = false;
+        for (int p=0; p<dims[1]; p++)
+            if (layout.zStarts[p+1] - layout.zStarts[p] < minimumSize)
+                distributed = false;
+
+        // Work out which points we own, and halos
+        layout.distributed = distributed;
+        int nxLocal, nzLocal;
+        if (distributed) {
+            layout.active = true;
+            layout.i0 = layout.xStarts[coords[0]];
+            layout.i1 = layout.xStarts[coords[0] + 1];
+            layout.j0 = layout.zStarts[coords[1]];
+            layout.j1 = layout.zStarts[coords[1] + 1];
+            layout.xOffset = (layout.i0 > 0) ? layout.i0 - 1 : 0;
+            layout.zOffset = (layout.j0 > 0) ? layout.j0 - 1 : 0;
+            nxLocal = std::min(layout.i1 + 1, layout.nx) - layout.xOffset;
+            nzLocal = std::min(layout.j1 + 1, layout.nz) - layout.zOffset;
+        } else {
+            layout.active = (rank == 0);
+            layout.i0 = 0; layout.i1 = layout.nx;
+            layout.j0 = 0; layout.j1 = layout.nz;
+            layout.xOffset = 0; layout.zOffset = 0;
+            nxLocal = layout.nx; nzLocal = layout.nz;
+        }
+        if (layout.active) {
+            (*this)[level].resize_block(s.aspectRatio/double(layout.nx-1),
+                1/double(layout.nz-1), nxLocal, nzLocal);
+            (*this)[level] = 0;
+        }
+    }
+
+    // Set default boundary conditions
+    boundaryConditions.apply_default_conditions(nx, nz);
+}
+mgrid::DistributedStack::~DistributedStack() {
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (not(finalized)) MPI_Comm_free(&gridComm);
+}
+
+// Choose the process grid with the shortest total length of block edges
+void mgrid::DistributedStack::_choose_process_grid(const int nx, const int nz)
+{
+    long bestCost = -1;
+    for (int px=1; px<=numberOfProcesses; px++) {
+        if (numberOfProcesses % px != 0) continue;
+        const int pz = numberOfProcesses/px;
+        const long cost = long(px - 1)*nz + long(pz - 1)*nx;
+        if (bestCost < 0 || cost < bestCost) {
+            bestCost = cost;
+            dims[0] = px;
+            dims[1] = pz;
+        }
+    }
+}
+
+// Communication
+void mgrid::DistributedStack::exchange_halos(Level level) {
+    exchange_halos(level, (*this)[level]);
+}
+void mgrid::DistributedStack::exchange_halos(Level level, FDArray& array) {
+    if (not(layouts[level].distributed)) return;
+
+    // Swap rows first, then columns (including the halo rows just received)
+    // so that the corners of the halo are filled too
+    for (int dim=0; dim<2; dim++) {
+        const int firstOwned = first(level, dim), lastOwned = last(level, dim);
+        exchange_line(array, dim, firstOwned, lastOwned,
+            lowerNeighbour[dim], upperNeighbour[dim], gridComm);
+        exchange_line(array, dim, lastOwned - 1, firstOwned - 1,
+            upperNeighbour[dim], lowerNeighbour[dim], gridComm);
+    }
+}
+void mgrid::DistributedStack::sum(Level level, double* values,
+    const int count)
+{
+    if (layouts[level].distributed && numberOfProcesses > 1)
+        MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM,
+            gridComm);
+}
+
+// Transfer methods
+void mgrid::DistributedStack::restriction(Level level, FDArray& fine,
+    FDArray& coarse)
+{
+    const BlockLayout& f = layouts[level];
+    const BlockLayout& c = layouts[level-1];
+    if (not(f.distributed)) {
+        if (f.active) restriction_operator(coarse, fine);
+        return;
+    }
+    exchange_halos(level, fine);
+
+    // Coarse points on top of the fine points we own. If the coarse level is
+    // agglomerated these are collected into a block to send on.
+    const int I0 = (f.i0 + 1)/2, I1 = (f.i1 + 1)/2;
+    const int J0 = (f.j0 + 1)/2, J1 = (f.j1 + 1)/2;
+    blitz::Array<double, 2> block;
+    int bx, bz;
+    if (c.distributed) {
+        block.reference(coarse);
+        bx = c.xOffset; bz = c.zOffset;
+    } else {
+        block.resize(I1 - I0, J1 - J0);
+        bx = I0; bz = J0;
+    }
+    for (int I=I0; I<I1; I++)
+        for (int J=J0; J<J1; J++)
+            block(I - bx, J - bz) = restrict_point(fine,
+                2*I - f.xOffset, 2*J - f.zOffset,
+                I == 0, I == c.nx - 1, J == 0, J == c.nz - 1);
+    if (not(c.distributed)) _gather(level-1, block, I0, J0, coarse);
+}
+void mgrid::DistributedStack::interpolation(Level level, FDArray& coarse,
+    FDArray& fine)
+{
+    const BlockLayout& c = layouts[level];
+    const BlockLayout& f = layouts[level+1];
+    if (not(f.distributed)) {
+        if (f.active) interpolation_operator(coarse, fine);
+        return;
+    }
+
+    // Get the coarse points around the fine points we own
+    blitz::Array<double, 2> block;
+    int bx, bz;
+    if (c.distributed) {
+        exchange_halos(level, coarse);
+        block.reference(coarse);
+        bx = c.xOffset; bz = c.zOffset;
+    } else {
+        _scatter(level, coarse, block, bx, bz);
+    }
+    for (int i=f.i0; i<f.i1; i++)
+        for (int j=f.j0; j<f.j1; j++)
+            fine(i - f.xOffset, j - f.zOffset)
+                = interpolate_point(block, i, j, bx, bz);
+}
+
+// Collect restricted blocks onto an agglomerated level on the first process
+void mgrid::DistributedStack::_gather(Level level,
+    blitz::Array<double, 2>& block, const int I0, const int J0,
+    FDArray& coarse)
+{
+    const BlockLayout& f = layouts[level+1];
+    std::vector<double> buffer;
+    if (rank != 0) {
+        buffer.reserve(block.rows()*block.columns());
+        for (int i=0; i<block.rows(); i++)
+            for (int j=0; j<block.columns(); j++)
+                buffer.push_back(block(i, j));
+        MPI_Send(&buffer[0], int(buffer.size()), MPI_DOUBLE, 0, level,
+            gridComm);
+        return;
+    }
+    for (int source=0; source<numberOfProcesses; source++) {
+        int sourceCoords[2];
+        MPI_Cart_coords(gridComm, source, 2, sourceCoords);
+        const int sI0 = (f.xStarts[sourceCoords[0]] + 1)/2;
+        const int sI1 = (f.xStarts[sourceCoords[0] + 1] + 1)/2;
+        const int sJ0 = (f.zStarts[sourceCoords[1]] + 1)/2;
+        const int sJ1 = (f.zStarts[sourceCoords[1] + 1] + 1)/2;
+        if (source == 0) {
+            for (int I=sI0; I<sI1; I++)
+                for (int J=sJ0; J<sJ1; J++)
+                    coarse(I, J) = block(I - I0, J - J0);
+            continue;
+        }
+        buffer.resize((sI1 - sI0)*(sJ1 - sJ0));
+        MPI_Recv(&buffer[0], int(buffer.size()), MPI_DOUBLE, source, level,
+            gridComm, MPI_STATUS_IGNORE);
+        int k = 0;
+        for (int I=sI0; I<sI1; I++)
+            for (int J=sJ0; J<sJ1; J++)
+                coarse(I, J) = buffer[k++];
+    }
+}
+
+// Hand out the coarse points each process needs to interpolate from an
+// agglomerated level. I0 and J0 return the global index of block(0, 0).
+void mgrid::DistributedStack::_scatter(Level level, FDArray& coarse,
+    blitz::Array<double, 2>& block, int& I0, int& J0)
+{
+    const BlockLayout& f = layouts[level+1];
+    std::vector<double> buffer;
+    for (int destination=0; destination<numberOfProcesses; destination++) {
+        if (rank != 0 && destination != rank) continue;
+        int destCoords[2];
+        MPI_Cart_coords(gridComm, destination, 2, destCoords);
+        const int dI0 = f.xStarts[destCoords[0]]/2;
+        const int dI1 = f.xStarts[destCoords[0] + 1]/2 + 1;
+        const int dJ0 = f.zStarts[destCoords[1]]/2;
+        const int dJ1 = f.zStarts[destCoords[1] + 1]/2 + 1;
+        buffer.resize((dI1 - dI0)*(dJ1 - dJ0));
+        if (rank == 0) {
+            int k = 0;
+            for (int I=dI0; I<dI1; I++)
+                for (int J=dJ0; J<dJ1; J++)
+                    buffer[k++] = coarse(I, J);
+            if (destination != 0) {
+                MPI_Send(&buffer[0], int(buffer.size()), MPI_DOUBLE,
+                    destination, level, gridComm);
+                continue;
+            }
+        } else {
+            MPI_Recv(&buffer[0], int(buffer.size()), MPI_DOUBLE, 0, level,
+                gridComm, MPI_STATUS_IGNORE);
+        }
+
+        // Unpack our own block
+        block.resize(dI1 - dI0, dJ1 - dJ0);
+        int k = 0;
+        for (int I=0; I<block.rows(); I++)
+            for (int J=0; J<block.columns(); J++)
+                block(I, J) = buffer[k++];
+        I0 = dI0; J0 = dJ0;
+    }
+}
+
+// Boundary conditions
+void mgrid::DistributedStack::update_boundaries(Level level) {
+    const BlockLayout& layout = layouts[level];
+    if (not(layout.active)) return;
+    FDArray& u = (*this)[level];
+    const int stride = 1 << (finestLevel - level);
+
+    // Same order as FDArray::update_boundaries, so corners end up the same
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags) {
+        bool onEdge; int dx = 0, dz = 0, sign; double spacing;
+        if (boundaryFlag == leftBoundary) {
+            onEdge = (layout.i0 == 0);  dx = 1;  sign = -1;
+            spacing = u.spacing(0);
+        } else if (boundaryFlag == rightBoundary) {
+            onEdge = (layout.i1 == layout.nx);  dx = -1;  sign = 1;
+            spacing = u.spacing(0);
+        } else if (boundaryFlag == topBoundary) {
+            onEdge = (layout.j0 == 0);  dz = 1;  sign = -1;
+            spacing = u.spacing(1);
+        } else {
+            onEdge = (layout.j1 == layout.nz);  dz = -1;  sign = 1;
+            spacing = u.spacing(1);
+        }
+        if (not(onEdge)) continue;
+
+        // Loop over our points on the edge
+        Boundary& conditions = boundaryConditions.get(boundaryFlag);
+        const int along = (dx != 0) ? 1 : 0;
+        for (int k=first(level, along); k<last(level, along); k++) {
+            int i, j, globalIndex;
+            if (dx != 0) {
+                i = (dx > 0) ? 0 : layout.nx - 1 - layout.xOffset;
+                j = k;  globalIndex = k + layout.zOffset;
+            } else {
+                i = k;  globalIndex = k + layout.xOffset;
+                j = (dz > 0) ? 0 : layout.nz - 1 - layout.zOffset;
+            }
+            const BoundaryPoint& pt = conditions(globalIndex*stride);
+            if (pt.conditionType == dirichlet) {
+                u(i, j) = pt.value;
+            } else if (pt.conditionType == neumann) {
+                u(i, j) = (sign*12*(pt.value)*spacing
+                    + 48*u(i+dx, j+dz) - 36*u(i+2*dx, j+2*dz)
+                    + 16*u(i+3*dx, j+3*dz) - 3*u(i+4*dx, j+4*dz))/25.0;
+            }
+        }
+    }
+}
+
+// = DistributedLinearMultigrid =
+// Ctor
+mgrid::DistributedLinearMultigrid::DistributedLinearMultigrid(
+    const Settings& settings, MPI_Comm comm):
+    solution(settings, comm),
+    source(settings, comm),
+    temp(settings, comm),
+    cycleType(settings.mgCycleType),
+    preRelax(settings.preMGRelaxIter),
+    postRelax(settings.postMGRelaxIter),
+    residualTolerance(settings.residualTolerance),
+    maxIterations(settings.maximumIterations),
+    aspect(settings.aspectRatio),
+    sourceIsSet(false),
+    initialIsSet(false)
+{
+    finestLevel = solution.finestLevel;
+    coarsestLevel = solution.coarsestLevel;
+
+    // Warn if there are too many processes to use
+    if (not(solution.is_distributed(finestLevel)) 
+        && solution.numberOfProcesses > 1 && solution.rank == 0)
+    {
+        Message msg(WarningMessage);
+        msg << "Finest grid is too small to split between "
+            << solution.numberOfProcesses << " processes, solving on one." 
+            << std::endl;
+        std::cout << msg.str(); std::cout.flush();
+    }
+}
+
+// Setters
+void mgrid::DistributedLinearMultigrid::source_term(const double value) {
+    if (source.is_active(finestLevel)) source[finestLevel] = value;
+    sourceIsSet = true;
+}
+void mgrid::DistributedLinearMultigrid::source_term(
+    boost::function<double (double, double)> f)
+{
+    _assign(finestLevel, source[finestLevel], f);
+    sourceIsSet = true;
+}
+void mgrid::DistributedLinearMultigrid::initial_guess(const double value) {
+    if (solution.is_active(finestLevel)) solution[finestLevel] = value;
+    initialIsSet = true;
+}
+void mgrid::DistributedLinearMultigrid::initial_guess(
+    boost::function<double (double, double)> f)
+{
+    _assign(finestLevel, solution[finestLevel], f);
+    initialIsSet = true;
+}
+void mgrid::DistributedLinearMultigrid::_assign(Level level, FDArray& array,
+    boost::function<double (double, double)> f)
+{
+    if (not(solution.is_active(level))) return;
+    const double hx = array.spacing(0), hz = array.spacing(1);
+    const int xOffset = solution.offset(level, 0);
+    const int zOffset = solution.offset(level, 1);
+    ARRAY_LOOP(array)
+        array(i, j) = f((i + xOffset)*hx, (j + zOffset)*hz);
+}
+
+// Evaluation methods
+void mgrid::DistributedLinearMultigrid::evaluate_residual(Level level,
+    FDArray& result)
+{
+    if (not(solution.is_active(level))) return;
+    solution.exchange_halos(level);
+    for (int i=solution.first(level, 0); i<solution.last(level, 0); i++)
+        for (int j=solution.first(level, 1); j<solution.last(level, 1); j++)
+            result(i, j) = source[level](i, j)
+                - differential_operator(level, i, j);
+}
+
+// Relaxation methods
+void mgrid::DistributedLinearMultigrid::relax(const Level level,
+    const unsigned long N)
+{
+    if (not(solution.is_active(level))) return;
+    for (unsigned long iter=0; iter<N; iter++) {
+        _relaxation_sweep(level, 0);
+        _relaxation_sweep(level, 1);
+        solution.update_boundaries(level);
+    }
+}
+void mgrid::DistributedLinearMultigrid::relax(const Level level,
+    const double tolerance)
+{
+    if (not(solution.is_active(level))) return;
+    for (unsigned long iter=0; iter<maxIterations; iter++) {
+        double sums[2] = {0, 0};  // squared change, squared solution
+        _relaxation_sweep(level, 0, sums[0], sums[1]);
+        _relaxation_sweep(level, 1, sums[0], sums[1]);
+        solution.update_boundaries(level);
+
+        // Check for convergence over the whole level
+        solution.sum(level, sums, 2);
+        if ((sqrt(sums[0])/sqrt(sums[1])) < tolerance) return;
+    }
+}
+
+// Sweeps over interior points with (i + j) % 2 == colour in global indices,
+// so colour 0 is red and colour 1 is black as in RED_BLACK_LOOP
+void mgrid::DistributedLinearMultigrid::_relaxation_sweep(Level level,
+    const int colour)
+{
+    solution.exchange_halos(level);
+    const int xOffset = solution.offset(level, 0);
+    const int zOffset = solution.offset(level, 1);
+    const int iFirst = std::max(solution.first(level, 0), 1 - xOffset);
+    const int iLast = std::min(solution.last(level, 0),
+        solution.global_rows(level) - 1 - xOffset);
+    const int jFirst = std::max(solution.first(level, 1), 1 - zOffset);
+    const int jLast = std::min(solution.last(level, 1),
+        solution.global_columns(level) - 1 - zOffset);
+    for (int i=iFirst; i<iLast; i++) {
+        const int jStart = jFirst + (i + xOffset + jFirst + zOffset + colour)%2;
+        for (int j=jStart; j<jLast; j+=2)
+            relaxation_updater(level, i, j);
+    }
+}
+void mgrid::DistributedLinearMultigrid::_relaxation_sweep(Level level,
+    const int colour, double& changeSum, double& normSum)
+{
+    solution.exchange_halos(level);
+    FDArray& u = solution[level];
+    const int xOffset = solution.offset(level, 0);
+    const int zOffset = solution.offset(level, 1);
+    const int iFirst = std::max(solution.first(level, 0), 1 - xOffset);
+    const int iLast = std::min(solution.last(level, 0),
+        solution.global_rows(level) - 1 - xOffset);
+    const int jFirst = std::max(solution.first(level, 1), 1 - zOffset);
+    const int jLast = std::min(solution.last(level, 1),
+        solution.global_columns(level) - 1 - zOffset);
+    for (int i=iFirst; i<iLast; i++) {
+        const int jStart = jFirst + (i + xOffset + jFirst + zOffset + colour)%2;
+        for (int j=jStart; j<jLast; j+=2) {
+            double tmp = u(i, j);
+            relaxation_updater(level, i, j);
+            tmp = u(i, j) - tmp;
+            changeSum += power<2>(tmp);
+            normSum += power<2>(u(i, j));
+        }
+    }
+}
+
+// Multigrid solver, as LinearMultigrid::multigrid
+void mgrid::DistributedLinearMultigrid::multigrid() {
+    // Check that source array has been set
+    if (not(sourceIsSet)) return;
+
+    // Initialise right-hand-side
+    for (Level level=finestLevel; level>0; level--) {
+        source.coarsen(level);
+        solution.coarsen(level);
+    }
+
+    // Solve on coarsest level
+    relax(coarsestLevel, residualTolerance);
+
+    // Full Multigrid loop
+    for (Level fineLevel=1; fineLevel<=finestLevel; fineLevel++) {
+        solution.refine(fineLevel-1);
+        for (int cycle=0; cycle < cycleType; cycle++) {
+            // Downstroke of cycle
+            for (Level level=fineLevel; level>0; level--) {
+                relax(level, preRelax);
+                evaluate_residual(level, temp[level]);
+                temp.coarsen(level, source[level-1]);
+                if (solution.is_active(level-1)) solution[level-1] = 0;
+            }
+
+            // Solve problem on coarsest level
+            relax(coarsestLevel, residualTolerance);
+
+            // Upstroke of cycle
+            for (Level level=1; level<=fineLevel; level++) {
+                solution.refine(level-1, temp[level]);
+                if (solution.is_active(level)) solution[level] += temp[level];
+                relax(level, postRelax);
+            }
+        }
+    }
+
+    // Do final update
+    relax(finestLevel, postRelax);
+    solution.update_boundaries(finestLevel);
+}
+
+// Norm of the whole solution
+double mgrid::DistributedLinearMultigrid::norm() {
+    // The sum over each process's points doesn't depend on the number of 
+    // threads, but the sum between processes is up to MPI
+    double sumSquares = 0;
+    if (solution.is_active(finestLevel)) {
+        const int i0 = solution.first(finestLevel, 0);
+        const int j0 = solution.first(finestLevel, 1);
+        sumSquares = sum_of_squares(solution[finestLevel].view().block(i0, j0,
+            solution.last(finestLevel, 0) - i0, 
+            solution.last(finestLevel, 1) - j0));
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &sumSquares, 1, MPI_DOUBLE, MPI_SUM,
+        solution.communicator());
+    const int nx = solution.global_rows(finestLevel);
+    const int nz = solution.global_columns(finestLevel);
+    return sqrt(sumSquares/(nx*nx + nz*nz));
+}
+
+// Write method
+void mgrid::DistributedLinearMultigrid::write(int numOfVariables,
+    std::string fileRoot)
+{
+    if (not(solution.is_active(finestLevel))) return;
+
+    // Our block of the grid
+    FDArray& u = solution[finestLevel];
+    const int fi = solution.first(finestLevel, 0);
+    const int li = solution.last(finestLevel, 0);
+    const int fj = solution.first(finestLevel, 1);
+    const int lj = solution.last(finestLevel, 1);
+    const int nx = li - fi, nz = lj - fj;
+    const blitz::Range owned_i(fi, li-1), owned_j(fj, lj-1);
+
+    // Calculate gradient and residual values first, since these exchange
+    // halos with the other processes
+    blitz::Array<double, 2> gradientValues(u.rows(), u.columns());
+    FDArray& residualValues = temp[finestLevel];
+    solution.exchange_halos(finestLevel);
+    if (numOfVariables > 1) u.gradient_magnitude(gradientValues);
+    if (numOfVariables > 2) evaluate_residual(finestLevel, residualValues);
+
+    // Generate one file per process
+    fileRoot.append(filename()).append("_rank")
+        .append(str(solution.rank)).append(".nc");
+    std::auto_ptr<NcFile> file(new NcFile(fileRoot.c_str(), NcFile::Replace));
+    if (not(file->is_valid())) return;
+
+    // Define and add dimentions and variables
+    NcDim* xDim = file->add_dim("x", nx);
+    NcDim* zDim = file->add_dim("z", nz);
+    NcVar* XxVals = file->add_var("x", ncDouble, xDim);
+    NcVar* ZzVals = file->add_var("z", ncDouble, zDim);
+    const double hx = u.spacing(0), hz = u.spacing(1);
+    std::vector<double> XxArray(nx), ZzArray(nz);
+    for (int i=0; i<nx; i++)
+        XxArray[i] = (i + fi + solution.offset(finestLevel, 0))*hx;
+    for (int j=0; j<nz; j++)
+        ZzArray[j] = (j + fj + solution.offset(finestLevel, 1))*hz;
+    XxVals->put(&XxArray[0], nx);
+    ZzVals->put(&ZzArray[0], nz);
+
+    // Add solution, copied to make it contiguous
+    NcVar* variable = file->add_var("solution", ncDouble, xDim, zDim);
+    blitz::Array<double, 2> values = u(owned_i, owned_j).copy();
+    variable->put(&values(0,0), nx, nz);
+
+    // Add gradient magnitude
+    if (numOfVariables > 1) {
+        NcVar* modGrad = file->add_var("gradient", ncDouble, xDim, zDim);
+        values = gradientValues(owned_i, owned_j);
+        modGrad->put(&values(0,0), nx, nz);
+    }
+
+    // Add residual
+    if (numOfVariables > 2) {
+        NcVar* resid = file->add_var("log_residual", ncDouble, xDim, zDim);
+        values = log10(residualValues(owned_i, owned_j));
+        resid->put(&values(0,0), nx, nz);
+    }
+
+    // Add some attributes describing settings and where this block goes
+    file->add_att("aspect_ratio", aspect);
+    file->add_att("x_offset", fi + solution.offset(finestLevel, 0));
+    file->add_att("z_offset", fj + solution.offset(finestLevel, 1));
+    file->add_att("global_nx", solution.global_rows(finestLevel));
+    file->add_att("global_nz", solution.global_columns(finestLevel));
+}
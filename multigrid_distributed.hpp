@@ -0,0 +1,226 @@
+/*
+    multigrid_distributed.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Distributed-memory linear multigrid solver using MPI. Each level of the
+    grid stack is split into two-dimensional blocks, one per process, with a
+    halo of one point around each block. Only built if MULTIGRID_MPI is
+    defined.
+*/
+
+#ifndef MULTIGRID_DISTRIBUTED_HPP_Q3LW8CZT
+#define MULTIGRID_DISTRIBUTED_HPP_Q3LW8CZT
+
+#include <mpi.h>
+#include <vector>
+#include <boost/function.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "utilities.hpp"
+#include "fdarray.hpp"
+#include "stack.hpp"
+#include "settings.hpp"
+#include "boundary_conditions.hpp"
+
+namespace mgrid {
+
+// = DistributedStack class interface =
+/*  Each process holds one block of each level, as an FDArray indexed from
+    zero which includes a halo on every side where there is a neighbouring
+    block. The decomposition of each coarse level is induced by the finest
+    level (a coarse point belongs to the process which owns the fine point
+    on top of it), so the transfer operators only need the halos.
+
+    Once the blocks on a level would have fewer than agglomerationSize
+    points in either direction, that level and all coarser levels are
+    gathered onto the first process. Other processes then own nothing on
+    those levels, and is_active returns false.
+*/
+class DistributedStack: public std::vector<FDArray> {
+public:
+    DistributedStack(const Settings& s, MPI_Comm comm=MPI_COMM_WORLD);
+    virtual ~DistributedStack();
+
+    // Some useful attributes
+    const Level finestLevel;              // level of finest grid
+    static const Level coarsestLevel = 0; // level of coarsest grid
+    int rank, numberOfProcesses;          // this process in communicator
+
+    // Boundary conditions for the whole grid, on the finest level
+    BoundaryConditions boundaryConditions;
+
+    // Decomposition of each level
+    inline bool is_active(Level level);       // do we own part of the level?
+    inline bool is_distributed(Level level);  // is it split between processes?
+    inline int global_rows(Level level);
+    inline int global_columns(Level level);
+    inline int offset(Level level, const int dim); // global index of (0, 0)
+    inline int first(Level level, const int dim);  // first local index owned
+    inline int last(Level level, const int dim);   // one past last owned
+
+    // Communication
+    inline MPI_Comm communicator() { return gridComm; }
+    void exchange_halos(Level level);
+    void exchange_halos(Level level, FDArray& array);
+    void sum(Level level, double* values, const int count);
+
+    // Transfer methods
+    inline void coarsen(Level level);
+    inline void coarsen(Level level, FDArray& result);
+    inline void refine(Level level);
+    inline void refine(Level level, FDArray& result);
+    void restriction(Level level, FDArray& fine, FDArray& coarse);
+    void interpolation(Level level, FDArray& coarse, FDArray& fine);
+
+    // Boundary conditions are applied point by point on the blocks which
+    // touch the edge of the grid
+    void update_boundaries(Level level);
+
+private:
+    // Geometry of each level
+    struct BlockLayout {
+        bool distributed, active;
+        int nx, nz;                         // Global shape
+        std::vector<int> xStarts, zStarts;  // Global block boundaries
+        int i0, i1, j0, j1;                 // Global range owned here
+        int xOffset, zOffset;               // Global index of local (0, 0)
+    };
+    std::vector<BlockLayout> layouts;
+
+    // Process grid
+    MPI_Comm gridComm;
+    int dims[2], coords[2];
+    int lowerNeighbour[2], upperNeighbour[2];
+
+    // Helpers
+    void _choose_process_grid(const int nx, const int nz);
+    void _gather(Level level, blitz::Array<double, 2>& block, const int I0,
+        const int J0, FDArray& coarse);
+    void _scatter(Level level, FDArray& coarse, blitz::Array<double, 2>& block,
+        int& I0, int& J0);
+};
+
+// = Inline methods for DistributedStack class =
+inline bool DistributedStack::is_active(Level level) {
+    return layouts[level].active;
+}
+inline bool DistributedStack::is_distributed(Level level) {
+    return layouts[level].distributed;
+}
+inline int DistributedStack::global_rows(Level level) {
+    return layouts[level].nx;
+}
+inline int DistributedStack::global_columns(Level level) {
+    return layouts[level].nz;
+}
+inline int DistributedStack::offset(Level level, const int dim) {
+    if (dim == 0) return layouts[level].xOffset;
+    else return layouts[level].zOffset;
+}
+inline int DistributedStack::first(Level level, const int dim) {
+    if (dim == 0) return layouts[level].i0 - layouts[level].xOffset;
+    else return layouts[level].j0 - layouts[level].zOffset;
+}
+inline int DistributedStack::last(Level level, const int dim) {
+    if (dim == 0) return layouts[level].i1 - layouts[level].xOffset;
+    else return layouts[level].j1 - layouts[level].zOffset;
+}
+inline void DistributedStack::coarsen(Level level) {
+    restriction(level, (*this)[level], (*this)[level - 1]);
+}
+inline void DistributedStack::coarsen(Level level, FDArray& result) {
+    restriction(level, (*this)[level], result);
+}
+inline void DistributedStack::refine(Level level) {
+    interpolation(level, (*this)[level], (*this)[level + 1]);
+}
+inline void DistributedStack::refine(Level level, FDArray& result) {
+    interpolation(level, (*this)[level], result);
+}
+
+// = DistributedLinearMultigrid class interface =
+/*  This follows LinearMultigrid::multigrid step for step, and gives the same
+    result up to round-off in the convergence checks (provided the operator
+    only couples each point to its four nearest neighbours, so that the
+    order of the updates within each colour doesn't matter).
+
+    The differential_operator and relaxation_updater methods are as for
+    MultigridBase, but act on this process's block in local indices, so the
+    usual implementations can be used unchanged. Halos are exchanged before
+    each colour sweep, residual evaluation and transfer.
+*/
+class DistributedLinearMultigrid {
+public:
+    DistributedLinearMultigrid(const Settings& settings,
+        MPI_Comm comm=MPI_COMM_WORLD);
+    virtual ~DistributedLinearMultigrid() {};
+
+    // Setters and getters. Arrays are this process's block of the finest
+    // level, and functions are evaluated at global (x, z) positions.
+    inline FDArray& get_result();
+    inline DistributedStack& get_solution();
+    inline FDArray& source_term();
+    void source_term(const double value);
+    void source_term(boost::function<double (double, double)> f);
+    void initial_guess(const double value);
+    void initial_guess(boost::function<double (double, double)> f);
+
+    // Evaluation methods, on this process's block
+    void evaluate_residual(Level level, FDArray& result);
+
+    // Relaxation methods
+    void relax(const Level level, const unsigned long N);
+    void relax(const Level level, const double tolerance);
+
+    // Multigrid solver method, and solve method for subclasses to overload
+    virtual void multigrid();
+    virtual inline void solve() { multigrid(); }
+
+    // Other overloaded methods
+    virtual double differential_operator(Level, int, int)=0;
+    virtual void relaxation_updater(Level, int, int)=0;
+
+    // Frobenius norm of the whole solution, as FDArray::norm
+    double norm();
+
+    // Each process writes its own block to <filename>_rank<n>.nc
+    virtual void write(int numOfVariables, std::string root="");
+    virtual std::string filename(std::string root="")=0;
+
+protected:
+    // Data
+    DistributedStack solution, source;  // Grids for solution and source term
+    DistributedStack temp;              // Extra storage for multigrid solver
+    const int cycleType;            // Type of FMG-cycling used
+    const unsigned long preRelax;   // Num of pre-corection relaxations to use
+    const unsigned long postRelax;  // Num of post-corection relaxations to use
+    const double residualTolerance; // For convergence testing
+    const double maxIterations;     // Maxium number of iterations allowed
+    const double aspect;            // Aspect ratio
+    int finestLevel, coarsestLevel; // Grid geometry
+    bool sourceIsSet;               // Has the source term been provided?
+    bool initialIsSet;              // Has an initial value been provided?
+
+    // Red-black sweeps over this process's interior points of one colour
+    void _relaxation_sweep(Level level, const int colour);
+    void _relaxation_sweep(Level level, const int colour, double& changeSum,
+        double& normSum);
+    void _assign(Level level, FDArray& array,
+        boost::function<double (double, double)> f);
+};
+
+// Setters and getters
+inline FDArray& DistributedLinearMultigrid::get_result() {
+    return solution[finestLevel];
+}
+inline DistributedStack& DistributedLinearMultigrid::get_solution() {
+    return solution;
+}
+inline FDArray& DistributedLinearMultigrid::source_term() {
+    return source[finestLevel];
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: MULTIGRID_DISTRIBUTED_HPP_Q3LW8CZT */
@@ -9,6 +9,8 @@
 #define MULTIGRID_EXCEPTIONS_HPP_6MQVVDHT
 
 #include <iostream>
+#include <sstream>
+#include <string>
 
 namespace mgrid { 
     
@@ -52,6 +54,38 @@ public:
     }
 };  
 
+class CheckpointException: public MultigridException {
+public:
+    CheckpointException(const std::string& reason) {
+        Message msg(ErrorMessage);
+        msg << "Checkpoint: " << reason;
+        message = msg.str();
+    }
+    virtual ~CheckpointException() throw() {}
+    virtual const char* what() const throw() {
+        return message.c_str();
+    }
+
+private:
+    std::string message;
+};
+
+class ThreadPoolException: public MultigridException {
+public:
+    ThreadPoolException(const std::string& reason) {
+        Message msg(ErrorMessage);
+        msg << "Thread pool: " << reason;
+        message = msg.str();
+    }
+    virtual ~ThreadPoolException() throw() {}
+    virtual const char* what() const throw() {
+        return message.c_str();
+    }
+
+private:
+    std::string message;
+};
+
 } // end namespace mgrid
 
 
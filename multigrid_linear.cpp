@@ -3,15 +3,23 @@
     Jess Robertson, 2011-01-28
 */                        
 
+#include <algorithm>
+
 #include "multigrid_linear.hpp"
 
 void mgrid::LinearMultigrid::multigrid() {
     // Check that source array has been set  
     if (not(sourceIsSet)) return;
     
+    // Build Galerkin coarse grid operators if requested
+    if (coarseOperatorType == galerkinOperator && not(coarseOperatorsAreSet))
+        build_coarse_operators();
+    
     // Constants
     const Level finestLevel = solution.finestLevel;
     const Level coarsestLevel = solution.coarsestLevel;
+    _begin_solve();
+    TRACE_SCOPE(trace, &profiler, "multigrid", -1, -1);
     
     // Initialise right-hand-side
     for (Level level=finestLevel; level>0; level--) {
@@ -25,8 +33,12 @@ void mgrid::LinearMultigrid::multigrid() {
     // Full Multigrid loop
     for (Level fineLevel=1; fineLevel<=finestLevel; fineLevel++) {
         // V-cycle loop at each (successively finer) level
+        TRACE_SCOPE(levelTrace, &profiler, "fmg_level", fineLevel, -1);
         solution.refine(fineLevel-1); // interpolate to next level    
+        double residualNorm = trackConvergence
+            ? _residual_norm(fineLevel) : 0;
         for (int cycle=0; cycle < cycleType; cycle++) {
+            TRACE_SCOPE(cycleTrace, &profiler, "cycle", fineLevel, cycle);
             // Downstroke of cycle:    
             //  -- New residual: r(2h) = 0 (see note below)
             //  -- New rhs: f(2h) = R.f(h) - L.u(2h)    
@@ -34,9 +46,11 @@ void mgrid::LinearMultigrid::multigrid() {
             // a _residual_, not a coarser version of the solution. Each level
             // therefore needs to be set to zero on the way down.
             for (Level level=fineLevel; level>0; level--) {
+                TRACE_SCOPE(visit, &profiler, "down", level, cycle);
                 relax(level, preRelax);
-                evaluate_residual(level, temp[level]); 
-                temp.coarsen(level, source[level-1]);     
+                ScratchArray residual(*workspace, solution[level]);
+                evaluate_residual(level, residual); 
+                _restrict(level, residual, source[level-1]);
                 solution[level-1] = 0; // initialise next level's residual
             }
 
@@ -46,14 +60,148 @@ void mgrid::LinearMultigrid::multigrid() {
             // Upstroke of cycle:
             // -- Correction: u(h) <- u(h) + I.u(2h)
             for (Level level=1; level<=fineLevel; level++) {
-                solution.refine(level-1, temp[level]);     
-                solution[level] += temp[level];
+                TRACE_SCOPE(visit, &profiler, "up", level, cycle);
+                ScratchArray correction(*workspace, solution[level]);
+                solution.refine(level-1, correction);     
+                solution[level] += correction;
                 relax(level, postRelax); 
             } 
+            _record_cycle(fineLevel, cycle, residualNorm);
         }
     } 
     
     // Do final update 
     relax(finestLevel, postRelax);
     solution[finestLevel].update_boundaries();
+    _end_solve();
+}
+
+// Additive multigrid methods
+void mgrid::LinearMultigrid::additive_multigrid() {
+    // Check that source array has been set  
+    if (not(sourceIsSet)) return;
+    
+    // Build Galerkin coarse grid operators if requested
+    if (coarseOperatorType == galerkinOperator && not(coarseOperatorsAreSet))
+        build_coarse_operators();
+    
+    // Cycle until the residual (away from the boundaries) has dropped by 
+    // residualTolerance
+    _begin_solve();
+    const double initialNorm = _residual_norm(finestLevel);
+    double norm = initialNorm;
+    for (unsigned long iter=0; iter<maxIterations; iter++) {
+        additive_cycle();
+        
+        // The residual is needed anyway, so always keep the history
+        CycleRecord record;
+        record.level = finestLevel;
+        record.cycle = iter;
+        record.residualBefore = norm;
+        record.residualAfter = norm = _residual_norm(finestLevel);
+        record.workUnits = _work_units();
+        solveResult.cycles.push_back(record);
+        if (norm < residualTolerance*initialNorm) {
+            _end_solve();
+            return;
+        }
+    }
+    _end_solve();
+    Message msg(WarningMessage); 
+    msg << "Additive multigrid did not converge in " << maxIterations 
+        << " cycles" << std::endl;
+    std::cout << msg.str();
+}
+
+void mgrid::LinearMultigrid::additive_cycle() {
+    TRACE_SCOPE(trace, &profiler, "additive_cycle", -1, -1);
+    
+    // Residual on the finest level, restricted down to every coarser level, 
+    // which then holds a correction starting from zero. The same scratch 
+    // array holds the interpolated estimate on the finest level later on.
+    ScratchArray fine(*workspace, solution[finestLevel]);
+    evaluate_residual(finestLevel, fine);
+    _restrict(finestLevel, fine, source[finestLevel-1]);
+    for (Level level=finestLevel-1; level>coarsestLevel; level--)
+        source.coarsen(level);
+    for (Level level=coarsestLevel; level<finestLevel; level++)
+        solution[level] = 0;
+    
+    // First pass: smooth on every coarse level at once (solving exactly on 
+    // the coarsest level), to estimate what each level will correct
+    if (not(levelPool))
+        levelPool.reset(new ThreadPool(finestLevel - coarsestLevel));
+    std::vector<ThreadPool::Task> firstPass;
+    for (Level level=coarsestLevel; level<finestLevel; level++)
+        firstPass.push_back(boost::bind(
+            &LinearMultigrid::_additive_smooth, this, level, preRelax));
+    levelPool->run(firstPass);
+    
+    // Remove those estimates from the finer level's problem: the finest level
+    // gets the interpolated estimate added to the solution (kept in fine so
+    // it can be taken off again), the others get a new residual. Done from 
+    // fine to coarse, so each estimate is used before it is overwritten.
+    solution.refine(finestLevel-1, fine);
+    solution[finestLevel] += fine;
+    solution[finestLevel].update_boundaries();
+    for (Level level=finestLevel-1; level>coarsestLevel; level--) {
+        solution.refine(level-1);
+        solution[level].update_boundaries();
+        ScratchArray residual(*workspace, solution[level]);
+        evaluate_residual(level, residual);
+        source[level] = residual;
+        solution[level] = 0;
+    }
+    
+    // Second pass: smooth on every level except the coarsest at once. The 
+    // finest level is smoothed in place, which for a linear problem gives the
+    // same correction as smoothing its residual equation from zero.
+    std::vector<ThreadPool::Task> secondPass;
+    for (Level level=finestLevel; level>coarsestLevel; level--)
+        secondPass.push_back(boost::bind(
+            &LinearMultigrid::_additive_smooth, this, level, postRelax));
+    levelPool->run(secondPass);
+    
+    // Sum the corrections from the coarsest level upwards
+    solution[finestLevel] -= fine;
+    for (Level level=coarsestLevel+1; level<=finestLevel; level++) {
+        ScratchArray correction(*workspace, solution[level]);
+        solution.refine(level-1, correction);
+        solution[level] += correction;
+        solution[level].update_boundaries();
+    }
+}
+
+void mgrid::LinearMultigrid::precondition(FDArray& residual, 
+    FDArray& result) 
+{
+    // Swap the residual in as the source and solve for the correction from 
+    // zero, then put everything back
+    ScratchArray savedSolution(*workspace, solution[finestLevel]);
+    ScratchArray savedSource(*workspace, source[finestLevel]);
+    savedSolution = solution[finestLevel];
+    savedSource = source[finestLevel];
+    solution[finestLevel] = 0;
+    source[finestLevel] = residual;
+
+    // Count the cycle's work on its own, leaving the record of the last
+    // solve as it was
+    const std::vector<double> savedSweeps = sweeps;
+    const std::size_t coarseSolves = solveResult.coarseIterations.size();
+    std::fill(sweeps.begin(), sweeps.end(), 0);
+    additive_cycle();
+    preconditionWorkUnits += _work_units();
+    sweeps = savedSweeps;
+    solveResult.coarseIterations.resize(coarseSolves);
+    result = solution[finestLevel];
+    solution[finestLevel] = savedSolution;
+    source[finestLevel] = savedSource;
+}
+
+void mgrid::LinearMultigrid::_additive_smooth(Level level, 
+    const unsigned long N) 
+{
+    TRACE_SCOPE(trace, &profiler, "smooth", level, -1);
+    if (level == coarsestLevel) relax(level, residualTolerance);
+    else relax(level, N);
 }
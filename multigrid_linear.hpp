@@ -8,20 +8,49 @@
 #ifndef MULTIGRID_LINEAR_HPP_M1Z9C6EC
 #define MULTIGRID_LINEAR_HPP_M1Z9C6EC
 
+#include <boost/shared_ptr.hpp>
+
 #include "multigrid_base.hpp"
+#include "thread_pool.hpp"
 
 namespace mgrid {  
 
 class LinearMultigrid: public MultigridBase {
 public:
     LinearMultigrid(const Settings& settings):
-        MultigridBase::MultigridBase(settings) {};
+        MultigridBase::MultigridBase(settings), preconditionWorkUnits(0) {};
     virtual ~LinearMultigrid() {};   
 
     // Multigrid method
     virtual void multigrid();          
+
+    // Additive multigrid methods. Each cycle smooths every level of the
+    // stack concurrently, on a pool of threads (one per level, started by
+    // the first cycle and kept for the rest), and then sums the corrections
+    // (in the style of AFACx: each level's problem first has the part which
+    // the next coarser level will correct taken out, which keeps the cycle
+    // convergent without damping). This converges in more cycles than
+    // multigrid, but keeps more cores busy on deep stacks.
+    // precondition applies a single cycle to a residual, with a zero initial 
+    // guess, so it can be used to precondition a Krylov method. It leaves
+    // solve_result alone, and adds the work it does to
+    // precondition_work_units instead.
+    void additive_multigrid();
+    void additive_cycle();
+    void precondition(FDArray& residual, FDArray& result);
+    inline double precondition_work_units();
+
+private:
+    double preconditionWorkUnits;   // Work done by all calls of precondition
+    boost::shared_ptr<ThreadPool> levelPool;  // Threads for additive cycles
+    void _additive_smooth(Level level, const unsigned long N);
 };
 
+// = Inline methods =
+inline double LinearMultigrid::precondition_work_units() {
+    return preconditionWorkUnits;
+}
+
 } // end namespace mgrid
 
 #endif /* end of include guard: MULTIGRID_LINEAR_HPP_M1Z9C6EC */
@@ -12,6 +12,8 @@ void mgrid::NonlinearMultigrid::multigrid() {
     // Constants                          
     const Level finestLevel = solution.finestLevel;
     const Level coarsestLevel = solution.coarsestLevel;
+    _begin_solve();
+    TRACE_SCOPE(trace, &profiler, "multigrid", -1, -1);
     
     // Initialise initial guess
     for (Level level=finestLevel; level>0; level--) {
@@ -20,30 +22,37 @@ void mgrid::NonlinearMultigrid::multigrid() {
     }
 
     // Solve on coarsest level 
-    rightHandSide[coarsestLevel] = source[coarsestLevel];    
     relax(coarsestLevel, residualTolerance);        
 
     // Full Multigrid loop
     for (Level fineLevel=1; fineLevel<=finestLevel; fineLevel++) {
         // V-cycle loop at each (successively finer) level
+        TRACE_SCOPE(levelTrace, &profiler, "fmg_level", fineLevel, -1);
         solution.refine(fineLevel-1); // interpolate solution to next level   
-        rightHandSide[fineLevel] = source[fineLevel];  // set up rRHS
+        double residualNorm = trackConvergence
+            ? _residual_norm(fineLevel) : 0;
         for (int cycle=0; cycle < cycleType; cycle++) {         
+            TRACE_SCOPE(cycleTrace, &profiler, "cycle", fineLevel, cycle);
             // Downstroke of cycle:
             //  -- New solution: u(2h) = R.u(h)     
             //  -- Truncation Error: t = L(R.u(h)) - R(L.u(h)) 
             //  -- New rhs: f(2h) = R.f(h) + t
             for (Level level=fineLevel; level>coarsestLevel; level--) {
+                TRACE_SCOPE(visit, &profiler, "down", level, cycle);
+                
                 // Do pre-correction relaxation on current level 
                 relax(level, preRelax);
             
                 // Calculate approximate truncation error for current
                 // discretisation on the finest grid: t = L(R.u(h)) - R(L.u(h))
-                evaluate_operator(level, temp[level]);     // L.u(h)      
-                temp.coarsen(level);                       // temp <- R(L.u(h)) 
+                ScratchArray fineOperator(*workspace, solution[level]);
+                ScratchArray coarseOperator(*workspace, solution[level-1]);
+                ScratchArray truncError(*workspace, solution[level-1]);
+                evaluate_operator(level, fineOperator);    // L.u(h)      
+                _restrict(level, fineOperator, coarseOperator); // R(L.u(h))
                 solution.coarsen(level);                   // u(2h) <- R.u(h)
-                evaluate_operator(level-1, truncError[level-1]); // L(R.u(h))      
-                truncError[level-1] -= temp[level-1];      // t
+                evaluate_operator(level-1, truncError);    // L(R.u(h))      
+                truncError -= coarseOperator;              // t
                 
                 // // Estimate truncation error based on Taylor expansion of
                 // // PDE residual (see NRC, pp. ?): |t(h)| ≈ |t(2h)|/3  
@@ -52,7 +61,7 @@ void mgrid::NonlinearMultigrid::multigrid() {
                 
                 // Calculate source: f(2h) = R.f(h) + L(R.u(h)) - R(L.u(h))
                 source.coarsen(level);
-                source[level-1] += truncError[level-1];   
+                source[level-1] += truncError;   
             }   
     
             // Solve on coarsest level  
@@ -61,13 +70,17 @@ void mgrid::NonlinearMultigrid::multigrid() {
             // Upstroke of cycle
             // -- Correction: u(h) <- u(h) + I(u(2h) - R.u(h))
             for (Level level=coarsestLevel+1; level<fineLevel; level++) {
+                TRACE_SCOPE(visit, &profiler, "up", level, cycle);
+                
                 // Calculate I(u(2h) - R.u(h)), store in temporary 
-                solution.coarsen(level, temp[level-1]);   // R.u(h))   
-                solution[level-1] -= temp[level-1];       // u(2h) - R.u(h)
-                solution.refine(level-1, temp[level]);    // I(u(2h) - R.u(h))    
+                ScratchArray restricted(*workspace, solution[level-1]);
+                ScratchArray correction(*workspace, solution[level]);
+                solution.coarsen(level, restricted);      // R.u(h))   
+                solution[level-1] -= restricted;          // u(2h) - R.u(h)
+                solution.refine(level-1, correction);     // I(u(2h) - R.u(h))    
                 
                 // Update u and do post-correction relaxation
-                solution[level] += temp[level];
+                solution[level] += correction;
                 relax(level, postRelax);
             }           
             
@@ -76,6 +89,8 @@ void mgrid::NonlinearMultigrid::multigrid() {
             // evaluate_residual(fineLevel, temp[fineLevel]);             
             // if (temp[fineLevel].norm() < truncError) 
             //     break; 
+            _record_cycle(fineLevel, cycle, residualNorm);
         }                          
     }
+    _end_solve();
 }
\ No newline at end of file
@@ -15,17 +15,11 @@ namespace mgrid {
 class NonlinearMultigrid: public MultigridBase {
 public:
     NonlinearMultigrid(const Settings& settings):
-        MultigridBase::MultigridBase(settings),
-        truncError(settings),
-        rightHandSide(settings) {};
+        MultigridBase::MultigridBase(settings) {};
     virtual ~NonlinearMultigrid () {};    
     
     // Multigrid method
     virtual void multigrid();        
-    
-protected:
-    Stack truncError;    // Truncation error    
-    Stack rightHandSide; // Right hand side of different equations
 }; 
 
 } // end namespace mgrid
@@ -0,0 +1,346 @@
+/*
+    output.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <netcdf.h>
+#include <boost/bind.hpp>
+
+#include "output.hpp"
+
+// Copy (or otherwise work out) each block of rows into a contiguous buffer,
+// and write it to the variable
+typedef boost::function<void (const mgrid::FDView&, const mgrid::FDView&)>
+    BlockTransform;
+static void put_blocks(NcVar* variable, const mgrid::FDView& u,
+    const mgrid::OutputSettings& settings, const std::vector<long>& index,
+    BlockTransform transform)
+{
+    const int nx = u.rows(), nz = u.columns();
+    const int blockRows = std::max(1, std::min(settings.chunkRows, nx));
+    std::vector<double> buffer(std::size_t(blockRows)*nz);
+
+    // Corner and size of each block in the variable, which can have leading
+    // dimensions before x and z
+    std::vector<long> corner(index), counts(index.size(), 1);
+    corner.push_back(0);
+    corner.push_back(0);
+    counts.push_back(0);
+    counts.push_back(nz);
+    for (int i0=0; i0<nx; i0+=blockRows) {
+        const int rows = std::min(blockRows, nx - i0);
+        const mgrid::FDView block = u.block(i0, 0, rows, nz);
+        const mgrid::FDView values(&buffer[0], rows, nz, nz, 1,
+            u.spacing(0), u.spacing(1));
+        transform(block, values);
+        corner[index.size()] = i0;
+        counts[index.size()] = rows;
+        variable->set_cur(&corner[0]);
+        variable->put(&buffer[0], &counts[0]);
+    }
+}
+static void copy_block(const mgrid::FDView& block, const mgrid::FDView& values) {
+    ARRAY_LOOP(block) values(i, j) = block(i, j);
+}
+static void gradient_magnitude_block(const mgrid::FDView& block,
+    const mgrid::FDView& values)
+{
+    // The block can use the rows either side of it for centred differences
+    block.gradient_magnitude(values);
+}
+static void log_block(const mgrid::FDView& block, const mgrid::FDView& values) {
+    ARRAY_LOOP(block) values(i, j) = log10(block(i, j));
+}
+
+// Field output functions
+std::auto_ptr<NcFile> mgrid::open_output_file(const std::string& path,
+    const OutputSettings& settings)
+{
+    const NcFile::FileFormat format
+        = settings.netcdf4 ? NcFile::Netcdf4 : NcFile::Classic;
+    std::auto_ptr<NcFile> file(
+        new NcFile(path.c_str(), NcFile::Replace, 0, 0, format));
+    if (not(file->is_valid())) {
+        Message msg(WarningMessage);
+        msg << "Couldn't create " << path << std::endl;
+        std::cout << msg.str();
+    }
+    return file;
+}
+void mgrid::add_grid_axes(NcFile& file, const FDView& u, NcDim*& xDim,
+    NcDim*& zDim)
+{
+    xDim = file.add_dim("x", u.rows());
+    zDim = file.add_dim("z", u.columns());
+    file.add_var("x", ncDouble, xDim);
+    file.add_var("z", ncDouble, zDim);
+}
+void mgrid::put_grid_axes(NcFile& file, const FDView& u) {
+    const int nx = u.rows(), nz = u.columns();
+    std::vector<double> axis(std::max(nx, nz));
+    for (int i=0; i<nx; i++) axis[i] = i*u.spacing(0);
+    file.get_var("x")->put(&axis[0], nx);
+    for (int j=0; j<nz; j++) axis[j] = j*u.spacing(1);
+    file.get_var("z")->put(&axis[0], nz);
+}
+NcVar* mgrid::add_field(NcFile& file, const std::string& name, NcDim* xDim,
+    NcDim* zDim, const OutputSettings& settings)
+{
+    std::vector<NcDim*> dims;
+    dims.push_back(xDim);
+    dims.push_back(zDim);
+    return add_field(file, name, dims, settings);
+}
+NcVar* mgrid::add_field(NcFile& file, const std::string& name,
+    const std::vector<NcDim*>& dims, const OutputSettings& settings)
+{
+    std::vector<const NcDim*> varDims(dims.begin(), dims.end());
+    NcVar* variable = file.add_var(name.c_str(), ncDouble, varDims.size(),
+        &varDims[0]);
+    if (settings.netcdf4 && variable) {
+        // Chunks of whole rows of one grid, which is the order they're
+        // written in
+        const std::size_t nDims = dims.size();
+        std::vector<size_t> chunks(nDims, 1);
+        chunks[nDims-2] = std::max(1L, std::min(long(settings.chunkRows),
+            dims[nDims-2]->size()));
+        chunks[nDims-1] = dims[nDims-1]->size();
+        nc_def_var_chunking(file.id(), variable->id(), NC_CHUNKED,
+            &chunks[0]);
+        if (settings.deflateLevel > 0)
+            nc_def_var_deflate(file.id(), variable->id(),
+                settings.shuffle ? 1 : 0, 1, settings.deflateLevel);
+    }
+    return variable;
+}
+void mgrid::put_field(NcVar* variable, const FDView& u,
+    const OutputSettings& settings, const std::vector<long>& index)
+{
+    put_blocks(variable, u, settings, index, copy_block);
+}
+void mgrid::put_gradient_magnitude(NcVar* variable, const FDView& u,
+    const OutputSettings& settings, const std::vector<long>& index)
+{
+    put_blocks(variable, u, settings, index, gradient_magnitude_block);
+}
+void mgrid::put_log_field(NcVar* variable, const FDView& u,
+    const OutputSettings& settings, const std::vector<long>& index)
+{
+    put_blocks(variable, u, settings, index, log_block);
+}
+
+// Field input functions
+bool mgrid::read_field(const std::string& path,
+    const std::vector<std::string>& names, std::vector<double>& values,
+    int& nx, int& nz)
+{
+    // Missing files and variables aren't fatal here
+    NcError errorHandling(NcError::silent_nonfatal);
+    NcFile file(path.c_str(), NcFile::ReadOnly);
+    if (not(file.is_valid())) return false;
+    foreach(const std::string& name, names) {
+        NcVar* variable = file.get_var(name.c_str());
+        if (not(variable) || variable->num_dims() != 2) continue;
+        nx = variable->get_dim(0)->size();
+        nz = variable->get_dim(1)->size();
+        values.resize(std::size_t(nx)*nz);
+        return not(values.empty()) && variable->get(&values[0], nx, nz);
+    }
+    return false;
+}
+
+// = SolutionOutput =
+void mgrid::SolutionOutput::write() {
+    std::auto_ptr<NcFile> file = open_output_file(path, settings);
+    if (not(file->is_valid())) return;
+
+    // Attributes, then define everything before writing any data
+    typedef std::pair<std::string, double> Attribute;
+    foreach(const Attribute& attribute, attributes)
+        file->add_att(attribute.first.c_str(), attribute.second);
+    NcDim *xDim, *zDim;
+    add_grid_axes(*file, solution, xDim, zDim);
+    NcVar* solutionVar = add_field(*file, solutionName, xDim, zDim, settings);
+    NcVar* gradientVar = 0;
+    NcVar* residualVar = 0;
+    if (numOfVariables > 1)
+        gradientVar = add_field(*file, gradientName, xDim, zDim, settings);
+    if (numOfVariables > 2)
+        residualVar = add_field(*file, "log_residual", xDim, zDim, settings);
+
+    // Write axes and fields
+    put_grid_axes(*file, solution);
+    put_field(solutionVar, solution, settings);
+    if (gradientVar) put_gradient_magnitude(gradientVar, solution, settings);
+    if (residualVar) put_log_field(residualVar, residual, settings);
+    if (not(message.empty())) std::cout << message;
+}
+
+// = OutputQueue =
+mgrid::OutputQueue::OutputQueue(const std::size_t maxPending):
+    maxPending(std::max(std::size_t(1), maxPending)),
+    stopping(false),
+    busy(false),
+    writer(boost::bind(&OutputQueue::_writer, this)) { /* pass */ }
+mgrid::OutputQueue::~OutputQueue() {
+    {
+        boost::mutex::scoped_lock guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+}
+void mgrid::OutputQueue::push(Job job) {
+    boost::mutex::scoped_lock guard(lock);
+    while (jobs.size() >= maxPending) changed.wait(guard);
+    jobs.push_back(job);
+    changed.notify_all();
+}
+void mgrid::OutputQueue::wait() {
+    boost::mutex::scoped_lock guard(lock);
+    while (busy || not(jobs.empty())) changed.wait(guard);
+}
+void mgrid::OutputQueue::_writer() {
+    // Write jobs until the queue is empty and we've been told to stop
+    for (;;) {
+        Job job;
+        {
+            boost::mutex::scoped_lock guard(lock);
+            while (jobs.empty() && not(stopping)) changed.wait(guard);
+            if (jobs.empty()) return;
+            job = jobs.front();
+            jobs.pop_front();
+            busy = true;
+            changed.notify_all();
+        }
+        try {
+            job();
+        } catch (std::exception& e) {
+            Message msg(ErrorMessage);
+            msg << "Output failed: " << e.what() << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+        }
+        {
+            boost::mutex::scoped_lock guard(lock);
+            busy = false;
+        }
+        changed.notify_all();
+    }
+}
+
+// = SweepDataset =
+mgrid::SweepDataset::SweepDataset(const std::string& path,
+    const std::vector<SweepAxis>& axes, const int nx, const int nz,
+    const std::vector<std::string>& fieldNames,
+    const std::vector<std::string>& scalarNames,
+    const OutputSettings& settings, const std::size_t maxPending):
+    settings(settings),
+    axes(axes),
+    nx(nx),
+    nz(nz),
+    file(open_output_file(path, settings)),
+    nxVar(0), nzVar(0), hxVar(0), hzVar(0),
+    queue(maxPending)
+{
+    if (not(file->is_valid())) return;
+
+    // Parameter dimensions and their coordinate variables
+    std::vector<NcVar*> axisVars;
+    foreach(const SweepAxis& axis, axes) {
+        NcDim* dim = file->add_dim(axis.name.c_str(), axis.values.size());
+        axisDims.push_back(dim);
+        axisVars.push_back(file->add_var(axis.name.c_str(), ncDouble, dim));
+    }
+
+    // Fields, then the grid size and spacing and the other scalars
+    std::vector<NcDim*> fieldDims(axisDims);
+    fieldDims.push_back(file->add_dim("x", nx));
+    fieldDims.push_back(file->add_dim("z", nz));
+    foreach(const std::string& name, fieldNames)
+        fieldVars.push_back(add_field(*file, name, fieldDims, settings));
+    nxVar = _add_scalar("nx", ncInt);
+    nzVar = _add_scalar("nz", ncInt);
+    hxVar = _add_scalar("hx", ncDouble);
+    hzVar = _add_scalar("hz", ncDouble);
+    foreach(const std::string& name, scalarNames)
+        scalarVars.push_back(std::make_pair(name, _add_scalar(name, ncDouble)));
+
+    // Everything's defined, so the parameter values can go in
+    for (std::size_t n=0; n<axes.size(); n++)
+        axisVars[n]->put(&axes[n].values[0], axes[n].values.size());
+}
+mgrid::SweepDataset::~SweepDataset() {
+    // Finish writing before the file is closed
+    queue.wait();
+}
+NcVar* mgrid::SweepDataset::_add_scalar(const std::string& name,
+    const NcType type)
+{
+    std::vector<const NcDim*> dims(axisDims.begin(), axisDims.end());
+    return file->add_var(name.c_str(), type, dims.size(),
+        dims.empty() ? 0 : &dims[0]);
+}
+
+// Adding results
+std::vector<long> mgrid::SweepDataset::nearest_index(
+    const std::vector<double>& parameters)
+{
+    std::vector<long> index(axes.size(), 0);
+    for (std::size_t n=0; n<axes.size() && n<parameters.size(); n++) {
+        const std::vector<double>& values = axes[n].values;
+        for (std::size_t k=1; k<values.size(); k++)
+            if (fabs(values[k] - parameters[n])
+                < fabs(values[index[n]] - parameters[n]))
+                index[n] = k;
+    }
+    return index;
+}
+void mgrid::SweepDataset::add(const std::vector<long>& index,
+    boost::shared_ptr<SolutionOutput> output)
+{
+    queue.push(boost::bind(&SweepDataset::_write, this, index, output));
+}
+void mgrid::SweepDataset::wait() {
+    queue.wait();
+}
+void mgrid::SweepDataset::_write(const std::vector<long>& index,
+    boost::shared_ptr<SolutionOutput> output)
+{
+    if (not(file->is_valid())) return;
+    const FDView u = output->solution;
+    if (index.size() != axes.size() || u.rows() > nx || u.columns() > nz) {
+        Message msg(WarningMessage);
+        msg << "Result of size (" << u.rows() << ", " << u.columns()
+            << ") doesn't fit in sweep dataset, skipping" << std::endl;
+        std::cout << msg.str();
+        return;
+    }
+
+    // Fields
+    if (fieldVars.size() > 0) put_field(fieldVars[0], u, settings, index);
+    if (fieldVars.size() > 1)
+        put_gradient_magnitude(fieldVars[1], u, settings, index);
+    if (fieldVars.size() > 2)
+        put_log_field(fieldVars[2], output->residual, settings, index);
+
+    // Scalars, each of which is a single value at this index
+    std::vector<long> corner(index), counts(index.size(), 1);
+    const int shape[2] = {u.rows(), u.columns()};
+    const double spacing[2] = {u.spacing(0), u.spacing(1)};
+    nxVar->set_cur(&corner[0]);
+    nxVar->put(&shape[0], &counts[0]);
+    nzVar->set_cur(&corner[0]);
+    nzVar->put(&shape[1], &counts[0]);
+    hxVar->set_cur(&corner[0]);
+    hxVar->put(&spacing[0], &counts[0]);
+    hzVar->set_cur(&corner[0]);
+    hzVar->put(&spacing[1], &counts[0]);
+    typedef std::pair<std::string, double> Attribute;
+    typedef std::pair<std::string, NcVar*> Scalar;
+    foreach(const Attribute& attribute, output->attributes)
+        foreach(const Scalar& scalar, scalarVars)
+            if (scalar.first == attribute.first) {
+                scalar.second->set_cur(&corner[0]);
+                scalar.second->put(&attribute.second, &counts[0]);
+            }
+}
@@ -0,0 +1,202 @@
+/*
+    output.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Writing grids to netCDF files, block by block, and a background thread
+    to do it on, and reading them back in.
+*/
+
+#ifndef OUTPUT_HPP_C4XJ8N2R
+#define OUTPUT_HPP_C4XJ8N2R
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <netcdfcpp.h>
+#include <boost/utility.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "fdview.hpp"
+#include "fdarray.hpp"
+#include "settings.hpp"
+
+namespace mgrid {
+
+// = Field output functions =
+/*  -- open_output_file creates a file (replacing any that's there) in the
+       format given by the settings.
+    -- add_grid_axes adds x and z dimensions and coordinate variables, and
+       put_grid_axes writes i*hx and j*hz to those variables.
+    -- add_field adds a two-dimensional variable, or one with extra leading
+       dimensions (e.g. sweep parameters) before x and z. In netCDF-4 files
+       this is stored in chunks of settings.chunkRows rows of a single grid,
+       deflated and shuffled as the settings say.
+    -- put_field writes a grid to a variable, settings.chunkRows rows at a
+       time, through a buffer of that many rows. The grid can be strided
+       (e.g. a level of a Stack, or one component of an FDVecArray). For a
+       variable with leading dimensions, index gives the grid's position
+       along them; the grid can be smaller than the variable's x and z
+       dimensions, in which case the rest is left as fill values.
+    -- put_gradient_magnitude and put_log_field work out |grad u| and
+       log10(u) for each block of rows as it's written, so the derived field
+       is never stored in full.
+    All variables should be added before any data is put, so that the file
+    only leaves define mode once. The netCDF library isn't thread safe, so
+    only write one file at a time (e.g. from an OutputQueue).
+*/
+std::auto_ptr<NcFile> open_output_file(const std::string& path,
+    const OutputSettings& settings);
+void add_grid_axes(NcFile& file, const FDView& u, NcDim*& xDim,
+    NcDim*& zDim);
+void put_grid_axes(NcFile& file, const FDView& u);
+NcVar* add_field(NcFile& file, const std::string& name, NcDim* xDim,
+    NcDim* zDim, const OutputSettings& settings);
+NcVar* add_field(NcFile& file, const std::string& name,
+    const std::vector<NcDim*>& dims, const OutputSettings& settings);
+void put_field(NcVar* variable, const FDView& u,
+    const OutputSettings& settings,
+    const std::vector<long>& index=std::vector<long>());
+void put_gradient_magnitude(NcVar* variable, const FDView& u,
+    const OutputSettings& settings,
+    const std::vector<long>& index=std::vector<long>());
+void put_log_field(NcVar* variable, const FDView& u,
+    const OutputSettings& settings,
+    const std::vector<long>& index=std::vector<long>());
+
+// = Field input functions =
+/*  read_field reads the first two-dimensional variable with one of the
+    given names from a netCDF file (e.g. one written by a write method)
+    into values, a row at a time, and gives its shape. It returns false if
+    the file can't be opened or has none of the variables.
+*/
+bool read_field(const std::string& path,
+    const std::vector<std::string>& names, std::vector<double>& values,
+    int& nx, int& nz);
+
+// = SolutionOutput class interface =
+/*  Everything that goes into a solver's output file, which can be written
+    straight away or handed to an OutputQueue. The solution and residual
+    arrays are written as they are, so they should be copies of the solver's
+    arrays if the solver carries on in the meantime (see
+    MultigridBase::snapshot). The residual is only needed if
+    numOfVariables > 2. Copies share the arrays, whose reference counts
+    aren't thread safe, so pass a SolutionOutput to another thread in a
+    boost::shared_ptr and don't keep any other copies of it.
+*/
+class SolutionOutput {
+public:
+    SolutionOutput(): numOfVariables(1), solutionName("solution"),
+        gradientName("gradient") {};
+
+    // Write the file
+    void write();
+
+    // File contents
+    std::string path;
+    OutputSettings settings;
+    int numOfVariables;
+    FDArray solution, residual;
+    std::string solutionName, gradientName;
+    std::vector<std::pair<std::string, double> > attributes;
+    std::string message;            // printed once the file is written
+};
+
+// = OutputQueue class interface =
+/*  Runs output jobs (e.g. SolutionOutput::write) one after another on a
+    background thread, so that solvers can get on with the next problem. At
+    most maxPending jobs are kept waiting, after which push blocks until one
+    has been written - this bounds the memory held by copies of solutions.
+    Jobs that throw are reported, and the queue carries on with the next.
+    The destructor waits for every job to be written.
+*/
+class OutputQueue: private boost::noncopyable {
+public:
+    typedef boost::function<void ()> Job;
+
+    OutputQueue(const std::size_t maxPending=2);
+    ~OutputQueue();
+
+    // Add a job, and wait for all the jobs so far to be written
+    void push(Job job);
+    void wait();
+
+private:
+    void _writer();
+
+    const std::size_t maxPending;
+    std::deque<Job> jobs;
+    bool stopping, busy;
+    boost::mutex lock;
+    boost::condition_variable changed;
+    boost::thread writer;
+};
+
+// = SweepDataset class interface =
+/*  A single netCDF file holding the results of a whole parameter sweep, in
+    place of a file per solver. Each sweep parameter is a dimension, with a
+    coordinate variable holding its values (e.g. aspect_ratio and
+    bingham_fraction), and there should be at least one. Then:
+    -- the fields (solution, gradient magnitude and log residual, in that
+       order, as many as there are field names) have the parameter
+       dimensions followed by x and z. Grids can be different sizes (e.g.
+       for different aspect ratios), so x and z are as big as the largest
+       grid and each grid is written into the corner, with the rest left as
+       fill values. The variables nx and nz give the size of each grid, and
+       hx and hz its spacing.
+    -- each of the scalar names is a variable with just the parameter
+       dimensions, and is filled in from the SolutionOutput attribute of the
+       same name (e.g. total_flux). Other attributes are ignored.
+    add can be called from any thread, with a snapshot which nothing else
+    holds on to (see SolutionOutput): the results are written in order on
+    the dataset's own writer thread, through an OutputQueue, so solvers can
+    carry on meanwhile. The destructor waits for everything to be written
+    and then closes the file.
+*/
+struct SweepAxis {
+    SweepAxis(const std::string& name, const std::vector<double>& values):
+        name(name), values(values) {};
+    std::string name;
+    std::vector<double> values;
+};
+
+class SweepDataset: private boost::noncopyable {
+public:
+    SweepDataset(const std::string& path, const std::vector<SweepAxis>& axes,
+        const int nx, const int nz, const std::vector<std::string>& fieldNames,
+        const std::vector<std::string>& scalarNames,
+        const OutputSettings& settings=OutputSettings(),
+        const std::size_t maxPending=4);
+    ~SweepDataset();
+
+    // Index of the nearest value along each axis to the given parameters
+    std::vector<long> nearest_index(const std::vector<double>& parameters);
+
+    // Add a result at the given index, and wait for them all to be written
+    void add(const std::vector<long>& index,
+        boost::shared_ptr<SolutionOutput> output);
+    void wait();
+
+private:
+    void _write(const std::vector<long>& index,
+        boost::shared_ptr<SolutionOutput> output);
+    NcVar* _add_scalar(const std::string& name, const NcType type);
+
+    const OutputSettings settings;
+    const std::vector<SweepAxis> axes;
+    const int nx, nz;
+    std::auto_ptr<NcFile> file;
+    std::vector<NcDim*> axisDims;
+    std::vector<NcVar*> fieldVars;
+    std::vector<std::pair<std::string, NcVar*> > scalarVars;
+    NcVar *nxVar, *nzVar, *hxVar, *hzVar;
+    OutputQueue queue;      // Last, so it's finished before the file closes
+};
+
+} // end namespace mgrid
+
+#endif /* end of include guard: OUTPUT_HPP_C4XJ8N2R */
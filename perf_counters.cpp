@@ -0,0 +1,107 @@
+/*
+    perf_counters.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "multigrid_exceptions.hpp"
+#include "perf_counters.hpp"
+
+// Each thread's counters, and the first reason they couldn't be opened
+static boost::thread_specific_ptr<mgrid::PerfCounters> threadCounters;
+static boost::mutex failureLock;
+static std::string firstFailure;
+
+#ifdef __linux__
+static int open_counter(const boost::uint64_t config, const int group) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.read_format = PERF_FORMAT_GROUP
+        | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.disabled = (group < 0);
+    return syscall(__NR_perf_event_open, &attributes, 0, -1, group, 0);
+}
+#endif
+
+mgrid::PerfCounters::PerfCounters() {
+    files[0] = files[1] = files[2] = -1;
+#ifdef __linux__
+    const boost::uint64_t events[3] = {PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+    for (int n=0; n<3; n++) {
+        files[n] = open_counter(events[n], files[0]);
+        if (files[n] < 0) {
+            failure = std::string("perf_event_open failed: ")
+                + std::strerror(errno);
+            for (int m=0; m<n; m++) close(files[m]);
+            files[0] = files[1] = files[2] = -1;
+            return;
+        }
+    }
+    ioctl(files[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(files[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    failure = "hardware counters are only supported on Linux";
+#endif
+}
+mgrid::PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int n=0; n<3; n++) if (files[n] >= 0) close(files[n]);
+#endif
+}
+
+bool mgrid::PerfCounters::read(HardwareCounts& result) const {
+#ifdef __linux__
+    // Number of counters, times enabled and running, then the counts
+    boost::uint64_t values[6];
+    if (not(available())
+        || ::read(files[0], values, sizeof(values)) != sizeof(values)
+        || values[2] == 0)
+        return false;
+    const double scale = double(values[1])/values[2];
+    result.cycles = scale*values[3];
+    result.instructions = scale*values[4];
+    result.cacheMisses = scale*values[5];
+    return true;
+#else
+    (void)result;
+    return false;
+#endif
+}
+
+mgrid::PerfCounters* mgrid::PerfCounters::for_this_thread() {
+    if (not(threadCounters.get())) {
+        threadCounters.reset(new PerfCounters());
+        if (not(threadCounters->available())) {
+            boost::mutex::scoped_lock lock(failureLock);
+            if (firstFailure.empty()) {
+                firstFailure = threadCounters->failure;
+                Message msg(WarningMessage);
+                msg << "Hardware counters are unavailable (" << firstFailure
+                    << "), so only times will be profiled" << std::endl;
+                std::cout << msg.str();
+            }
+        }
+    }
+    return threadCounters->available() ? threadCounters.get() : 0;
+}
+std::string mgrid::PerfCounters::unavailable_reason() {
+    boost::mutex::scoped_lock lock(failureLock);
+    return firstFailure;
+}
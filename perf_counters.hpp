@@ -0,0 +1,69 @@
+/*
+    perf_counters.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Hardware performance counters (cycles, instructions and last level
+    cache misses) for the calling thread, read through Linux's
+    perf_event_open.
+*/
+
+#ifndef PERF_COUNTERS_HPP_Q2HV7M5C
+#define PERF_COUNTERS_HPP_Q2HV7M5C
+
+#include <string>
+#include <boost/utility.hpp>
+
+namespace mgrid {
+
+// Counts since the counters were opened, or differences between two reads
+struct HardwareCounts {
+    HardwareCounts(): cycles(0), instructions(0), cacheMisses(0) {};
+    double cycles, instructions, cacheMisses;
+
+    inline HardwareCounts operator-(const HardwareCounts& other) const;
+};
+
+// = PerfCounters class interface =
+/*  A group of counters on the thread which opened them, counting user
+    space only so that they work unprivileged (where perf_event_paranoid
+    is 2 or less). Use for_this_thread rather than making them directly:
+    it opens one group per thread the first time it's called on that
+    thread, and returns null if the counters can't be opened (e.g. without
+    permission, in a virtual machine without a PMU, or on systems other
+    than Linux). The first failure is reported with a warning, and
+    unavailable_reason says what went wrong. Counts are scaled up if the
+    kernel had to share the counters with other groups.
+*/
+class PerfCounters: private boost::noncopyable {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    inline bool available() const;
+    bool read(HardwareCounts& result) const;
+
+    static PerfCounters* for_this_thread();
+    static std::string unavailable_reason();
+
+private:
+    int files[3];              // Group leader (cycles) first
+    std::string failure;
+};
+
+// = Inline methods =
+inline HardwareCounts HardwareCounts::operator-(
+    const HardwareCounts& other) const
+{
+    HardwareCounts result;
+    result.cycles = cycles - other.cycles;
+    result.instructions = instructions - other.instructions;
+    result.cacheMisses = cacheMisses - other.cacheMisses;
+    return result;
+}
+inline bool PerfCounters::available() const {
+    return files[0] >= 0;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: PERF_COUNTERS_HPP_Q2HV7M5C */
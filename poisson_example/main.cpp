@@ -11,6 +11,11 @@ using namespace mgrid;
 using namespace std;
 namespace bpo = boost::program_options; 
 
+// Builds a Poisson solver for the auto-tuner
+MultigridBase* make_poisson(const Settings& settings) {
+    return new Poisson(settings);
+}
+
 int main (int argc, char *argv[]) {
     try{
         // Declare some option variables
@@ -20,7 +25,11 @@ int main (int argc, char *argv[]) {
         bpo::options_description 
             visibleOptions("Usage ./poisson <aspect ratios>\n\nOptions:");
         visibleOptions.add_options() \
-            ("help", "prints this help message");    
+            ("help", "prints this help message") \
+            ("tune", "tune the cycles for each aspect ratio first (or use "
+                "the settings tuned before, from the tuning cache)") \
+            ("lfa", "print a local Fourier analysis of the cycles for each "
+                "aspect ratio instead of solving");    
         bpo::options_description hiddenOptions("Hidden options");
         hiddenOptions.add_options()("aspects", \
             bpo::value< vector<double> >(&aspectRatios), "aspect ratios"); 
@@ -52,9 +61,24 @@ int main (int argc, char *argv[]) {
         foreach(double aspect, aspectRatios) {  
             Settings settings;
             settings.aspectRatio = aspect;
+            if (varMap.count("tune")) {
+                AutoTuner tuner(make_poisson, "poisson");
+                settings = tuner.tune(settings);
+            }
             std::auto_ptr<Poisson> problem(new Poisson(settings));
+            if (varMap.count("lfa")) {
+                fourier_analysis(*problem).report(std::cout, 
+                    settings.preMGRelaxIter, settings.postMGRelaxIter);
+                continue;
+            }
             problem->solve();
             problem->write(1, "poisson_");
+            if (Profiler::enabled()) 
+                problem->write_profile("poisson_" + problem->filename()
+                    + ".profile.json");
+            if (problem->profile().tracer())
+                problem->write_trace("poisson_" + problem->filename()
+                    + ".trace.json");
         }    
         std::cout << "Finished!" << std::endl;
         return 0;
@@ -70,6 +70,23 @@ set(NETCDF_CPP_PROCESS_INCLUDES NETCDF_CPP_INCLUDE_DIR NETCDF_INCLUDE_DIRS)
 set(NETCDF_CPP_PROCESS_LIBS NETCDF_CPP_LIBRARY NETCDF_LIBRARIES)
 libfind_process(NETCDF_CPP)  
 
+# ======================
+# = Find Boost threads =
+# ======================
+# Used by the parameter sweep scheduler
+find_package(Boost COMPONENTS thread system REQUIRED)
+
+# ==================
+# = Find OpenMP    =
+# ==================
+# Optional, used if the library was built with it
+find_package(OpenMP)
+IF(OPENMP_FOUND)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
+    set(CMAKE_EXE_LINKER_FLAGS 
+        "${CMAKE_EXE_LINKER_FLAGS} ${OpenMP_CXX_FLAGS}")
+ENDIF(OPENMP_FOUND)
+
 # ==================
 # = Find Multigrid =
 # ==================
@@ -86,9 +103,11 @@ find_library(MULTIGRID_LIBRARY NAMES multigrid PATHS ${MULTIGRID_PREFIX})
 set(MULTIGRID_PROCESS_INCLUDES 
     MULTIGRID_INCLUDE_DIR 
     BLITZ_INCLUDE_DIRS
-    NETCDF_CPP_INCLUDE_DIRS)
+    NETCDF_CPP_INCLUDE_DIRS
+    Boost_INCLUDE_DIRS)
 set(MULTIGRID_PROCESS_LIBS 
     MULTIGRID_LIBRARY 
     BLITZ_LIBRARIES 
-    NETCDF_CPP_LIBRARIES)
+    NETCDF_CPP_LIBRARIES
+    Boost_LIBRARIES)
 libfind_process(MULTIGRID)
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*
+    profiler.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <cstdlib>
+
+#include "profiler.hpp"
+
+// Bytes brought in by each last level cache miss
+static const double cacheLineBytes = 64;
+
+// Setup
+mgrid::Profiler::Profiler():
+    hardwareCounters(std::getenv("MULTIGRID_PERF_COUNTERS") != 0)
+{
+    if (std::getenv("MULTIGRID_TRACE")) start_trace();
+}
+void mgrid::Profiler::resize(const int numberOfLevels) {
+    levels.resize(numberOfLevels);
+}
+void mgrid::Profiler::set_shape(const Level level, const int nx,
+    const int nz)
+{
+    levels[level].nx = nx;
+    levels[level].nz = nz;
+}
+void mgrid::Profiler::reset() {
+    for (std::size_t level=0; level<levels.size(); level++)
+        for (int phase=0; phase<numberOfProfilePhases; phase++)
+            levels[level].phases[phase] = ProfileCounter();
+}
+void mgrid::Profiler::start_trace(const std::size_t maxEvents) {
+    timeline.reset(new Tracer(maxEvents));
+}
+void mgrid::Profiler::stop_trace() {
+    timeline.reset();
+}
+bool mgrid::Profiler::enabled() {
+#ifdef MULTIGRID_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Totals
+mgrid::ProfileCounter mgrid::Profiler::total(const ProfilePhase phase) const {
+    ProfileCounter result;
+    for (std::size_t level=0; level<levels.size(); level++) {
+        const ProfileCounter& counter = levels[level].phases[phase];
+        result.calls += counter.calls;
+        result.seconds += counter.seconds;
+        result.points += counter.points;
+        result.bytes += counter.bytes;
+        result.flops += counter.flops;
+        result.counted += counter.counted;
+        result.hardware.cycles += counter.hardware.cycles;
+        result.hardware.instructions += counter.hardware.instructions;
+        result.hardware.cacheMisses += counter.hardware.cacheMisses;
+    }
+    return result;
+}
+
+// Report
+static void write_counter(std::ostream& out, const mgrid::ProfileCounter& c) {
+    out << "{\"calls\": " << c.calls << ", \"seconds\": " << c.seconds
+        << ", \"points\": " << c.points << ", \"bytes\": " << c.bytes
+        << ", \"points_per_second\": "
+        << (c.seconds > 0 ? c.points/c.seconds : 0)
+        << ", \"gb_per_second\": "
+        << (c.seconds > 0 ? 1e-9*c.bytes/c.seconds : 0)
+        << ", \"flops\": " << c.flops << ", \"gflops_per_second\": "
+        << (c.seconds > 0 ? 1e-9*c.flops/c.seconds : 0)
+        << ", \"intensity\": " << (c.bytes > 0 ? c.flops/c.bytes : 0);
+    
+    // Measured traffic and intensity, over the calls with hardware counts
+    if (c.counted > 0) {
+        const mgrid::HardwareCounts& h = c.hardware;
+        const double measuredBytes = cacheLineBytes*h.cacheMisses;
+        const double countedFlops = c.flops*c.counted/c.calls;
+        out << ", \"counted_calls\": " << c.counted
+            << ", \"cycles\": " << h.cycles
+            << ", \"instructions\": " << h.instructions
+            << ", \"ipc\": " << (h.cycles > 0 ? h.instructions/h.cycles : 0)
+            << ", \"llc_misses\": " << h.cacheMisses
+            << ", \"measured_bytes\": " << measuredBytes
+            << ", \"measured_gb_per_second\": " << (c.seconds > 0 
+                ? 1e-9*measuredBytes*c.calls/c.counted/c.seconds : 0)
+            << ", \"measured_intensity\": " 
+            << (measuredBytes > 0 ? countedFlops/measuredBytes : 0);
+    }
+    out << "}";
+}
+void mgrid::Profiler::write_json(std::ostream& out,
+    const std::string& name) const
+{
+    // Say why there are no hardware counts if they were asked for
+    unsigned long counted = 0;
+    for (int phase=0; phase<numberOfProfilePhases; phase++)
+        counted += total(ProfilePhase(phase)).counted;
+    const std::string reason = (hardwareCounters && counted == 0)
+        ? PerfCounters::unavailable_reason() : "";
+
+    const std::streamsize precision = out.precision(9);
+    out << "{\n  \"solver\": \"" << name << "\",\n"
+        << "  \"profiling\": " << (enabled() ? "true" : "false") << ",\n"
+        << "  \"hardware_counters\": " << (counted > 0 ? "true" : "false")
+        << ",\n";
+    if (not(reason.empty()))
+        out << "  \"hardware_counters_unavailable\": \"" << reason 
+            << "\",\n";
+    out << "  \"levels\": [";
+    for (std::size_t level=0; level<levels.size(); level++) {
+        out << (level > 0 ? ",\n" : "\n") << "    {\"level\": " << level
+            << ", \"nx\": " << levels[level].nx
+            << ", \"nz\": " << levels[level].nz << ", \"phases\": {";
+        for (int phase=0; phase<numberOfProfilePhases; phase++) {
+            out << (phase > 0 ? ", " : "") << "\n      \""
+                << profilePhaseNames[phase] << "\": ";
+            write_counter(out, levels[level].phases[phase]);
+        }
+        out << "}}";
+    }
+    out << "\n  ],\n  \"totals\": {";
+    for (int phase=0; phase<numberOfProfilePhases; phase++) {
+        out << (phase > 0 ? "," : "") << "\n    \""
+            << profilePhaseNames[phase] << "\": ";
+        write_counter(out, total(ProfilePhase(phase)));
+    }
+    out << "\n  }\n}\n";
+    out.precision(precision);
+}
@@ -0,0 +1,245 @@
+/*
+    profiler.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Timing and work counts for each phase of a multigrid solve, on each
+    level of the grid stack.
+*/
+
+#ifndef PROFILER_HPP_H6QZ2M4B
+#define PROFILER_HPP_H6QZ2M4B
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <memory>
+#include <time.h>
+#include <boost/utility.hpp>
+
+#include "types.hpp"
+#include "perf_counters.hpp"
+#include "tracer.hpp"
+
+namespace mgrid {
+
+// = Profiled phases =
+enum ProfilePhase {relaxPhase, residualPhase, restrictPhase, prolongPhase,
+    boundaryPhase, coarseSolvePhase};
+const int numberOfProfilePhases = 6;
+const char* const profilePhaseNames[numberOfProfilePhases] =
+    {"relax", "residual", "restrict", "prolong", "boundary", "coarse_solve"};
+
+// Estimated floating point operations per point of each phase, for five
+// point operators (nine point operators take about twice as many). These
+// can't be counted portably, so they're used for the arithmetic intensity.
+const double profilePhaseFlops[numberOfProfilePhases] =
+    {10, 10, 17, 3, 2, 14};
+
+// Totals for one phase on one level. Points counts the grid points updated
+// (or written), and bytes is an estimate of the memory traffic, counting
+// each array a kernel streams through once. The hardware counts only 
+// cover the calls which could read the counters (counted).
+struct ProfileCounter {
+    ProfileCounter(): calls(0), counted(0), seconds(0), points(0), bytes(0),
+        flops(0) {};
+    unsigned long calls, counted;
+    double seconds, points, bytes, flops;
+    HardwareCounts hardware;
+};
+
+// = Profiler class interface =
+/*  Each solver has a Profiler, which the PROFILE_SCOPE macros below add to.
+    These only do anything if the library is built with MULTIGRID_PROFILING
+    defined (cmake -DMULTIGRID_PROFILING=ON); otherwise the counters stay at
+    zero and cost nothing. Phases don't overlap: relax covers the sweeps of
+    relax(level, N) and boundary the boundary updates after them, while
+    coarse_solve covers the whole of relax(level, tolerance).
+
+    write_json writes the counters to a stream as a JSON object, with a
+    list of levels (coarsest first), each with its grid shape and a
+    counter for each phase, and the totals of each phase over all levels.
+    Counters on different levels can be added to from different threads at
+    once (as in the additive cycle), but not the same level.
+
+    If hardware counters are switched on (with use_hardware_counters, or by
+    setting the MULTIGRID_PERF_COUNTERS environment variable), each phase
+    also counts cycles, instructions and last level cache misses (see
+    perf_counters.hpp). The report then gives the memory traffic measured
+    from the cache misses as well as the estimate, and the arithmetic
+    intensity (estimated flops per byte) of each, for placing kernels on a
+    roofline. Without counters (or permission to use them) only the
+    estimates are reported.
+
+    start_trace also records a timeline of every profiled phase, and of the
+    cycles and level visits marked with TRACE_SCOPE, in a Tracer (see
+    tracer.hpp). Tracing starts straight away if the MULTIGRID_TRACE
+    environment variable is set. tracer() is null when it's off.
+*/
+class Profiler: private boost::noncopyable {
+public:
+    Profiler();
+
+    // Setup
+    void resize(const int numberOfLevels);
+    void set_shape(const Level level, const int nx, const int nz);
+    void reset();
+
+    // Counters
+    inline void record(const ProfilePhase phase, const Level level,
+        const double seconds, const double points, const double bytes,
+        const HardwareCounts* hardware=0);
+    inline const ProfileCounter& counter(const ProfilePhase phase,
+        const Level level) const;
+    ProfileCounter total(const ProfilePhase phase) const;
+
+    // Report
+    void write_json(std::ostream& out, const std::string& name) const;
+
+    // Monotonic wall clock time in seconds
+    static inline double now();
+
+    // Is profiling compiled in?
+    static bool enabled();
+
+    // Hardware counters
+    inline void use_hardware_counters(const bool use);
+    inline bool hardware_counters() const;
+
+    // Timeline
+    void start_trace(const std::size_t maxEvents=1000000);
+    void stop_trace();
+    inline Tracer* tracer();
+
+private:
+    bool hardwareCounters;
+    std::auto_ptr<Tracer> timeline;
+    struct LevelCounters {
+        LevelCounters(): nx(0), nz(0) {};
+        int nx, nz;
+        ProfileCounter phases[numberOfProfilePhases];
+    };
+    std::vector<LevelCounters> levels;
+};
+
+// = ProfileScope class interface =
+/*  Times itself from construction to destruction, and adds the time and
+    any work given to add_work to the profiler (if it's not null). Use it
+    through the macros, so that it compiles away when profiling is off.
+*/
+class ProfileScope: private boost::noncopyable {
+public:
+    ProfileScope(Profiler* profiler, const ProfilePhase phase,
+        const Level level): profiler(profiler), phase(phase), level(level),
+        points(0), bytes(0)
+    {
+        counters = (profiler && profiler->hardware_counters()) 
+            ? PerfCounters::for_this_thread() : 0;
+        if (counters && not(counters->read(startCounts))) counters = 0;
+        start = Profiler::now();
+    };
+    ~ProfileScope() {
+        if (not(profiler)) return;
+        const double end = Profiler::now(), seconds = end - start;
+        if (profiler->tracer())
+            profiler->tracer()->add(profilePhaseNames[phase], "kernel", start,
+                end, level);
+        HardwareCounts endCounts;
+        if (counters && counters->read(endCounts)) {
+            const HardwareCounts counts = endCounts - startCounts;
+            profiler->record(phase, level, seconds, points, bytes, &counts);
+        } else {
+            profiler->record(phase, level, seconds, points, bytes);
+        }
+    }
+    inline void add_work(const double morePoints, const double moreBytes) {
+        points += morePoints;
+        bytes += moreBytes;
+    }
+
+private:
+    Profiler* profiler;
+    const ProfilePhase phase;
+    const Level level;
+    double points, bytes;
+    PerfCounters* counters;
+    HardwareCounts startCounts;
+    double start;
+};
+
+// = TraceScope class interface =
+/*  Adds a span covering its lifetime to a profiler's timeline, if it has
+    one, for parts of a solve which aren't profiled phases (cycles and level
+    visits). level and cycle are -1 if they don't apply.
+*/
+class TraceScope: private boost::noncopyable {
+public:
+    TraceScope(Profiler* profiler, const char* name, const Level level,
+        const int cycle): timeline(profiler->tracer()), name(name),
+        level(level), cycle(cycle), start(timeline ? Profiler::now() : 0) {};
+    ~TraceScope() {
+        if (timeline)
+            timeline->add(name, "cycle", start, Profiler::now(), level, cycle);
+    }
+
+private:
+    Tracer* timeline;
+    const char* name;
+    const Level level;
+    const int cycle;
+    const double start;
+};
+
+#ifdef MULTIGRID_PROFILING
+#define PROFILE_SCOPE(name, profiler, phase, level) \
+    mgrid::ProfileScope name(profiler, phase, level)
+#define PROFILE_WORK(name, points, bytes) name.add_work(points, bytes)
+#define TRACE_SCOPE(name, profiler, label, level, cycle) \
+    mgrid::TraceScope name(profiler, label, level, cycle)
+#else
+#define PROFILE_SCOPE(name, profiler, phase, level)
+#define PROFILE_WORK(name, points, bytes)
+#define TRACE_SCOPE(name, profiler, label, level, cycle)
+#endif
+
+// = Inline methods =
+inline void Profiler::record(const ProfilePhase phase, const Level level,
+    const double seconds, const double points, const double bytes,
+    const HardwareCounts* hardware)
+{
+    if (level < 0 || level >= Level(levels.size())) return;
+    ProfileCounter& counter = levels[level].phases[phase];
+    counter.calls++;
+    counter.seconds += seconds;
+    counter.points += points;
+    counter.bytes += bytes;
+    counter.flops += profilePhaseFlops[phase]*points;
+    if (hardware) {
+        counter.counted++;
+        counter.hardware.cycles += hardware->cycles;
+        counter.hardware.instructions += hardware->instructions;
+        counter.hardware.cacheMisses += hardware->cacheMisses;
+    }
+}
+inline const ProfileCounter& Profiler::counter(const ProfilePhase phase,
+    const Level level) const
+{
+    return levels[level].phases[phase];
+}
+inline void Profiler::use_hardware_counters(const bool use) {
+    hardwareCounters = use;
+}
+inline bool Profiler::hardware_counters() const {
+    return hardwareCounters;
+}
+inline Tracer* Profiler::tracer() {
+    return timeline.get();
+}
+inline double Profiler::now() {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + 1e-9*time.tv_nsec;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: PROFILER_HPP_H6QZ2M4B */
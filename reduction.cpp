@@ -0,0 +1,66 @@
+/*
+    reduction.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include "reduction.hpp"
+
+// Sums of products, blocked in the same way as blocked_sum
+double mgrid::blocked_sum_of_products(const FDView& a, const FDView& b) {
+    const int nx = a.rows(), nz = a.columns();
+    if (nx <= 0 || nz <= 0) return 0;
+    const int rowsPerBlock = std::max(1, reductionBlockSize/nz);
+    const int nBlocks = (nx + rowsPerBlock - 1)/rowsPerBlock;
+    std::vector<double> blockSums(nBlocks);
+    const KernelTable& k = kernels();
+
+#pragma omp parallel for schedule(static) if(nBlocks > 1)
+    for (int block=0; block < nBlocks; block++) {
+        const int i1 = std::min(nx, (block + 1)*rowsPerBlock);
+        double lanes[4] = {0, 0, 0, 0};
+        for (int i=block*rowsPerBlock; i < i1; i++)
+            k.accumulate_products(&a(i, 0), a.stride(1), &b(i, 0),
+                b.stride(1), nz, lanes);
+        blockSums[block] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    double result = 0;
+    for (int block=0; block < nBlocks; block++) result += blockSums[block];
+    return result;
+}
+
+// Integrals
+double mgrid::simpson_integral(const FDView& u) {
+    /*
+        This uses an extended Simpsons rule, of the form:
+        int(f(1..n)) = h*(17/48*f(0) + 59/48*f(1) + 43/48*f(2) + 49/48*f(3)
+                + f(4) + f(5) + f(6) .... + f(n-5) + f(n-4)
+                + 49/48*f(n-4) + 43/48*f(n-3) + 59/48*f(n-2) + 17/48*f(n-1))
+    */
+    // Interpolating polynomial coefficients (precalculated)
+    static const double A = 17/48.;
+    static const double B = 59/48.;
+    static const double C = 43/48.;
+    static const double D = 49/48.;
+    const int nx = u.rows(), nz = u.columns();
+    const double hx = u.spacing(0), hz = u.spacing(1);
+
+    // Do integrals along array rows, which are independent of each other
+    std::vector<double> rowIntegrals(nx);
+#pragma omp parallel for schedule(static) if(nx*nz > reductionBlockSize)
+    for (int i=0; i<nx; i++) {
+        double rowIntegral = A*u(i, 0) + B*u(i, 1) + C*u(i, 2) + D*u(i, 3);
+        for (int j=4; j<nz-4; j++) rowIntegral += u(i, j);
+        rowIntegral += A*u(i, nz-1) + B*u(i, nz-2) + C*u(i, nz-3)
+            + D*u(i, nz-4);
+        rowIntegrals[i] = rowIntegral*hz;
+    }
+
+    // Do integrals along array columns
+    double result = A*rowIntegrals[0] + B*rowIntegrals[1] + C*rowIntegrals[2]
+        + D*rowIntegrals[3];
+    for (int i=4; i<nx-4; i++) result += rowIntegrals[i];
+    result += A*rowIntegrals[nx-1] + B*rowIntegrals[nx-2]
+        + C*rowIntegrals[nx-3] + D*rowIntegrals[nx-4];
+    return result*hx;
+}
@@ -0,0 +1,179 @@
+/*
+    reduction.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Reproducible sums, norms and integrals over grids
+*/
+
+#ifndef REDUCTION_HPP_T7K2WQ9E
+#define REDUCTION_HPP_T7K2WQ9E
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "types.hpp"
+#include "fdview.hpp"
+#include "kernels.hpp"
+
+namespace mgrid {
+
+// Number of points in each block of a blocked reduction
+const int reductionBlockSize = 4096;
+
+// = Blocked reductions =
+/*  The grid is split into blocks of whole rows, of about reductionBlockSize
+    points each. The terms in each block are added up in a fixed order (four
+    interleaved partial sums along each row, so that the loop vectorises),
+    and then the block sums are added up in order. The blocks only depend on
+    the shape of the grid, so the result is the same to the last bit however
+    many threads share out the blocks, and whether or not the library was
+    built with OpenMP. This matters because convergence checks compare these
+    sums against tolerances.
+
+    A Term is anything with a method double operator()(int i, int j) const,
+    so fused expressions (like the norm of a difference) can be reduced
+    without building a temporary array. See the terms below.
+*/
+template <class Term>
+double blocked_sum(const Term& term, const int nx, const int nz);
+template <class Term>
+double blocked_max(const Term& term, const int nx, const int nz);
+
+// The blocked sum of a*b, with the rows added up by the accumulate_products
+// kernel (see kernels.hpp), which gives the same result as blocked_sum
+double blocked_sum_of_products(const FDView& a, const FDView& b);
+
+// = Reduction terms =
+/*  Squares, products and absolute values of grids, the squared magnitude of
+    a vector field and of the difference of two vector fields, and the
+    square of any other term.
+*/
+struct SquareTerm {
+    SquareTerm(const FDView& u): u(u) {};
+    inline double operator()(const int i, const int j) const {
+        return u(i, j)*u(i, j);
+    }
+    FDView u;
+};
+struct ProductTerm {
+    ProductTerm(const FDView& a, const FDView& b): a(a), b(b) {};
+    inline double operator()(const int i, const int j) const {
+        return a(i, j)*b(i, j);
+    }
+    FDView a, b;
+};
+struct AbsoluteTerm {
+    AbsoluteTerm(const FDView& u): u(u) {};
+    inline double operator()(const int i, const int j) const {
+        return fabs(u(i, j));
+    }
+    FDView u;
+};
+struct VectorSquareTerm {
+    VectorSquareTerm(const FDView& x, const FDView& z): x(x), z(z) {};
+    inline double operator()(const int i, const int j) const {
+        return x(i, j)*x(i, j) + z(i, j)*z(i, j);
+    }
+    FDView x, z;
+};
+struct VectorDifferenceSquareTerm {
+    VectorDifferenceSquareTerm(const FDView& ax, const FDView& az,
+        const FDView& bx, const FDView& bz): ax(ax), az(az), bx(bx), bz(bz) {};
+    inline double operator()(const int i, const int j) const {
+        const double dx = ax(i, j) - bx(i, j), dz = az(i, j) - bz(i, j);
+        return dx*dx + dz*dz;
+    }
+    FDView ax, az, bx, bz;
+};
+template <class Term>
+struct SquaredTerm {
+    SquaredTerm(const Term& term): term(term) {};
+    inline double operator()(const int i, const int j) const {
+        const double value = term(i, j);
+        return value*value;
+    }
+    Term term;
+};
+
+// = Reductions over grids =
+/*  -- sum_of_squares gives the sum of u^2 (or of |v|^2 for a vector field
+       with components x and z).
+    -- inner_product gives the sum of a*b.
+    -- distance_squared gives the sum of |a - b|^2 for vector fields.
+    -- max_norm gives the largest |u|.
+    -- simpson_integral gives the integral of u over the grid using the
+       extended Simpson's rule (see FDArray::calculate_flux). Rows are
+       integrated in parallel, and then the row integrals in order.
+*/
+inline double sum_of_squares(const FDView& u) {
+    return blocked_sum_of_products(u, u);
+}
+inline double sum_of_squares(const FDView& x, const FDView& z) {
+    return blocked_sum(VectorSquareTerm(x, z), x.rows(), x.columns());
+}
+inline double inner_product(const FDView& a, const FDView& b) {
+    return blocked_sum_of_products(a, b);
+}
+inline double distance_squared(const FDView& ax, const FDView& az,
+    const FDView& bx, const FDView& bz)
+{
+    return blocked_sum(VectorDifferenceSquareTerm(ax, az, bx, bz),
+        ax.rows(), ax.columns());
+}
+inline double max_norm(const FDView& u) {
+    return blocked_max(AbsoluteTerm(u), u.rows(), u.columns());
+}
+double simpson_integral(const FDView& u);
+
+// = Blocked reduction templates =
+template <class Term>
+double blocked_sum(const Term& term, const int nx, const int nz) {
+    if (nx <= 0 || nz <= 0) return 0;
+    const int rowsPerBlock = std::max(1, reductionBlockSize/nz);
+    const int nBlocks = (nx + rowsPerBlock - 1)/rowsPerBlock;
+    std::vector<double> blockSums(nBlocks);
+
+#pragma omp parallel for schedule(static) if(nBlocks > 1)
+    for (int block=0; block < nBlocks; block++) {
+        const int i1 = std::min(nx, (block + 1)*rowsPerBlock);
+        double lanes[4] = {0, 0, 0, 0};
+        for (int i=block*rowsPerBlock; i < i1; i++) {
+            int j = 0;
+            for (; j+3 < nz; j+=4) {
+                lanes[0] += term(i, j);
+                lanes[1] += term(i, j+1);
+                lanes[2] += term(i, j+2);
+                lanes[3] += term(i, j+3);
+            }
+            for (; j < nz; j++) lanes[j & 3] += term(i, j);
+        }
+        blockSums[block] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    double result = 0;
+    for (int block=0; block < nBlocks; block++) result += blockSums[block];
+    return result;
+}
+template <class Term>
+double blocked_max(const Term& term, const int nx, const int nz) {
+    if (nx <= 0 || nz <= 0) return 0;
+    const int rowsPerBlock = std::max(1, reductionBlockSize/nz);
+    const int nBlocks = (nx + rowsPerBlock - 1)/rowsPerBlock;
+    std::vector<double> blockMaxima(nBlocks);
+
+#pragma omp parallel for schedule(static) if(nBlocks > 1)
+    for (int block=0; block < nBlocks; block++) {
+        const int i1 = std::min(nx, (block + 1)*rowsPerBlock);
+        double result = term(block*rowsPerBlock, 0);
+        for (int i=block*rowsPerBlock; i < i1; i++)
+            for (int j=0; j < nz; j++)
+                result = std::max(result, term(i, j));
+        blockMaxima[block] = result;
+    }
+    return *std::max_element(blockMaxima.begin(), blockMaxima.end());
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: REDUCTION_HPP_T7K2WQ9E */
@@ -14,6 +14,21 @@ static const int              defaultNumberOfGrids           = 8;
 static const unsigned long    defaultPreMGRelaxIter          = 1;
 static const unsigned long    defaultPostMGRelaxIter         = 2; 
 static const double           defaultResidualTolerance       = 1e-10;
+static const mgrid::CoarseOperatorType 
+                              defaultCoarseOperator          = mgrid::rediscretisedOperator;
+static const int              defaultAgglomerationSize       = 32;
+static const bool             defaultHugePages               = false;
+static const int              defaultTileSize                = 0;
+static const double           defaultCheckpointInterval      = 0;
+static const char* const      defaultCheckpointPath          = "";
+static const bool             defaultTrackConvergence        = false;
+
+// Default settings for OutputSettings
+static const bool             defaultNetcdf4                 = false;
+static const int              defaultDeflateLevel            = 0;
+static const bool             defaultShuffle                 = true;
+static const int              defaultChunkRows               = 64;
+static const bool             defaultSolveStatistics         = false;
 
 // Apply default settings on construction
 mgrid::Settings::Settings():
@@ -24,4 +39,18 @@ mgrid::Settings::Settings():
     maximumIterations(defaultMaximumIterations),
     mgCycleType(defaultMgCycleType),
     preMGRelaxIter(defaultPreMGRelaxIter),
-    postMGRelaxIter(defaultPostMGRelaxIter) { /* pass */ }
\ No newline at end of file
+    postMGRelaxIter(defaultPostMGRelaxIter),
+    coarseOperator(defaultCoarseOperator),
+    agglomerationSize(defaultAgglomerationSize),
+    hugePages(defaultHugePages),
+    tileSize(defaultTileSize),
+    checkpointInterval(defaultCheckpointInterval),
+    checkpointPath(defaultCheckpointPath),
+    trackConvergence(defaultTrackConvergence) { /* pass */ }
+
+mgrid::OutputSettings::OutputSettings():
+    netcdf4(defaultNetcdf4),
+    deflateLevel(defaultDeflateLevel),
+    shuffle(defaultShuffle),
+    chunkRows(defaultChunkRows),
+    solveStatistics(defaultSolveStatistics) { /* pass */ }
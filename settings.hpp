@@ -8,11 +8,27 @@
 #ifndef SETTINGS_HPP_7RZE6Z3D
 #define SETTINGS_HPP_7RZE6Z3D       
 
+#include <string>
+
 #include "types.hpp" 
 #include "multigrid_exceptions.hpp"
 
 namespace mgrid {
     
+// Output settings, used when writing solutions to file (see output.hpp)
+struct OutputSettings {
+    bool netcdf4;                       // netCDF-4/HDF5 files (else classic)
+    int deflateLevel;                   // 0 (none) to 9, netCDF-4 only
+    bool shuffle;                       // Shuffle bytes before deflating
+    int chunkRows;                      // Rows in each chunk of a field,
+                                        // which are written at once
+    bool solveStatistics;               // Add the solve's work units and 
+                                        // convergence as attributes
+    
+    // Ctor etc
+    OutputSettings(); // Default settings in settings.cpp
+};
+
 // Settings struct
 struct Settings { 
     double aspectRatio; 
@@ -23,6 +39,18 @@ struct Settings {
     CycleType mgCycleType;
     unsigned long preMGRelaxIter;
     unsigned long postMGRelaxIter;
+    CoarseOperatorType coarseOperator;  // Only used by LinearMultigrid
+    int agglomerationSize;              // Only used by DistributedLinearMultigrid
+    bool hugePages;                     // Use huge pages for Stack arenas
+    int tileSize;                       // Tile width for cache-blocked 
+                                        // sweeps and transfers (0 for none)
+    OutputSettings output;              // Used by the write methods
+    double checkpointInterval;          // Seconds between background 
+                                        // checkpoints (0 for none)
+    std::string checkpointPath;         // Checkpoint file (if empty, 
+                                        // filename() + ".checkpoint")
+    bool trackConvergence;              // Record the residual after every 
+                                        // cycle (see solve_result.hpp)
         
     // Ctor etc
     Settings(); // Default settings in settings.cpp
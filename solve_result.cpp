@@ -0,0 +1,77 @@
+/*
+    solve_result.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "solve_result.hpp"
+
+void mgrid::SolveResult::clear() {
+    cycles.clear();
+    coarseIterations.clear();
+    workUnits = 0;
+    finalResidual = 0;
+}
+
+void mgrid::SolveResult::add(const SolveResult& other) {
+    for (std::size_t n=0; n<other.cycles.size(); n++) {
+        cycles.push_back(other.cycles[n]);
+        cycles.back().workUnits += workUnits;
+    }
+    coarseIterations.insert(coarseIterations.end(),
+        other.coarseIterations.begin(), other.coarseIterations.end());
+    workUnits += other.workUnits;
+    finalResidual = other.finalResidual;
+}
+
+double mgrid::SolveResult::convergence_factor(Level level) const {
+    // Default to the finest level which has any cycles
+    if (level < 0)
+        for (std::size_t n=0; n<cycles.size(); n++)
+            level = std::max(level, cycles[n].level);
+    double logSum = 0;
+    int count = 0;
+    for (std::size_t n=0; n<cycles.size(); n++) {
+        if (cycles[n].level != level) continue;
+        const double factor = cycles[n].convergence_factor();
+        if (factor <= 0) continue;
+        logSum += std::log(factor);
+        count++;
+    }
+    return count > 0 ? std::exp(logSum/count) : 0;
+}
+unsigned long mgrid::SolveResult::total_coarse_iterations() const {
+    unsigned long result = 0;
+    for (std::size_t n=0; n<coarseIterations.size(); n++)
+        result += coarseIterations[n];
+    return result;
+}
+
+void mgrid::SolveResult::add_attributes(
+    std::vector<std::pair<std::string, double> >& attributes) const
+{
+    attributes.push_back(std::make_pair("work_units", workUnits));
+    attributes.push_back(std::make_pair("final_residual", finalResidual));
+    attributes.push_back(std::make_pair("convergence_factor",
+        convergence_factor()));
+    attributes.push_back(std::make_pair("cycles", double(cycles.size())));
+    attributes.push_back(std::make_pair("coarse_iterations",
+        double(total_coarse_iterations())));
+}
+
+void mgrid::SolveResult::print(std::ostream& out) const {
+    char line[120];
+    out << " level cycle   residual     factor  work units" << std::endl;
+    for (std::size_t n=0; n<cycles.size(); n++) {
+        const CycleRecord& c = cycles[n];
+        std::sprintf(line, "%6d %5d %10.3e %10.4f %11.2f", c.level, c.cycle,
+            c.residualAfter, c.convergence_factor(), c.workUnits);
+        out << line << std::endl;
+    }
+    std::sprintf(line, "%.2f work units, %lu coarse iterations, final "
+        "residual %.3e", workUnits, total_coarse_iterations(), finalResidual);
+    out << line << std::endl;
+}
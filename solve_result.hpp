@@ -0,0 +1,83 @@
+/*
+    solve_result.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Record of how a multigrid solve went: the residual after each cycle,
+    the work done and the iterations of each coarse grid solve.
+*/
+
+#ifndef SOLVE_RESULT_HPP_P4XN8R2W
+#define SOLVE_RESULT_HPP_P4XN8R2W
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#include "types.hpp"
+
+namespace mgrid {
+
+// One cycle of a solve: the FMG level it ran on (the finest level for the
+// additive cycle), its number on that level, and the RMS residual on that
+// level before and after it. workUnits is the work done by the solve up
+// to the end of the cycle.
+struct CycleRecord {
+    Level level;
+    int cycle;
+    double residualBefore, residualAfter;
+    double workUnits;
+
+    inline double convergence_factor() const;
+};
+
+// = SolveResult struct =
+/*  Filled in by each call of multigrid() or additive_multigrid() (but not
+    by LinearMultigrid::precondition). The residual history (cycles) is only recorded if
+    Settings::trackConvergence is set, since it takes an extra residual
+    evaluation per cycle; the rest is always there.
+
+    Work units count relaxation sweeps, each weighted by the number of
+    points on its level relative to the finest level, so one sweep of the
+    finest grid is one work unit. Residual evaluations and transfers aren't
+    counted. coarseIterations holds the number of sweeps of each solve on
+    the coarsest level, in order.
+*/
+struct SolveResult {
+    SolveResult() { clear(); };
+    void clear();
+
+    // Adds another solve on to the end of this one, as if they were one
+    // solve (e.g. the inner solves of a nonlinear iteration). Its cycles'
+    // work units are counted on from this one's, and its final residual
+    // replaces this one's.
+    void add(const SolveResult& other);
+
+    std::vector<CycleRecord> cycles;
+    std::vector<unsigned long> coarseIterations;
+    double workUnits;
+    double finalResidual;           // RMS residual on the finest level
+                                    // (see MultigridBase::solve_result)
+
+    // Geometric mean of the convergence factors of the cycles on a level
+    // (the finest by default), or 0 if none were recorded
+    double convergence_factor(Level level=-1) const;
+    unsigned long total_coarse_iterations() const;
+
+    // Adds work_units, final_residual, convergence_factor, cycles and
+    // coarse_iterations to a list of attributes (as used by SolutionOutput)
+    void add_attributes(
+        std::vector<std::pair<std::string, double> >& attributes) const;
+
+    // Writes the history as a table, one line per cycle
+    void print(std::ostream& out) const;
+};
+
+// = Inline methods =
+inline double CycleRecord::convergence_factor() const {
+    return residualBefore > 0 ? residualAfter/residualBefore : 0;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: SOLVE_RESULT_HPP_P4XN8R2W */
@@ -5,34 +5,123 @@
     Implementation of Stack class
 */          
 
+#include <algorithm>
+
 #include "stack.hpp"                  
                     
-// Ctor
-mgrid::Stack::Stack(const mgrid::Settings& s): 
-    finestLevel(s.numberOfGrids-1), aspect(s.aspectRatio), 
-    nGrids(s.numberOfGrids), minRes(s.minimumResolution)
-{
-    // Generate grid stack
-    resize(nGrids); 
-                          
-    // Generate coarsest level
+// Grid geometry
+boost::tuple<int, int> mgrid::grid_shape(const Settings& s, Level level) {
+    // Coarsest level
     int nx, nz;
-    if (aspect <= 1.99999999999999999999999) {
+    const int minRes = s.minimumResolution;
+    if (s.aspectRatio <= 1.99999999999999999999999) {
         nx = minRes;
-        nz = int(round(2*(minRes-1)/aspect) + 1);
+        nz = int(round(2*(minRes-1)/s.aspectRatio) + 1);
     } else {
-        nx = int(round(aspect*(minRes-1)/2.0 + 1));
+        nx = int(round(s.aspectRatio*(minRes-1)/2.0 + 1));
         nz = minRes;
     }   
-    (*this)[coarsestLevel].resize(aspect, nx, nz); 
-    (*this)[coarsestLevel] = 0;
-
-    // Proceed for all other grid sizes, caching geometry as we go...
-    for (Level level=1; level<=finestLevel; level++) {   
+    
+    // Each finer level doubles the number of intervals
+    for (Level l=1; l<=level; l++) {
         nx = 2*(nx - 1) + 1; 
         nz = 2*(nz - 1) + 1;
-        (*this)[level].resize(aspect, nx, nz);      
-        (*this)[level] = 0;
+    }
+    return boost::make_tuple(nx, nz);
+}
+std::size_t mgrid::stack_memory(const Settings& s) {
+    std::size_t result = 0;
+    int nx, nz;
+    for (Level level=0; level<s.numberOfGrids; level++) {
+        boost::tie(nx, nz) = grid_shape(s, level);
+        result += std::size_t(nx)*Arena::padded_columns(nz)*sizeof(double);
+    }
+    return result;
+}
+
+// Resampling
+static int doublings(const int coarse, const int fine) {
+    // Number of times the intervals between coarse points have to be halved
+    // to give fine points, or -1 if they can't be
+    int result = 0;
+    for (int intervals=coarse-1; intervals>0 && intervals<=fine-1; 
+        intervals*=2, result++)
+        if (intervals == fine-1) return result;
+    return -1;
+}
+void mgrid::resample(FDView from, FDView to) {
+    const int nxFrom = from.rows(), nzFrom = from.columns();
+    const int nxTo = to.rows(), nzTo = to.columns();
+    const int up = doublings(nxFrom, nxTo);
+    const int down = doublings(nxTo, nxFrom);
+    const bool refining = (up > 0 && doublings(nzFrom, nzTo) == up);
+    const bool coarsening = (down > 0 && doublings(nzTo, nzFrom) == down);
+    if (nxFrom == nxTo && nzFrom == nzTo) {
+        ARRAY_LOOP(to) to(i, j) = from(i, j);
+    } else if (refining || coarsening) {
+        // Transfer a level at a time, through a pair of buffers for the 
+        // levels in between
+        const int steps = refining ? up : down;
+        std::vector<double> buffers[2];
+        FDView current = from;
+        for (int step=0; step<steps; step++) {
+            const int nx = refining ? 2*(current.rows() - 1) + 1 
+                : (current.rows() - 1)/2 + 1;
+            const int nz = refining ? 2*(current.columns() - 1) + 1 
+                : (current.columns() - 1)/2 + 1;
+            FDView next = to;
+            if (step < steps-1) {
+                buffers[step%2].resize(std::size_t(nx)*nz);
+                next = FDView(&buffers[step%2][0], nx, nz, nz, 1, 
+                    to.spacing(0), to.spacing(1));
+            }
+            if (refining) {
+                interpolation_operator(current, next);
+            } else {
+                restriction_operator(next, current);
+            }
+            current = next;
+        }
+    } else {
+        // Bilinear interpolation, with the corners of both grids lined up
+        const double xScale = double(nxFrom - 1)/std::max(1, nxTo - 1);
+        const double zScale = double(nzFrom - 1)/std::max(1, nzTo - 1);
+        for (int i=0; i<nxTo; i++) {
+            const int I = std::max(0, std::min(int(i*xScale), nxFrom-2));
+            const double fx = i*xScale - I;
+            for (int j=0; j<nzTo; j++) {
+                const int J = std::max(0, std::min(int(j*zScale), nzFrom-2));
+                const double fz = j*zScale - J;
+                to(i, j) = (1-fx)*((1-fz)*from(I, J) + fz*from(I, J+1))
+                    + fx*((1-fz)*from(I+1, J) + fz*from(I+1, J+1));
+            }
+        }
+    }
+}
+
+// Ctor
+mgrid::Stack::Stack(const mgrid::Settings& s): 
+    finestLevel(s.numberOfGrids-1), tileSize(s.tileSize), 
+    aspect(s.aspectRatio), 
+    nGrids(s.numberOfGrids), minRes(s.minimumResolution), profiler(0)
+{
+    // Generate grid stack
+    resize(nGrids); 
+    
+    // Lay the levels out one after another in a single arena, coarsest first
+    int nx = 0, nz = 0;
+    std::vector<std::size_t> offsets(nGrids + 1, 0);
+    for (Level level=coarsestLevel; level<=finestLevel; level++) {
+        boost::tie(nx, nz) = grid_shape(s, level);
+        offsets[level + 1] = offsets[level] 
+            + std::size_t(nx)*Arena::padded_columns(nz);
+    }
+    arena.reset(new Arena(offsets[nGrids], s.hugePages));
+    for (Level level=coarsestLevel; level<=finestLevel; level++) {
+        boost::tie(nx, nz) = grid_shape(s, level);
+        (*this)[level].resize_in(arena->data() + offsets[level], 
+            Arena::padded_columns(nz), aspect, nx, nz);
+        _first_touch(level);
     }     
     
     // Set default boundary conditions
@@ -43,6 +132,78 @@ mgrid::Stack::Stack(const mgrid::Settings& s):
         _update_boundary_conditions(boundaryFlag);
 }
 
+// Checkpointing
+void mgrid::Stack::checkpoint(CheckpointWriter& checkpoint, 
+    const std::string& name) 
+{
+    checkpoint.add(name, arena->data(), memory());
+    
+    // Boundary conditions as (condition type, value) pairs, a boundary at a 
+    // time
+    std::vector<double> boundaries;
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags) {
+        Boundary& boundary = boundaryConditions.get(boundaryFlag);
+        for (int n=0; n<boundary.extent(0); n++) {
+            boundaries.push_back(boundary(n).conditionType);
+            boundaries.push_back(boundary(n).value);
+        }
+    }
+    checkpoint.add(name + "_boundaries", boundaries);
+}
+void mgrid::Stack::restore(CheckpointReader& checkpoint, 
+    const std::string& name) 
+{
+    // Check that the checkpoint matches these grids before changing anything
+    std::vector<double> boundaries;
+    checkpoint.read(name + "_boundaries", boundaries);
+    std::size_t boundaryLength = 0;
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags)
+        boundaryLength += 2*boundaryConditions.get(boundaryFlag).extent(0);
+    boost::shared_ptr<Arena> restored = checkpoint.map(name);
+    if (restored->size() != arena->size() 
+        || boundaries.size() != boundaryLength)
+        throw CheckpointException("the " + name 
+            + " section doesn't match the grids");
+    
+    // Point the levels into the restored arena, laid out as before
+    std::size_t offset = 0;
+    for (Level level=coarsestLevel; level<=finestLevel; level++) {
+        FDArray& u = (*this)[level];
+        const int nx = u.rows(), nz = u.columns();
+        u.resize_in(restored->data() + offset, Arena::padded_columns(nz), 
+            aspect, nx, nz);
+        offset += std::size_t(nx)*Arena::padded_columns(nz);
+    }
+    arena = restored;
+    
+    // Copy the boundary conditions in, and make the levels' boundary 
+    // conditions references to them again (resize_in gave each level its 
+    // own)
+    std::size_t k = 0;
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags) {
+        Boundary& boundary = boundaryConditions.get(boundaryFlag);
+        for (int n=0; n<boundary.extent(0); n++, k+=2) {
+            boundary(n).conditionType = ConditionType(int(boundaries[k]));
+            boundary(n).value = boundaries[k+1];
+        }
+    }
+    foreach(BoundaryFlag boundaryFlag, allBoundaryFlags)
+        _update_boundary_conditions(boundaryFlag);
+}
+
+void mgrid::Stack::_first_touch(Level level) {
+    // Zero the level (padding included) a row at a time, with the rows shared
+    // out between threads as in a static OpenMP loop over the grid, so that 
+    // each page is first touched by the thread which will work on it
+    FDArray& u = (*this)[level];
+    const int nx = u.rows();
+    const int rowLength = Arena::padded_columns(u.columns());
+    double* first = &u(0, 0);
+    #pragma omp parallel for schedule(static)
+    for (int i=0; i<nx; i++) 
+        std::fill(first + i*rowLength, first + (i + 1)*rowLength, 0.0);
+}
+
 void mgrid::Stack::_update_boundary_conditions(BoundaryFlag boundaryFlag) {
     // Updates boundary conditions on given boundary at all levels
     // Get length of finest boundary condition    
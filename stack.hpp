@@ -10,18 +10,24 @@
 
 #include <vector> 
 #include <boost/tuple/tuple.hpp>  
+#include <boost/shared_ptr.hpp>
 
 #include "types.hpp" 
 #include "multigrid_exceptions.hpp"
 #include "utilities.hpp"                   
 #include "fdarray.hpp"   
+#include "kernels.hpp"
+#include "arena.hpp"
+#include "checkpoint.hpp"
+#include "profiler.hpp"
 #include "settings.hpp"
 #include "boundary_conditions.hpp"  
 
 namespace mgrid {
 
 // = Transfer operators =
-/*  Interpolation and restriction operators which operate on FDArray instances:
+/*  Interpolation and restriction operators which operate on FDViews (so 
+    FDArrays can be passed directly):
     -- restrictor applies a restriction operator which transfers the 
        data on the current level (as specified by the private variable 
        level) to the next coarsest level using fully weighted 
@@ -31,35 +37,46 @@ namespace mgrid {
        the data on the current level in the grid stack to the next finest 
        level using bilinear interpolation. It updates the data on the next 
        finest grid in the stack and the value of currentLevel.
+    The coarse and fine arrays must not overlap. If tile is nonzero, both 
+    work through strips of tile coarse columns (and the fine columns on top
+    of them) in turn, so that the rows they use stay in cache on very wide 
+    grids. This doesn't change the results. The interiors are done a row at
+    a time by the kernels in kernels.hpp.
 */
-inline void restriction_operator(FDArray coarse, FDArray fine) {  
-    int nxc, nzc, nxf, nzf;   
-    boost::tie(nxc, nzc) = to_tuple(coarse.shape());
-    boost::tie(nxf, nzf) = to_tuple(fine.shape());   
+inline void restriction_operator(FDView coarse, FDView fine, 
+    const int tile=0) 
+{  
+    const int nxc = coarse.rows(), nzc = coarse.columns();
+    const int nxf = fine.rows(), nzf = fine.columns();
+    const int strip = (tile > 0) ? tile : nzc;
+    const KernelTable& k = kernels();
     
     // Perform restriction over center of grid  
-    blitz::Range fi(2, nxf-3, 2); 
-    blitz::Range fj(2, nzf-3, 2); 
-    blitz::Range ci(1, nxc-2); 
-    blitz::Range cj(1, nzc-2);
-    coarse(ci, cj) = (4*(fine(fi, fj))
-        + 2*(fine(fi+1,fj) + fine(fi-1,fj)+ fine(fi,fj+1) + fine(fi,fj-1))
-        + 1*(fine(fi+1,fj+1) + fine(fi+1,fj-1) + fine(fi-1,fj+1) 
-            + fine(fi-1,fj-1)))/16.0; 
+    for (int cj0=1; cj0<nzc-1; cj0+=strip) {
+        const int cj1 = std::min(cj0 + strip, nzc-1);
+        for (int ci=1, fi=2; ci<nxc-1; ci++, fi+=2)
+            k.restrict_row(&fine(fi-1, 2*cj0), &fine(fi, 2*cj0),
+                &fine(fi+1, 2*cj0), fine.stride(1), &coarse(ci, cj0),
+                coarse.stride(1), cj1 - cj0);
+    }
     
     // Perform restriction at boundaries
-    coarse(ci, 0) = (4*fine(fi, 0)
-        + 2*(fine(fi-1, 0) + fine(fi+1, 0) + fine(fi, 1))
-        + 1*(fine(fi-1, 1) + fine(fi+1, 1)))/12.0;
-    coarse(ci, nzc-1) = (4*fine(fi, nzf-1)
-        + 2*(fine(fi-1, nzf-1) + fine(fi+1, nzf-1) + fine(fi, nzf-2)) 
-        + 1*(fine(fi-1, nzf-2) + fine(fi+1, nzf-2)))/12.0;
-    coarse(0, cj) = (4*fine(0, fj)
-        + 2*(fine(0, fj-1) + fine(0, fj+1) + fine(1, fj))
-        + 1*(fine(1, fj-1) + fine(1, fj+1)))/12.0;
-    coarse(nxc-1, cj) = (4*fine(nxf-1, fj)
-        + 2*(fine(nxf-1, fj-1) + fine(nxf-1, fj+1) + fine(nxf-2, fj))
-        + 1*(fine(nxf-2, fj-1) + fine(nxf-2, fj+1)))/12.0; 
+    for (int ci=1, fi=2; ci<nxc-1; ci++, fi+=2) {
+        coarse(ci, 0) = (4*fine(fi, 0)
+            + 2*(fine(fi-1, 0) + fine(fi+1, 0) + fine(fi, 1))
+            + 1*(fine(fi-1, 1) + fine(fi+1, 1)))/12.0;
+        coarse(ci, nzc-1) = (4*fine(fi, nzf-1)
+            + 2*(fine(fi-1, nzf-1) + fine(fi+1, nzf-1) + fine(fi, nzf-2)) 
+            + 1*(fine(fi-1, nzf-2) + fine(fi+1, nzf-2)))/12.0;
+    }
+    for (int cj=1, fj=2; cj<nzc-1; cj++, fj+=2) {
+        coarse(0, cj) = (4*fine(0, fj)
+            + 2*(fine(0, fj-1) + fine(0, fj+1) + fine(1, fj))
+            + 1*(fine(1, fj-1) + fine(1, fj+1)))/12.0;
+        coarse(nxc-1, cj) = (4*fine(nxf-1, fj)
+            + 2*(fine(nxf-1, fj-1) + fine(nxf-1, fj+1) + fine(nxf-2, fj))
+            + 1*(fine(nxf-2, fj-1) + fine(nxf-2, fj+1)))/12.0; 
+    }
     
     // Perform restriction at corners
     coarse(0,0) = (4*fine(0,0) + 2*(fine(1,0) + fine(0,1)) + 1*fine(1,1))/9.0;
@@ -70,34 +87,62 @@ inline void restriction_operator(FDArray coarse, FDArray fine) {
     coarse(nxc-1,nzc-1) = (4*fine(nxf-1,nzf-1) + 2*(fine(nxf-2,nzf-1) 
         + fine(nxf-1,nzf-2)) + 1*fine(nxf-2,nzf-2))/9.0;
 }
-inline void interpolation_operator(FDArray coarse, FDArray fine) {
-    int nxc, nzc, nxf, nzf;   
-    boost::tie(nxc, nzc) = to_tuple(coarse.shape());
-    boost::tie(nxf, nzf) = to_tuple(fine.shape());  
-    blitz::Range i(0, nxf-1, 2);
-    blitz::Range j(0, nzf-1, 2); 
-    blitz::Range m(1, nxf-2, 2);
-    blitz::Range n(1, nzf-2, 2);
-            
-    // Copy over data directly 
-    for (int ii=0; ii<nxc; ii++) 
-        for (int jj=0; jj<nzc; jj++)
-            fine(2*ii, 2*jj) = coarse(ii, jj);
+inline void interpolation_operator(FDView coarse, FDView fine, 
+    const int tile=0) 
+{
+    const int nxf = fine.rows(), nzf = fine.columns();
+    const int strip = (tile > 0) ? 2*tile : nzf;
+    const KernelTable& k = kernels();
     
-    // Interpolation over center of grid
-    fine(i, n) = 0.5*(fine(i, n-1) + fine(i, n+1));
-    fine(m, j) = 0.5*(fine(m-1, j) + fine(m+1, j));
-    fine(m, n) = 0.25*(fine(m+1, n+1) + fine(m+1, n-1) + fine(m-1, n+1) 
-        + fine(m-1, n-1));     
-        
-    // Interpolation at boundaries of grid  
-    fine(0,n) = 0.5*(fine(0, n-1) + fine(0, n+1));
-    fine(nxf-1,n) = 0.5*(fine(nxf-1, n-1) + fine(nxf-1, n+1));
-    fine(m, 0) = 0.5*(fine(m-1, 0) + fine(m+1, 0));
-    fine(m, nzf-1) = 0.5*(fine(m-1, nzf-1) + fine(m+1, nzf-1));   
+    // Every fine point is worked out straight from the coarse points around 
+    // it, in one pass: fine points on top of coarse points are copied over, 
+    // points between two coarse points along a row or column get the 
+    // average of the two, and points in the middle of a coarse cell get the 
+    // average of its four corners. 
+    for (int j0=0; j0<nzf; j0+=strip) {
+        const int j1 = std::min(j0 + strip, nzf);
+        for (int i=0; i<nxf; i++) {
+            const int I = i/2;
+            if (i%2 == 0)
+                k.interpolate_on_row(&coarse(I, 0), coarse.stride(1),
+                    &fine(i, 0), fine.stride(1), j0, j1, nzf);
+            else
+                k.interpolate_between_rows(&coarse(I, 0), &coarse(I+1, 0),
+                    coarse.stride(1), &fine(i, 0), fine.stride(1), j0, j1,
+                    nzf);
+        }
+    }
 }
+
+// = Resampling =
+/*  Copies a grid onto another of a different size covering the same 
+    domain. If one grid is a multigrid coarsening of the other (the number 
+    of intervals doubling the same number of times in both directions), the
+    interpolation or restriction operator above is applied a level at a 
+    time, as a Stack would. Otherwise values are interpolated bilinearly.
+*/
+void resample(FDView from, FDView to);
+    
+// = Grid geometry =
+/*  Grid shapes for a set of Settings, without having to build a Stack:
+    -- grid_shape gives (nx, nz) on the given level.
+    -- stack_memory gives the number of bytes used by the data in a Stack,
+       including the padding at the end of each row.
+*/
+boost::tuple<int, int> grid_shape(const Settings& s, Level level);
+std::size_t stack_memory(const Settings& s);
     
 // = Stack class interface =
+/*  All the levels share a single Arena, coarsest level first, with each row
+    padded out to an aligned boundary. Levels (and any references to them)
+    must not outlive the Stack they came from.
+
+    checkpoint adds the arena (padding and all) to a checkpoint as the
+    section name, and the boundary conditions as name_boundaries. restore
+    maps the arena straight back from the checkpoint file in place of the
+    current one, so references to levels taken before restoring still point
+    at the old data.
+*/
 class Stack: public std::vector<mgrid::FDArray> {
 public:
     Stack(const Settings& s);  
@@ -106,9 +151,14 @@ public:
     // Some useful attributes
     const Level finestLevel;              // level of finest grid  
     static const Level coarsestLevel = 0; // level of coarsest grid      
+    const int tileSize;                   // for transfers (0 for untiled)
 
     // Methods
     void write(std::string fileString); 
+    inline void set_profiler(Profiler* newProfiler);
+    void checkpoint(CheckpointWriter& checkpoint, const std::string& name);
+    void restore(CheckpointReader& checkpoint, const std::string& name);
+    inline std::size_t memory();     // bytes used, including row padding
     inline void coarsen(Level level);
     inline void coarsen(Level level, FDArray& result);
     inline void refine(Level level);
@@ -126,20 +176,47 @@ private:
     const double aspect;          // aspect ratio of grid domain  
     const int nGrids;             // number of grid levels required
     int minRes;                   // minimum resolution parameter        
+    
+    // Storage for all levels
+    boost::shared_ptr<Arena> arena;
+    void _first_touch(Level level);
+    
+    // Transfers are counted on the finer of the two levels (if there's a 
+    // profiler), as the points written and the data read and written
+    Profiler* profiler;
+    inline double _transfer_bytes(Level level);
 };                   
 
 // = Inline methods for Stack class =     
+inline std::size_t Stack::memory() {
+    return arena->size()*sizeof(double);
+}
+inline void Stack::set_profiler(Profiler* newProfiler) {
+    profiler = newProfiler;
+}
 inline void Stack::coarsen(Level level) {
-    restriction_operator((*this)[level - 1], (*this)[level]);
+    PROFILE_SCOPE(profile, profiler, restrictPhase, level);
+    PROFILE_WORK(profile, (*this)[level - 1].size(), _transfer_bytes(level));
+    restriction_operator((*this)[level - 1], (*this)[level], tileSize);
 }
 inline void Stack::coarsen(Level level, FDArray& result) {
-    restriction_operator(result, (*this)[level]);
+    PROFILE_SCOPE(profile, profiler, restrictPhase, level);
+    PROFILE_WORK(profile, result.size(), _transfer_bytes(level));
+    restriction_operator(result, (*this)[level], tileSize);
 }
 inline void Stack::refine(Level level) {
-    interpolation_operator((*this)[level], (*this)[level + 1]);
+    PROFILE_SCOPE(profile, profiler, prolongPhase, level + 1);
+    PROFILE_WORK(profile, (*this)[level + 1].size(), 
+        _transfer_bytes(level + 1));
+    interpolation_operator((*this)[level], (*this)[level + 1], tileSize);
 }        
 inline void Stack::refine(Level level, FDArray& result) {
-    interpolation_operator((*this)[level], result);
+    PROFILE_SCOPE(profile, profiler, prolongPhase, level + 1);
+    PROFILE_WORK(profile, result.size(), _transfer_bytes(level + 1));
+    interpolation_operator((*this)[level], result, tileSize);
+}
+inline double Stack::_transfer_bytes(Level level) {
+    return ((*this)[level].size() + (*this)[level - 1].size())*sizeof(double);
 }
        
 } // end namespace multigrid        
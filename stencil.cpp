@@ -0,0 +1,92 @@
+/*
+    stencil.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Implementation of StencilStack class
+*/
+
+#include <cstdlib>
+
+#include "stencil.hpp"
+
+// Weight given to a fine point at the given offset from a coarse point by
+// bilinear interpolation (in one direction)
+static inline double interpolation_weight(const int offset) {
+    if (offset == 0) return 1.0;
+    else if (offset == 1 || offset == -1) return 0.5;
+    else return 0.0;
+}
+
+// Allocate storage
+void mgrid::StencilStack::resize(const Stack& stack) {
+    std::vector<StencilArray>::resize(stack.size());
+    for (Level level=stack.coarsestLevel; level<=stack.finestLevel; level++) {
+        (*this)[level].resize(stack[level].rows(), stack[level].columns(),
+            stencilSize);
+        (*this)[level] = 0;
+    }
+}
+
+// Galerkin coarsening
+void mgrid::StencilStack::galerkin_coarsen(Level level) {
+    const StencilArray& fine = (*this)[level];
+    StencilArray& coarse = (*this)[level-1];
+    const int nxc = coarse.extent(0), nzc = coarse.extent(1);
+    coarse = 0;
+
+    // Loop over interior coarse points. The coarse coefficient coupling (I, J)
+    // to (I+DI, J+DJ) is the sum over fine points f in the restriction
+    // stencil of (I, J), and fine neighbours g of f, of
+    //      R(f) * A(f, g) * P(g, (I+DI, J+DJ))
+    for (int I=1; I<nxc-1; I++) {
+        for (int J=1; J<nzc-1; J++) {
+            for (int a=-1; a<=1; a++) for (int b=-1; b<=1; b++) {
+                const int fi = 2*I + a, fj = 2*J + b;
+                const double restrictWeight = (2 - abs(a))*(2 - abs(b))/16.0;
+                for (int c=-1; c<=1; c++) for (int d=-1; d<=1; d++) {
+                    const double coeff = restrictWeight
+                        *fine(fi, fj, stencil_index(c, d));
+                    if (coeff == 0) continue;
+                    for (int DI=-1; DI<=1; DI++) for (int DJ=-1; DJ<=1; DJ++)
+                        coarse(I, J, stencil_index(DI, DJ)) += coeff
+                            *interpolation_weight(a + c - 2*DI)
+                            *interpolation_weight(b + d - 2*DJ);
+                }
+            }
+        }
+    }
+}
+
+// Residual evaluation: zero on the boundaries, where the residual is taken
+// care of by the boundary conditions
+void mgrid::StencilStack::evaluate_residual(Level level, FDArray& u,
+    FDArray& f, FDArray& result)
+{
+    const int nx = result.rows(), nz = result.columns();
+    result(0, blitz::Range::all()) = 0;
+    result(nx-1, blitz::Range::all()) = 0;
+    result(blitz::Range::all(), 0) = 0;
+    result(blitz::Range::all(), nz-1) = 0;
+    const StencilArray& a = (*this)[level];
+    const KernelTable& k = kernels();
+    for (int i=1; i < nx-1; i++)
+        k.stencil_residual_row(&a(i, 1, 0), a.stride(1), &u(i-1, 1),
+            &u(i, 1), &u(i+1, 1), u.stride(1), &f(i, 1), f.stride(1),
+            &result(i, 1), result.stride(1), nz-2);
+}
+
+// Red-black relaxation, a column of each colour at a time in the same order
+// as RED_BLACK_LOOP (red points, with i + j even, first)
+void mgrid::StencilStack::relax(Level level, FDArray& u, FDArray& f) {
+    const int nx = u.rows(), nz = u.columns();
+    const StencilArray& a = (*this)[level];
+    const KernelTable& k = kernels();
+    for (int colour=0; colour<2; colour++) {
+        for (int j=1; j < nz-1; j++) {
+            const int i0 = 1 + ((j + 1 + colour) & 1);
+            k.stencil_relax_column(&a(i0, j, 0), a.stride(0), &u(i0, j),
+                u.stride(0), u.stride(1), &f(i0, j), f.stride(0),
+                (nx - i0)/2);
+        }
+    }
+}
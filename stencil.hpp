@@ -0,0 +1,92 @@
+/*
+    stencil.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Nine-point stencil coefficients stored per grid level, used for
+    Galerkin (R.A.P) coarse grid operators.
+*/
+
+#ifndef STENCIL_HPP_Q3M8XK2D
+#define STENCIL_HPP_Q3M8XK2D
+
+#include <vector>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "utilities.hpp"
+#include "fdarray.hpp"
+#include "stack.hpp"
+
+namespace mgrid {
+
+// Stencil coefficients are stored with the coefficient index running fastest,
+// so that each point's nine coefficients are contiguous in memory. The
+// coefficient for the point at offset (di, dj) from the centre is stored at
+// index stencil_index(di, dj).
+typedef blitz::Array<double, 3> StencilArray;
+const int stencilSize = 9;
+const int stencilCentre = 4;
+inline int stencil_index(const int di, const int dj) {
+    return 3*(di + 1) + (dj + 1);
+}
+
+// = StencilStack class interface =
+/*  A stack of nine-point stencils, arranged from coarse to fine like Stack.
+    -- galerkin_coarsen builds the operator on the next coarsest level as
+       R.A.P, where R is the fully weighted restriction and P the bilinear
+       interpolation used by restriction_operator and interpolation_operator.
+       Only interior points carry a stencil - boundary values are set by
+       FDArray::update_boundaries rather than by relaxation.
+    -- relax does one red-black sweep of a level, with the same updates in
+       the same order as relaxation_updater in a RED_BLACK_LOOP. It and
+       evaluate_residual use the kernels in kernels.hpp.
+*/
+class StencilStack: public std::vector<StencilArray> {
+public:
+    StencilStack() {};
+    virtual ~StencilStack() {};
+
+    // Allocate coefficient arrays with the same level shapes as a Stack
+    void resize(const Stack& stack);
+
+    // Galerkin coarsening from the given level to the next coarsest
+    void galerkin_coarsen(Level level);
+
+    // Stencil kernels
+    inline double apply(Level level, FDArray& u, const int i, const int j);
+    inline double apply(const StencilArray& a, const FDView& u, const int i,
+        const int j);
+    inline void relaxation_updater(Level level, FDArray& u, FDArray& f,
+        const int i, const int j);
+    void evaluate_residual(Level level, FDArray& u, FDArray& f,
+        FDArray& result);
+    void relax(Level level, FDArray& u, FDArray& f);
+};
+
+// = Inline methods for StencilStack class =
+inline double StencilStack::apply(Level level, FDArray& u,
+    const int i, const int j)
+{
+    const StencilArray& a = (*this)[level];
+    return a(i, j, 0)*u(i-1, j-1) + a(i, j, 1)*u(i-1, j) + a(i, j, 2)*u(i-1, j+1)
+        + a(i, j, 3)*u(i, j-1) + a(i, j, 4)*u(i, j) + a(i, j, 5)*u(i, j+1)
+        + a(i, j, 6)*u(i+1, j-1) + a(i, j, 7)*u(i+1, j) + a(i, j, 8)*u(i+1, j+1);
+}
+inline double StencilStack::apply(const StencilArray& a, const FDView& u,
+    const int i, const int j)
+{
+    return a(i, j, 0)*u(i-1, j-1) + a(i, j, 1)*u(i-1, j) + a(i, j, 2)*u(i-1, j+1)
+        + a(i, j, 3)*u(i, j-1) + a(i, j, 4)*u(i, j) + a(i, j, 5)*u(i, j+1)
+        + a(i, j, 6)*u(i+1, j-1) + a(i, j, 7)*u(i+1, j) + a(i, j, 8)*u(i+1, j+1);
+}
+inline void StencilStack::relaxation_updater(Level level, FDArray& u,
+    FDArray& f, const int i, const int j)
+{
+    // Gauss-Seidel update: solve the stencil equation for the centre point
+    const double centre = (*this)[level](i, j, stencilCentre);
+    u(i, j) += (f(i, j) - apply(level, u, i, j))/centre;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: STENCIL_HPP_Q3M8XK2D */
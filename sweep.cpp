@@ -0,0 +1,174 @@
+/*
+    sweep.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Implementation of parameter sweep scheduler
+*/
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include "sweep.hpp"
+
+// Order jobs by decreasing cost
+static bool more_costly(const mgrid::SweepJob& a, const mgrid::SweepJob& b) {
+    return a.cost > b.cost;
+}
+
+// Ctor
+mgrid::SweepScheduler::SweepScheduler(Factory factory, OutputStage output,
+    int nThreads, std::size_t memoryLimit):
+    factory(factory),
+    output(output),
+    nThreads(nThreads > 0 ? nThreads
+        : std::max(1, int(boost::thread::hardware_concurrency()))),
+    memoryLimit(memoryLimit),
+    memoryInUse(0),
+    peakMemory(0),
+    workersRunning(0) { /* pass */ }
+
+// Job setup
+void mgrid::SweepScheduler::add_job(const SweepParameters& parameters,
+    const double cost, const std::size_t memory)
+{
+    SweepJob job;
+    job.parameters = parameters;
+    job.cost = cost;
+    job.memory = memory;
+    jobs.push_back(job);
+}
+
+// Main loop
+void mgrid::SweepScheduler::run() {
+    // Deal the jobs out to the workers, largest first
+    std::stable_sort(jobs.begin(), jobs.end(), more_costly);
+    queues.assign(nThreads, std::deque<SweepJob>());
+    queueLocks.clear();
+    for (int worker=0; worker<nThreads; worker++)
+        queueLocks.push_back(
+            boost::shared_ptr<boost::mutex>(new boost::mutex()));
+    for (std::size_t n=0; n<jobs.size(); n++)
+        queues[n % nThreads].push_back(jobs[n]);
+    jobs.clear();
+
+    // Start the output thread and the workers, then wait for them to finish
+    workersRunning = nThreads;
+    boost::thread writer(boost::bind(&SweepScheduler::_writer, this));
+    boost::thread_group workers;
+    for (int worker=0; worker<nThreads; worker++)
+        workers.create_thread(
+            boost::bind(&SweepScheduler::_worker, this, worker));
+    workers.join_all();
+    writer.join();
+}
+
+// Worker threads: run jobs until there are none left anywhere
+void mgrid::SweepScheduler::_worker(const int worker) {
+    SweepJob job;
+    while (_next_job(worker, job)) {
+        _acquire_memory(job.memory);
+        try {
+            SolverPtr solver(factory(job.parameters));
+            solver->solve();
+            boost::mutex::scoped_lock lock(outputLock);
+            finished.push_back(FinishedJob(solver, job));
+            outputReady.notify_one();
+        } catch (std::exception& e) {
+            Message msg(ErrorMessage);
+            msg << "Sweep job failed: " << e.what() << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+            _release_memory(job.memory);
+        } catch (...) {
+            // Anything else would skip the count below and leave the output
+            // thread waiting for this worker forever
+            Message msg(ErrorMessage);
+            msg << "Sweep job failed" << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+            _release_memory(job.memory);
+        }
+    }
+
+    // Let the output thread know when the last worker has finished
+    boost::mutex::scoped_lock lock(outputLock);
+    workersRunning--;
+    outputReady.notify_one();
+}
+bool mgrid::SweepScheduler::_next_job(const int worker, SweepJob& job) {
+    // Take the next job from our own queue if there is one
+    {
+        boost::mutex::scoped_lock lock(*queueLocks[worker]);
+        if (not(queues[worker].empty())) {
+            job = queues[worker].front();
+            queues[worker].pop_front();
+            return true;
+        }
+    }
+
+    // Otherwise steal the most costly job at the front of any other queue.
+    // Jobs are never added once running, so once every queue is empty we
+    // are done.
+    while (true) {
+        int victim = -1;
+        double largestCost = 0;
+        for (int other=0; other<nThreads; other++) {
+            boost::mutex::scoped_lock lock(*queueLocks[other]);
+            if (not(queues[other].empty())
+                && (victim < 0 || queues[other].front().cost > largestCost)) {
+                victim = other;
+                largestCost = queues[other].front().cost;
+            }
+        }
+        if (victim < 0) return false;
+
+        boost::mutex::scoped_lock lock(*queueLocks[victim]);
+        if (not(queues[victim].empty())) {
+            job = queues[victim].front();
+            queues[victim].pop_front();
+            return true;
+        }
+    }
+}
+
+// Output thread: writes each finished solver, then frees it
+void mgrid::SweepScheduler::_writer() {
+    while (true) {
+        FinishedJob next;
+        {
+            boost::mutex::scoped_lock lock(outputLock);
+            while (finished.empty() && workersRunning > 0)
+                outputReady.wait(lock);
+            if (finished.empty()) return;
+            next = finished.front();
+            finished.pop_front();
+        }
+        try {
+            output(*next.first, next.second.parameters);
+        } catch (std::exception& e) {
+            Message msg(ErrorMessage);
+            msg << "Sweep output failed: " << e.what() << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+        } catch (...) {
+            Message msg(ErrorMessage);
+            msg << "Sweep output failed" << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+        }
+        next.first.reset();
+        _release_memory(next.second.memory);
+    }
+}
+
+// Memory budget. A job that is larger than the limit on its own is allowed
+// to run once nothing else is using memory.
+void mgrid::SweepScheduler::_acquire_memory(const std::size_t memory) {
+    boost::mutex::scoped_lock lock(memoryLock);
+    if (memoryLimit > 0)
+        while (memoryInUse > 0 && memoryInUse + memory > memoryLimit)
+            memoryReleased.wait(lock);
+    memoryInUse += memory;
+    peakMemory = std::max(peakMemory, memoryInUse);
+}
+void mgrid::SweepScheduler::_release_memory(const std::size_t memory) {
+    boost::mutex::scoped_lock lock(memoryLock);
+    memoryInUse -= memory;
+    memoryReleased.notify_all();
+}
@@ -0,0 +1,106 @@
+/*
+    sweep.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Parameter sweep scheduler: runs many solvers concurrently on a pool of
+    worker threads, and passes each solver on to an output stage as soon as
+    it has finished.
+*/
+
+#ifndef SWEEP_HPP_R5XW1M7G
+#define SWEEP_HPP_R5XW1M7G
+
+#include <deque>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "utilities.hpp"
+#include "multigrid_base.hpp"
+
+namespace mgrid {
+
+// Parameters for a single job in a sweep, e.g. (aspect ratio, Bingham number)
+typedef std::vector<double> SweepParameters;
+
+struct SweepJob {
+    SweepParameters parameters;
+    double cost;            // Estimated cost, used to run the largest first
+    std::size_t memory;     // Estimated memory used by the solver in bytes
+};
+
+// = SweepScheduler class interface =
+/*  Jobs are sorted by decreasing cost and dealt out to a queue per worker.
+    Each worker runs the jobs on its own queue, largest first, and when that
+    runs dry it steals the largest job at the front of another worker's
+    queue. A job only starts once its estimated memory fits under the memory
+    limit, counting every solver which is running or waiting for output.
+
+    Finished solvers are handed to a single output thread, which calls the
+    output stage for each in turn, so the output stage doesn't need to be
+    thread safe. A solver's memory is released once it has been written.
+*/
+class SweepScheduler {
+public:
+    // Builds a solver for the given parameters
+    typedef boost::function<MultigridBase* (const SweepParameters&)> Factory;
+
+    // Receives each solved problem
+    typedef boost::function<void (MultigridBase&, const SweepParameters&)>
+        OutputStage;
+
+    // A thread count of zero uses all the hardware threads, and a memory
+    // limit of zero means the memory used is not limited
+    SweepScheduler(Factory factory, OutputStage output, int nThreads=0,
+        std::size_t memoryLimit=0);
+    virtual ~SweepScheduler() {};
+
+    // Add jobs, then run them all - run blocks until every job is written
+    void add_job(const SweepParameters& parameters, const double cost,
+        const std::size_t memory);
+    void run();
+
+    // Accessors
+    inline int number_of_threads() { return nThreads; }
+    inline std::size_t peak_memory() { return peakMemory; }
+
+private:
+    typedef boost::shared_ptr<MultigridBase> SolverPtr;
+    typedef std::pair<SolverPtr, SweepJob> FinishedJob;
+
+    // Setup
+    Factory factory;
+    OutputStage output;
+    const int nThreads;
+    const std::size_t memoryLimit;
+    std::vector<SweepJob> jobs;
+
+    // Per-worker job queues, each with its own lock
+    std::vector<std::deque<SweepJob> > queues;
+    std::vector<boost::shared_ptr<boost::mutex> > queueLocks;
+
+    // Memory budget
+    boost::mutex memoryLock;
+    boost::condition_variable memoryReleased;
+    std::size_t memoryInUse, peakMemory;
+
+    // Output queue
+    boost::mutex outputLock;
+    boost::condition_variable outputReady;
+    std::deque<FinishedJob> finished;
+    int workersRunning;
+
+    // Thread bodies and helpers
+    void _worker(const int worker);
+    void _writer();
+    bool _next_job(const int worker, SweepJob& job);
+    void _acquire_memory(const std::size_t memory);
+    void _release_memory(const std::size_t memory);
+};
+
+} // end namespace mgrid
+
+#endif /* end of include guard: SWEEP_HPP_R5XW1M7G */
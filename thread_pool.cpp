@@ -0,0 +1,72 @@
+/*
+    thread_pool.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include "thread_pool.hpp"
+
+mgrid::ThreadPool::ThreadPool(const int nThreads):
+    nThreads(std::max(1, nThreads)),
+    unfinished(0),
+    stopping(false),
+    failed(false)
+{
+    for (int thread=0; thread<this->nThreads; thread++)
+        threads.create_thread(boost::bind(&ThreadPool::_worker, this));
+}
+mgrid::ThreadPool::~ThreadPool() {
+    {
+        boost::mutex::scoped_lock guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    threads.join_all();
+}
+
+// Hand out a batch, and wait for it to finish
+void mgrid::ThreadPool::run(const std::vector<Task>& batch) {
+    boost::mutex::scoped_lock running(runLock);
+    boost::mutex::scoped_lock guard(lock);
+    tasks.insert(tasks.end(), batch.begin(), batch.end());
+    unfinished = batch.size();
+    failed = false;
+    changed.notify_all();
+    while (unfinished > 0) changed.wait(guard);
+    if (failed) throw ThreadPoolException("a task failed");
+}
+
+// Worker threads: run tasks until we're told to stop
+void mgrid::ThreadPool::_worker() {
+    for (;;) {
+        Task task;
+        {
+            boost::mutex::scoped_lock guard(lock);
+            while (tasks.empty() && not(stopping)) changed.wait(guard);
+            if (tasks.empty()) return;
+            task = tasks.front();
+            tasks.pop_front();
+        }
+        bool succeeded = false;
+        try {
+            task();
+            succeeded = true;
+        } catch (std::exception& e) {
+            Message msg(ErrorMessage);
+            msg << "Thread pool task failed: " << e.what() << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+        } catch (...) {
+            Message msg(ErrorMessage);
+            msg << "Thread pool task failed" << std::endl;
+            std::cout << msg.str(); std::cout.flush();
+        }
+        {
+            boost::mutex::scoped_lock guard(lock);
+            if (not(succeeded)) failed = true;
+            unfinished--;
+        }
+        changed.notify_all();
+    }
+}
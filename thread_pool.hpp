@@ -0,0 +1,59 @@
+/*
+    thread_pool.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Fixed set of threads which run batches of tasks, so that code which
+    runs a few short tasks at once, many times over, only starts its
+    threads once.
+*/
+
+#ifndef THREAD_POOL_HPP_R5KD2W8Q
+#define THREAD_POOL_HPP_R5KD2W8Q
+
+#include <deque>
+#include <vector>
+#include <boost/utility.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "multigrid_exceptions.hpp"
+
+namespace mgrid {
+
+// = ThreadPool class interface =
+/*  run hands a batch of tasks out to the threads and waits until every one
+    has finished. Only one batch runs at a time. A task that throws is
+    reported, the rest of the batch still runs, and run then throws a
+    ThreadPoolException. The destructor stops the threads.
+*/
+class ThreadPool: private boost::noncopyable {
+public:
+    typedef boost::function<void ()> Task;
+
+    ThreadPool(const int nThreads);
+    ~ThreadPool();
+
+    // Run a batch of tasks, and wait for them all
+    void run(const std::vector<Task>& batch);
+    inline int size();
+
+private:
+    void _worker();
+
+    const int nThreads;
+    std::deque<Task> tasks;
+    int unfinished;                 // Tasks of the batch still to finish
+    bool stopping, failed;
+    boost::mutex lock, runLock;
+    boost::condition_variable changed;
+    boost::thread_group threads;
+};
+
+// = Inline methods =
+inline int ThreadPool::size() {
+    return nThreads;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: THREAD_POOL_HPP_R5KD2W8Q */
@@ -0,0 +1,88 @@
+/*
+    tracer.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <set>
+#include <boost/thread/tss.hpp>
+
+#include "profiler.hpp"
+#include "tracer.hpp"
+
+// Small thread numbers, handed out as threads first add events. Numbers
+// are given back when threads finish, so short-lived worker threads (as in
+// the additive cycle) reuse a few numbers rather than getting a new one each.
+static boost::mutex threadNumberLock;
+static std::set<int> freeThreadNumbers;
+static int nextThreadNumber = 0;
+
+static void release_thread_number(int* number) {
+    boost::mutex::scoped_lock lock(threadNumberLock);
+    freeThreadNumbers.insert(*number);
+    delete number;
+}
+static boost::thread_specific_ptr<int> threadNumber(release_thread_number);
+
+static int this_thread_number() {
+    if (not(threadNumber.get())) {
+        boost::mutex::scoped_lock lock(threadNumberLock);
+        if (freeThreadNumbers.empty()) {
+            threadNumber.reset(new int(nextThreadNumber++));
+        } else {
+            threadNumber.reset(new int(*freeThreadNumbers.begin()));
+            freeThreadNumbers.erase(freeThreadNumbers.begin());
+        }
+    }
+    return *threadNumber;
+}
+
+mgrid::Tracer::Tracer(const std::size_t maxEvents):
+    maxEvents(maxEvents),
+    origin(Profiler::now()),
+    droppedEvents(0)
+{}
+
+void mgrid::Tracer::add(const char* name, const char* category,
+    const double begin, const double end, const Level level, const int cycle)
+{
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.begin = begin;
+    event.end = end;
+    event.thread = this_thread_number();
+    event.level = level;
+    event.cycle = cycle;
+    boost::mutex::scoped_lock lock(this->lock);
+    if (events.size() < maxEvents) events.push_back(event);
+    else droppedEvents++;
+}
+void mgrid::Tracer::clear() {
+    boost::mutex::scoped_lock lock(this->lock);
+    events.clear();
+    droppedEvents = 0;
+}
+
+void mgrid::Tracer::write_json(std::ostream& out) {
+    boost::mutex::scoped_lock lock(this->lock);
+    const std::streamsize precision = out.precision(3);
+    const std::ios_base::fmtflags flags = out.setf(std::ios_base::fixed,
+        std::ios_base::floatfield);
+    out << "{\"displayTimeUnit\": \"ms\", \"droppedEvents\": "
+        << droppedEvents << ", \"traceEvents\": [";
+    for (std::size_t n=0; n<events.size(); n++) {
+        const TraceEvent& e = events[n];
+        out << (n > 0 ? ",\n" : "\n") << "{\"name\": \"" << e.name
+            << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", "
+            << "\"ts\": " << 1e6*(e.begin - origin)
+            << ", \"dur\": " << 1e6*(e.end - e.begin)
+            << ", \"pid\": 1, \"tid\": " << e.thread << ", \"args\": {";
+        if (e.level >= 0) out << "\"level\": " << e.level;
+        if (e.cycle >= 0)
+            out << (e.level >= 0 ? ", " : "") << "\"cycle\": " << e.cycle;
+        out << "}}";
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,76 @@
+/*
+    tracer.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Timeline of a solve (cycles, level visits and kernels on each thread),
+    written in the Chrome trace event format for viewing in Perfetto or
+    chrome://tracing. Events are added by the profiler (see profiler.hpp).
+*/
+
+#ifndef TRACER_HPP_D8LW3F6T
+#define TRACER_HPP_D8LW3F6T
+
+#include <vector>
+#include <iostream>
+#include <boost/utility.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "types.hpp"
+
+namespace mgrid {
+
+// One span of time on one thread. Names and categories must be string
+// literals (or otherwise outlive the tracer). level and cycle are -1 if
+// they don't apply.
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    double begin, end;          // Seconds, from Profiler::now()
+    int thread;
+    Level level;
+    int cycle;
+};
+
+// = Tracer class interface =
+/*  Collects trace events from any number of threads. Each thread is given
+    a small number the first time it adds an event, which is its thread id
+    in the trace (numbers of finished threads are reused). Only the first
+    maxEvents events are kept, so a long run can't use up all the memory;
+    the rest are counted in dropped().
+
+    write_json writes the events as "complete" events, with times in
+    microseconds since the tracer was made, and the level and cycle of each
+    as arguments. Spans on the same thread nest by time, so kernels show up
+    inside the level visits and cycles they belong to.
+*/
+class Tracer: private boost::noncopyable {
+public:
+    Tracer(const std::size_t maxEvents=1000000);
+
+    void add(const char* name, const char* category, const double begin,
+        const double end, const Level level=-1, const int cycle=-1);
+    inline std::size_t size() const;
+    inline std::size_t dropped() const;
+    void clear();
+
+    void write_json(std::ostream& out);
+
+private:
+    const std::size_t maxEvents;
+    const double origin;
+    std::vector<TraceEvent> events;
+    std::size_t droppedEvents;
+    boost::mutex lock;
+};
+
+// = Inline methods =
+inline std::size_t Tracer::size() const {
+    return events.size();
+}
+inline std::size_t Tracer::dropped() const {
+    return droppedEvents;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: TRACER_HPP_D8LW3F6T */
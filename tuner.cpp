@@ -0,0 +1,279 @@
+/*
+    tuner.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <boost/thread/mutex.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+
+#include "profiler.hpp"
+#include "tuner.hpp"
+
+// Only one tuner writes to a cache file at a time in this process
+static boost::mutex cacheLock;
+
+// Cache entries by key (operator, grid shape, coarse operator type and CPU
+// model, separated by tabs), each holding a tuned trial
+typedef std::map<std::string, mgrid::TuningTrial> TuningCache;
+
+static void read_cache(const std::string& path, TuningCache& cache) {
+    std::ifstream file(path.c_str());
+    std::string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::string::size_type end = line.find('\t');
+        for (int field=1; field<4 && end != std::string::npos; field++)
+            end = line.find('\t', end+1);
+        if (end == std::string::npos) continue;
+        std::istringstream values(line.substr(end+1));
+        mgrid::TuningTrial trial;
+        int cycleType;
+        if (values >> cycleType >> trial.preRelax >> trial.postRelax
+            >> trial.numberOfGrids >> trial.minimumResolution
+            >> trial.tileSize >> trial.seconds >> trial.residual)
+        {
+            trial.cycleType = mgrid::CycleType(cycleType);
+            cache[line.substr(0, end)] = trial;
+        }
+    }
+}
+
+static bool write_cache(const std::string& path, const TuningCache& cache) {
+    // Write a new file and move it into place, so that a solve reading the
+    // cache never sees half of it
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary.c_str());
+        if (not(file)) return false;
+        file.precision(6);
+        file << "# Multigrid tuning cache: operator, grid, coarse operator, "
+             << "CPU model, then "
+             << "cycle type, pre and post sweeps, grids, minimum resolution, "
+             << "tile size, seconds and residual" << std::endl;
+        for (TuningCache::const_iterator entry=cache.begin();
+            entry!=cache.end(); entry++)
+        {
+            const mgrid::TuningTrial& t = entry->second;
+            file << entry->first << '\t' << int(t.cycleType) << ' '
+                 << t.preRelax << ' ' << t.postRelax << ' '
+                 << t.numberOfGrids << ' ' << t.minimumResolution << ' '
+                 << t.tileSize << ' ' << t.seconds << ' ' << t.residual
+                 << std::endl;
+        }
+        if (not(file)) return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+// Keys can't have tabs or line breaks in their fields
+static std::string key_field(std::string field) {
+    std::replace(field.begin(), field.end(), '\t', ' ');
+    std::replace(field.begin(), field.end(), '\n', ' ');
+    return field;
+}
+
+static const char* cycle_name(const mgrid::CycleType cycleType) {
+    return cycleType == mgrid::vCycle ? "V"
+        : (cycleType == mgrid::wCycle ? "W" : "3");
+}
+
+static bool same_settings(const mgrid::TuningTrial& a,
+    const mgrid::TuningTrial& b)
+{
+    return a.cycleType == b.cycleType && a.preRelax == b.preRelax
+        && a.postRelax == b.postRelax && a.numberOfGrids == b.numberOfGrids
+        && a.minimumResolution == b.minimumResolution
+        && a.tileSize == b.tileSize;
+}
+
+// = TuningSpace and TuningTrial =
+mgrid::TuningSpace::TuningSpace() {
+    cycleTypes.push_back(vCycle);
+    cycleTypes.push_back(wCycle);
+    for (unsigned long pre=1; pre<=2; pre++)
+        for (unsigned long post=1; post<=2; post++)
+            sweeps.push_back(std::make_pair(pre, post));
+    for (int depth=0; depth<=2; depth++) depthReductions.push_back(depth);
+    tileSizes.push_back(0);
+    tileSizes.push_back(64);
+    tileSizes.push_back(128);
+}
+
+mgrid::TuningTrial::TuningTrial():
+    cycleType(wCycle), preRelax(0), postRelax(0), numberOfGrids(0),
+    minimumResolution(0), tileSize(0), seconds(0), residual(0) {}
+
+void mgrid::TuningTrial::apply(Settings& settings) const {
+    settings.mgCycleType = cycleType;
+    settings.preMGRelaxIter = preRelax;
+    settings.postMGRelaxIter = postRelax;
+    settings.numberOfGrids = numberOfGrids;
+    settings.minimumResolution = minimumResolution;
+    settings.tileSize = tileSize;
+}
+
+// = AutoTuner =
+mgrid::AutoTuner::AutoTuner(Factory factory,
+    const std::string& operatorName, std::string cachePath):
+    residualFactor(1),
+    repetitions(1),
+    factory(factory),
+    operatorName(operatorName),
+    cachePath(cachePath.empty() ? default_cache_path() : cachePath)
+{}
+
+bool mgrid::AutoTuner::lookup(Settings& settings) {
+    TuningCache cache;
+    {
+        boost::mutex::scoped_lock lock(cacheLock);
+        read_cache(cachePath, cache);
+    }
+    TuningCache::const_iterator entry = cache.find(_key(settings));
+    if (entry == cache.end()) return false;
+    entry->second.apply(settings);
+    return true;
+}
+
+mgrid::Settings mgrid::AutoTuner::tune(const Settings& settings) {
+    tuningTrials.clear();
+    Settings result = settings;
+    if (lookup(result)) return result;
+
+    // Time the settings we were given, which the candidates have to match
+    TuningTrial best;
+    best.cycleType = CycleType(settings.mgCycleType);
+    best.preRelax = settings.preMGRelaxIter;
+    best.postRelax = settings.postMGRelaxIter;
+    best.numberOfGrids = settings.numberOfGrids;
+    best.minimumResolution = settings.minimumResolution;
+    best.tileSize = settings.tileSize;
+    if (not(_trial(settings, best))) {
+        Message msg(WarningMessage);
+        msg << "Couldn't solve " << operatorName << " with the given "
+            << "settings, so they haven't been tuned" << std::endl;
+        std::cout << msg.str();
+        return result;
+    }
+    tuningTrials.push_back(best);
+    const double maxResidual = residualFactor*best.residual;
+    const double baselineSeconds = best.seconds;
+
+    // Try every candidate with the same finest grid
+    const Level finest = settings.numberOfGrids - 1;
+    const boost::tuple<int, int> shape = grid_shape(settings, finest);
+    const int width = std::max(shape.get<0>(), shape.get<1>());
+    foreach(int depth, space.depthReductions) {
+        Settings candidate = settings;
+        candidate.numberOfGrids = settings.numberOfGrids - depth;
+        candidate.minimumResolution
+            = (settings.minimumResolution - 1)*(1 << depth) + 1;
+        if (candidate.numberOfGrids < 2
+            || grid_shape(candidate, finest - depth) != shape)
+            continue;
+        foreach(CycleType cycleType, space.cycleTypes)
+        for (std::size_t s=0; s<space.sweeps.size(); s++)
+        foreach(int tileSize, space.tileSizes) {
+            TuningTrial trial;
+            trial.cycleType = cycleType;
+            trial.preRelax = space.sweeps[s].first;
+            trial.postRelax = space.sweeps[s].second;
+            trial.numberOfGrids = candidate.numberOfGrids;
+            trial.minimumResolution = candidate.minimumResolution;
+            trial.tileSize = tileSize;
+            trial.apply(candidate);
+            // Tiles as wide as the grid do the same as no tiles at all
+            if (tileSize >= width) continue;
+            if (same_settings(trial, tuningTrials.front())
+                || not(_trial(candidate, trial)))
+                continue;
+            tuningTrials.push_back(trial);
+            if (trial.residual <= maxResidual && trial.seconds < best.seconds)
+                best = trial;
+        }
+    }
+
+    // Keep the winner
+    {
+        boost::mutex::scoped_lock lock(cacheLock);
+        TuningCache cache;
+        read_cache(cachePath, cache);
+        cache[_key(settings)] = best;
+        if (not(write_cache(cachePath, cache))) {
+            Message msg(WarningMessage);
+            msg << "Couldn't write the tuning cache " << cachePath
+                << std::endl;
+            std::cout << msg.str();
+        }
+    }
+    Message msg(StatusMessage);
+    msg << "Tuned " << operatorName << " over " << tuningTrials.size()
+        << " trials: " << cycle_name(best.cycleType)
+        << "(" << best.preRelax << "/" << best.postRelax << ") cycles on "
+        << best.numberOfGrids << " grids, tile size " << best.tileSize
+        << ", " << 1e3*best.seconds << " ms per solve (was "
+        << 1e3*baselineSeconds << " ms)" << std::endl;
+    std::cout << msg.str();
+    best.apply(result);
+    return result;
+}
+
+std::string mgrid::AutoTuner::cpu_model() {
+    // The model name on x86, or the processor on other Linux systems
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") != 0
+            && line.compare(0, 9, "Processor") != 0
+            && line.compare(0, 8, "Hardware") != 0)
+            continue;
+        const std::string::size_type colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        const std::string::size_type start
+            = line.find_first_not_of(' ', colon+1);
+        if (start != std::string::npos) return line.substr(start);
+    }
+    return "unknown";
+}
+
+std::string mgrid::AutoTuner::default_cache_path() {
+    if (const char* path = std::getenv("MULTIGRID_TUNING_CACHE"))
+        return path;
+    if (const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.multigrid_tuning";
+    return ".multigrid_tuning";
+}
+
+std::string mgrid::AutoTuner::_key(const Settings& settings) {
+    int nx, nz;
+    boost::tie(nx, nz) = grid_shape(settings, settings.numberOfGrids - 1);
+    std::ostringstream key;
+    key << key_field(operatorName) << '\t' << nx << 'x' << nz << '\t'
+        << (settings.coarseOperator == galerkinOperator ? "galerkin"
+            : "rediscretised") << '\t' << key_field(cpu_model());
+    return key.str();
+}
+
+bool mgrid::AutoTuner::_trial(const Settings& settings, TuningTrial& trial) {
+    // Median time of solves from fresh solvers, and the last one's residual
+    std::vector<double> times;
+    for (int n=0; n<std::max(1, repetitions); n++) {
+        try {
+            std::auto_ptr<MultigridBase> solver(factory(settings));
+            const double start = Profiler::now();
+            solver->solve();
+            times.push_back(Profiler::now() - start);
+            trial.residual = solver->solve_result().finalResidual;
+        } catch (std::exception&) {
+            return false;
+        }
+        if (not(trial.residual == trial.residual)) return false;  // NaN
+    }
+    std::sort(times.begin(), times.end());
+    trial.seconds = times[times.size()/2];
+    return true;
+}
@@ -0,0 +1,112 @@
+/*
+    tuner.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Auto-tuning of the cycle type, relaxation sweeps, depth of the grid
+    hierarchy and sweep tiling for a problem, by timing short trial solves.
+    The winners are kept in a cache file, so each problem is only tuned
+    once on each machine.
+*/
+
+#ifndef TUNER_HPP_P6GK2V9S
+#define TUNER_HPP_P6GK2V9S
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "settings.hpp"
+#include "multigrid_base.hpp"
+
+namespace mgrid {
+
+// Candidate values for each tuned setting. Depth reductions are numbers of
+// coarse grids to drop: the finest grid stays the same, and the coarsest
+// is made finer to match (if the grid shapes allow it).
+struct TuningSpace {
+    std::vector<CycleType> cycleTypes;
+    std::vector<std::pair<unsigned long, unsigned long> > sweeps; // pre/post
+    std::vector<int> depthReductions;
+    std::vector<int> tileSizes;
+
+    // Ctor etc
+    TuningSpace(); // V and W cycles, 1 or 2 sweeps each side, dropping up
+                   // to two grids, and sweeps untiled or in tiles of 64 or
+                   // 128 points (tiles as wide as the grid are skipped)
+};
+
+// The tuned settings, and how a trial solve with them went. seconds is the
+// median time of a solve from a fresh solver, and residual its final
+// residual (the RMS residual on the finest grid).
+struct TuningTrial {
+    TuningTrial();
+    CycleType cycleType;
+    unsigned long preRelax, postRelax;
+    int numberOfGrids, minimumResolution, tileSize;
+    double seconds, residual;
+
+    // Copies the tuned values into settings
+    void apply(Settings& settings) const;
+};
+
+// = AutoTuner class interface =
+/*  Tunes the settings of the solvers a factory builds (as for
+    SweepScheduler). tune looks up the problem in the cache first, by the
+    operator name given, the shape of the finest grid, the coarse operator
+    type (which isn't tuned, but changes which settings are best) and the
+    CPU model.
+    If it isn't there, every combination in space is tried: each trial
+    builds a solver with the candidate settings and times solve(). The
+    fastest candidate whose final residual is no more than residualFactor
+    times that of the settings passed in wins, so tuning never trades away
+    accuracy, and is written to the cache. The settings passed in are
+    returned (and cached) if nothing beats them.
+
+    lookup only reads the cache, for solves which shouldn't spend time
+    tuning. The cache is a text file with one line per problem; its
+    default path is $MULTIGRID_TUNING_CACHE, or ~/.multigrid_tuning.
+*/
+class AutoTuner {
+public:
+    // Builds a solver with the given settings
+    typedef boost::function<MultigridBase* (const Settings&)> Factory;
+
+    AutoTuner(Factory factory, const std::string& operatorName,
+        std::string cachePath="");
+
+    Settings tune(const Settings& settings);
+    bool lookup(Settings& settings);
+
+    // Trials from the last call of tune (empty if it used the cache)
+    inline const std::vector<TuningTrial>& trials() const;
+
+    // Search space and acceptance. Each candidate is solved repetitions
+    // times, and the median time taken.
+    TuningSpace space;
+    double residualFactor;
+    int repetitions;
+
+    static std::string cpu_model();
+    static std::string default_cache_path();
+
+private:
+    Factory factory;
+    const std::string operatorName;
+    const std::string cachePath;
+    std::vector<TuningTrial> tuningTrials;
+
+    std::string _key(const Settings& settings);
+    bool _trial(const Settings& settings, TuningTrial& trial);
+};
+
+// = Inline methods =
+inline const std::vector<TuningTrial>& AutoTuner::trials() const {
+    return tuningTrials;
+}
+
+} // end namespace mgrid
+
+#endif /* end of include guard: TUNER_HPP_P6GK2V9S */
@@ -18,6 +18,7 @@ typedef long unsigned int iter_t;
 
 // Flags and boundary condition specifications   
 enum CycleType {vCycle = 1, wCycle = 2, threeCycle = 3};
+enum CoarseOperatorType {rediscretisedOperator, galerkinOperator};
 
 // Deriv structs
 typedef struct {
@@ -5,7 +5,6 @@
     Driver routine for multigrid solver
 */
 
-//#include <dispatch/dispatch.h> // GCD Queue library
 #include <multigrid/multigrid.hpp>
 #include "mosolov.hpp"
 #include "mosolov_settings.hpp"
@@ -30,69 +29,139 @@ void calculate_flow(ABTuple aspectBinghamPair) {
     std::auto_ptr<Mosolov> problem(new Mosolov(settings));
     problem->solve();
     problem->write(3); // Write out velocity, strain rate and residual
+    if (Profiler::enabled()) problem->write_profile();
+    if (problem->profile().tracer()) problem->write_trace();
 }
 
-// void calculate_lists() {
-//     // = Calculation settings =
-//     // Specify aspect ratios to iterate over
-//     static const double aspectRatios[] =
-//         {2, 2.5, 3, 3.5, 4, 4.5, 5, 5.5, 6, 6.5, 7, 7.5, 8, 8.5, 9, 9.5, 10,
-//          10.5, 11, 11.5, 12, 12.5, 13, 13.5, 14, 14.5, 15, 15.5, 16, 16.5, 17, 17.5,
-//          18, 18.5, 19, 19.5, 20, 20.5, 21, 21.5, 22, 22.5, 23, 23.5, 24, 24.5, 25};
+// = Parameter sweeps =
+// Builds a solver for an (aspect ratio, Bingham number) pair
+MultigridBase* build_flow(const SweepParameters& aspectBingham) {
+    MosolovSettings settings;
+    settings.multigridSettings.aspectRatio = aspectBingham[0];
+    settings.binghamNumber = aspectBingham[1];
+    return new Mosolov(settings);
+}
+
+// Writes out velocity, strain rate and residual for a solved problem
+void write_flow(MultigridBase& problem, const SweepParameters&) {
+    problem.write(3);
+    if (Profiler::enabled()) problem.write_profile();
+    if (problem.profile().tracer()) problem.write_trace();
+}
+
+// Adds velocity, strain rate and residual for a solved problem to a sweep 
+// dataset, at its (aspect ratio, Bingham fraction) position
+void add_flow(SweepDataset& dataset, MultigridBase& problem, 
+    const SweepParameters& aspectBingham) 
+{
+    SweepParameters position;
+    position.push_back(aspectBingham[0]);
+    position.push_back(aspectBingham[1]/critical_bingham(aspectBingham[0]));
+    dataset.add(dataset.nearest_index(position), problem.snapshot(3));
+}
+
+// Solve for a list of aspect-Bingham pairs on all the available cores
+void calculate_sweep(const vector<ABTuple>& aspectBinghamPairs,
+    SweepScheduler::OutputStage output=write_flow) 
+{
+    SweepScheduler scheduler(build_flow, output);
+    foreach(ABTuple abPair, aspectBinghamPairs) {
+        // Estimate the cost from the finest grid size, and the number of
+        // Lagrange iterations, which grows as B approaches B*
+        MosolovSettings settings;
+        settings.multigridSettings.aspectRatio = abPair(0);
+        const Settings& s = settings.multigridSettings;
+        int nx, nz;
+        boost::tie(nx, nz) = grid_shape(s, s.numberOfGrids-1);
+        const double binghamFrac = abPair(1)/critical_bingham(abPair(0));
+        const double cost = double(nx)*nz/(1 - std::min(binghamFrac, 0.99));
+
+        // Memory is two stacks and about a stack's worth of scratch arrays,
+        // plus two vector arrays and a pair of scratch arrays on the finest 
+        // grid for the Lagrange multiplier iteration (see peak_memory)
+        const size_t memory = 3*stack_memory(s) + 5*sizeof(double)*nx*nz;
+
+        SweepParameters parameters;
+        parameters.push_back(abPair(0));
+        parameters.push_back(abPair(1));
+        scheduler.add_job(parameters, cost, memory);
+    }
+    scheduler.run();
+}
+
+void calculate_lists() {
+    // = Calculation settings =
+    // Specify aspect ratios to iterate over
+    static const int nAspect = 47;
+    static const double aspectRatios[nAspect] =
+        {2, 2.5, 3, 3.5, 4, 4.5, 5, 5.5, 6, 6.5, 7, 7.5, 8, 8.5, 9, 9.5, 10,
+         10.5, 11, 11.5, 12, 12.5, 13, 13.5, 14, 14.5, 15, 15.5, 16, 16.5, 17, 17.5,
+         18, 18.5, 19, 19.5, 20, 20.5, 21, 21.5, 22, 22.5, 23, 23.5, 24, 24.5, 25};
      
-//     // Specify number of Bingham gradations per aspect ratio. The calculation
-//     // will not include B=0 or B=B* since these are known analytically.
-//     static const int nBingham = 32;
-//     static const double binghamFrac[nBingham] =
-//         {0.01, 0.02, 0.03, 0.04, 0.05, 0.075, 0.1, 0.125, 0.15, 0.175, 0.2, 
-//          0.225, 0.25, 0.275, 0.3, 0.325, 0.35, 0.375, 0.4, 0.425, 0.45, 0.475, 
-//          0.5, 0.55, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95};
+    // Specify number of Bingham gradations per aspect ratio. The calculation
+    // will not include B=0 or B=B* since these are known analytically.
+    static const int nBingham = 32;
+    static const double binghamFracs[nBingham] =
+        {0.01, 0.02, 0.03, 0.04, 0.05, 0.075, 0.1, 0.125, 0.15, 0.175, 0.2, 
+         0.225, 0.25, 0.275, 0.3, 0.325, 0.35, 0.375, 0.4, 0.425, 0.45, 0.475, 
+         0.5, 0.55, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95};
     
-//     // = Parallel main loop =
-//     // Get the default concurrent job queue for the application, and define
-//     // a group of jobs which can be executed
-//     dispatch_queue_t queue \
-//         = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-//     dispatch_group_t group = dispatch_group_create();
+    // Generate a list of aspect-bingham pairs
+    vector<ABTuple> aspectBinghamPairs;
+    foreach(double aspect, aspectRatios)
+        foreach(double binghamFrac, binghamFracs)
+            aspectBinghamPairs.push_back(
+                ABTuple(aspect, binghamFrac*critical_bingham(aspect)));
     
-//     // Generate a list of aspect-bingham pairs
-//     vector<ABTuple> aspectBinghamPairs;
-//     static const double binghamFracs[] = {0.8, 0.85, 0.9, 0.95};
-//     foreach(double binghamFrac, binghamFracs) {
-//         ABTuple abPair(18, binghamFrac*critical_bingham(18));
-//         dispatch_group_async(group, queue, ^{calculate_flow(abPair);});
-//     }
-    
-//     // Wait for threads to finish, then clean up
-//     dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
-//     dispatch_release(group);
-// }
+    // Solve them all, writing the results into a single compressed dataset 
+    // indexed by aspect ratio and Bingham fraction, which has room for the 
+    // largest grid
+    MosolovSettings settings;
+    Settings& s = settings.multigridSettings;
+    int nxMax = 0, nzMax = 0;
+    foreach(double aspect, aspectRatios) {
+        s.aspectRatio = aspect;
+        int nx, nz;
+        boost::tie(nx, nz) = grid_shape(s, s.numberOfGrids-1);
+        nxMax = std::max(nx, nxMax);
+        nzMax = std::max(nz, nzMax);
+    }
+    vector<SweepAxis> axes;
+    axes.push_back(SweepAxis("aspect_ratio", 
+        vector<double>(aspectRatios, aspectRatios + nAspect)));
+    axes.push_back(SweepAxis("bingham_fraction", 
+        vector<double>(binghamFracs, binghamFracs + nBingham)));
+    vector<string> fields, scalars;
+    fields.push_back("velocity");
+    fields.push_back("strain_rate");
+    fields.push_back("log_residual");
+    scalars.push_back("bingham_number");
+    scalars.push_back("total_flux");
+    scalars.push_back("lagrange_iterations");
+    scalars.push_back("residual");
+    s.output.netcdf4 = true;
+    s.output.deflateLevel = 4;
+    SweepDataset dataset("mosolov_sweep.nc", axes, nxMax, nzMax, fields, 
+        scalars, s.output);
+    calculate_sweep(aspectBinghamPairs, 
+        boost::bind(add_flow, boost::ref(dataset), _1, _2));
+}
 
-// void calculate_spec_pairs() {
-//     vector<ABTuple> aspectBinghamPairs;
-//     aspectBinghamPairs.push_back(ABTuple(5.9407, 0.2533));
-//     aspectBinghamPairs.push_back(ABTuple(5.9407, 0.3149));
-//     aspectBinghamPairs.push_back(ABTuple(4.5970, 0.0));
-//     aspectBinghamPairs.push_back(ABTuple(8.1437, 0.2533));
-//     aspectBinghamPairs.push_back(ABTuple(8.1437, 0.3149));
-//     aspectBinghamPairs.push_back(ABTuple(6.7490, 0.0));
-//     aspectBinghamPairs.push_back(ABTuple(7.0422, 0.2841));
-//     aspectBinghamPairs.push_back(ABTuple(5.673, 0.0));
-    
-//     // Get the default concurrent job queue for the application, and define
-//     // a group of jobs which can be executed
-//     dispatch_queue_t queue \
-//         = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-//     dispatch_group_t group = dispatch_group_create();
-    
-//     // Main loop
-//     foreach(ABTuple abPair, aspectBinghamPairs)
-//         dispatch_group_async(group, queue, ^{calculate_flow(abPair);});
-//     dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
-//     dispatch_release(group);
-// }
+void calculate_spec_pairs() {
+    vector<ABTuple> aspectBinghamPairs;
+    aspectBinghamPairs.push_back(ABTuple(5.9407, 0.2533));
+    aspectBinghamPairs.push_back(ABTuple(5.9407, 0.3149));
+    aspectBinghamPairs.push_back(ABTuple(4.5970, 0.0));
+    aspectBinghamPairs.push_back(ABTuple(8.1437, 0.2533));
+    aspectBinghamPairs.push_back(ABTuple(8.1437, 0.3149));
+    aspectBinghamPairs.push_back(ABTuple(6.7490, 0.0));
+    aspectBinghamPairs.push_back(ABTuple(7.0422, 0.2841));
+    aspectBinghamPairs.push_back(ABTuple(5.673, 0.0));
+    calculate_sweep(aspectBinghamPairs);
+}
 
 int main() {
+    // calculate_lists();
     // calculate_spec_pairs();
     calculate_flow(ABTuple(2, 0.24));
 }
\ No newline at end of file
@@ -9,17 +9,15 @@ using namespace mgrid;
 
 Mosolov::Mosolov(const MosolovSettings& settings):
     LinearMultigrid::LinearMultigrid(settings.multigridSettings),
-    temp(settings.multigridSettings.aspectRatio, nxfine, nzfine), 
     multiplier(settings.multigridSettings.aspectRatio, nxfine, nzfine),
     strainRate(settings.multigridSettings.aspectRatio, nxfine, nzfine),
-    determinant(settings.multigridSettings.aspectRatio, nxfine, nzfine),
-    tempVec(settings.multigridSettings.aspectRatio, nxfine, nzfine),
-    solutionGradient(settings.multigridSettings.aspectRatio, nxfine, nzfine),  
     aspectRatio(settings.multigridSettings.aspectRatio),
     binghamNumber(settings.binghamNumber),
     maxLagrangeIteration(settings.maxLagrangeIteration),
     lagrangeTolerance(settings.lagrangeTolerance),
-    alpha(settings.augmentingParameter)
+    alpha(settings.augmentingParameter),
+    lagrangeIterations(0),
+    lagrangeResidual(0)
 {
     // Set boundary conditions for velocity array 
     solution.boundaryConditions.set(leftBoundary,   zeroNeumannCondition);
@@ -40,99 +38,129 @@ Mosolov::Mosolov(const MosolovSettings& settings):
 }    
 Mosolov::~Mosolov() { /* pass */ }
 
-void Mosolov::write(int numOfVariables, std::string fileRoot) {
-    // Get generated file name from settings instance
-    fileRoot.append(filename()).append(".nc");      
+SolutionOutput Mosolov::_output(int numOfVariables, std::string fileRoot) {
+    // Velocity and strain rate, with the aspect ratio, Bingham number, total
+    // flux and the convergence of all the multigrid solves in the last
+    // solve as attributes
+    SolutionOutput output = LinearMultigrid::_output(numOfVariables, fileRoot);
+    output.gradientName = "strain_rate";
+    output.attributes.clear();
+    output.attributes.push_back(std::make_pair("bingham_number", binghamNumber));
+    output.attributes.push_back(std::make_pair("aspect_ratio", aspectRatio));
+    output.attributes.push_back(std::make_pair("total_flux", 
+        solution[solution.finestLevel].calculate_flux()));
+    output.attributes.push_back(std::make_pair("lagrange_iterations", 
+        double(lagrangeIterations)));
+    output.attributes.push_back(std::make_pair("residual", lagrangeResidual));
+    if (outputSettings.solveStatistics) 
+        total_solve_result().add_attributes(output.attributes);
     
-    // Generate new netCDF file using given fileString - replace the file if
-    // it already exists. File will sync and close automatically when it 
-    // goes out of scope.
-    std::auto_ptr<NcFile> file(new NcFile(fileRoot.c_str(), NcFile::Replace));
-    
-    // Check to see that file has been generated
-    if (file->is_valid()) {           
-        // Define and add attributes which specify aspect ratio, Bingham 
-        // number and total flux 
-        file->add_att("bingham_number", binghamNumber);
-        file->add_att("aspect_ratio", aspectRatio);
-        file->add_att("total_flux", solution[solution.finestLevel].calculate_flux());
-        
-        // Specify axis values   
-        const double hx = solution[solution.finestLevel].spacing(0);
-        const double hz = solution[solution.finestLevel].spacing(1);  
-        double XxArray[nxfine];
-        double ZzArray[nzfine];
-        for (int i=0; i<nxfine; i++) XxArray[i] = i*hx;
-        for (int j=0; j<nzfine; j++) ZzArray[j] = j*hz;
-        
-        // Define and add dimentions and variables
-        NcDim* Xx = file->add_dim("x", nxfine);
-        NcDim* Zz = file->add_dim("z", nzfine);  
-        NcVar* XxVals = file->add_var("x", ncDouble, Xx);   
-        NcVar* ZzVals = file->add_var("z", ncDouble, Zz);
-        NcVar* variable = file->add_var("velocity", ncDouble, Xx, Zz);
-        
-        // Add axis values and velocity components 
-        XxVals->put(XxArray, nxfine);
-        ZzVals->put(ZzArray, nzfine);
-        variable->put(&solution[solution.finestLevel](0,0), nxfine, nzfine);   
-        
-        // Calculate and add gradient components
-        if (numOfVariables > 1) {    
-            NcVar* modGrad = file->add_var("strain_rate", ncDouble, Xx, Zz); 
-            solution[solution.finestLevel].gradient_magnitude(temp);     
-            modGrad->put(&temp(0,0), nxfine, nzfine); 
-        }
-        
-        // Calculate and add residual
-        if (numOfVariables > 2) {    
-            NcVar* resid = file->add_var("log_residual", ncDouble, Xx, Zz);
-            evaluate_residual(finestLevel, temp); 
-            temp = log10(temp);       
-            resid->put(&temp(0,0), nxfine, nzfine);   
-        }   
-        
-        // Let std::cout know that the file has been written
-        std::ostringstream msg;
-        msg << " -- Problem (" << aspectRatio << ", " << binghamNumber 
-            << ") solution written to " << fileRoot << std::endl;
-        std::cout << msg.str(); std::cout.flush(); 
-    }
+    // Let std::cout know when the file has been written
+    std::ostringstream msg;
+    msg << " -- Problem (" << aspectRatio << ", " << binghamNumber 
+        << ") solution written to " << output.path << std::endl;
+    output.message = msg.str();
+    return output;
+}
+
+std::size_t Mosolov::peak_memory() {
+    return LinearMultigrid::peak_memory() 
+        + (multiplier.size() + strainRate.size())*sizeof(double);
+}
+
+void Mosolov::checkpoint(CheckpointWriter& checkpoint) {
+    LinearMultigrid::checkpoint(checkpoint);
+    checkpoint.add("multiplier", multiplier.data(), 
+        multiplier.size()*sizeof(double));
+    checkpoint.add("strain_rate", strainRate.data(), 
+        strainRate.size()*sizeof(double));
+    std::vector<double> state;
+    state.push_back(lagrangeIterations);
+    state.push_back(lagrangeResidual);
+    state.push_back(binghamNumber);
+    checkpoint.add("lagrange_state", state);
+}
+void Mosolov::restore(CheckpointReader& checkpoint) {
+    // Check the checkpoint is for this problem before changing anything
+    std::vector<double> state;
+    checkpoint.read("lagrange_state", state);
+    if (state.size() != 3) 
+        throw CheckpointException("the Lagrange state is the wrong size");
+    if (state[2] != binghamNumber)
+        throw CheckpointException(
+            "the checkpoint is for a different Bingham number");
+    LinearMultigrid::restore(checkpoint);
+    checkpoint.read("multiplier", multiplier.data(), 
+        multiplier.size()*sizeof(double));
+    checkpoint.read("strain_rate", strainRate.data(), 
+        strainRate.size()*sizeof(double));
+    lagrangeIterations = (unsigned int)(state[0]);
+    lagrangeResidual = state[1];
+}
+
+// Solves for the velocity, adding the solve to the statistics of the whole
+// solve (its final residual is filled in by total_solve_result)
+void Mosolov::_inner_solve() {
+    multigrid();
+    totalResult.add(solveResult);
 }
 
 void Mosolov::solve() {
-    // Solve initial problem, then loop through augmented Lagrangian iteration
-    multigrid();    
-    for(unsigned int iter = 0; iter < maxLagrangeIteration; ++iter) {
-        // Calculate new strain rate  
-        solution[finestLevel].gradient(solutionGradient);
-        determinant = alpha*solutionGradient + multiplier;
+    // Solve initial problem (unless we're carrying on from a checkpoint), 
+    // then loop through augmented Lagrangian iteration
+    FDArray& velocity = solution[finestLevel];
+    unsigned int firstIteration = 0;
+    if (restoredFromCheckpoint) {
+        firstIteration = lagrangeIterations;
+        restoredFromCheckpoint = false;
+    } else {
+        lagrangeIterations = 0;
+        lagrangeResidual = 0;
+        totalResult.clear();
+        _inner_solve();
+    }
+    for(unsigned int iter = firstIteration; iter < maxLagrangeIteration; 
+        ++iter) 
+    {
+        // Calculate new strain rate, which holds the velocity gradient to 
+        // start with
+        velocity.dx(strainRate.first);
+        velocity.dz(strainRate.second);
         ARRAY_LOOP(strainRate.first) {           
-            const double d1sq = determinant.first(i, j)*determinant.first(i, j);
-            const double d2sq = determinant.second(i, j)*determinant.second(i, j);
-            const double detMagnitude = sqrt(d1sq + d2sq);
+            const double d1 = alpha*strainRate.first(i, j) 
+                + multiplier.first(i, j);
+            const double d2 = alpha*strainRate.second(i, j) 
+                + multiplier.second(i, j);
+            const double detMagnitude = sqrt(d1*d1 + d2*d2);
             if (detMagnitude*detMagnitude <= binghamNumber*binghamNumber) {
                 strainRate.first(i, j) = 0; 
                 strainRate.second(i, j) = 0;
             } else {                       
                 strainRate.first(i, j) = (1-binghamNumber/detMagnitude)
-                    *determinant.first(i, j)/alpha;
+                    *d1/alpha;
                 strainRate.second(i, j) = (1-binghamNumber/detMagnitude)
-                    *determinant.second(i, j)/alpha;
+                    *d2/alpha;
             }   
         } 
         
-        // Construct new right hand side
-        tempVec.first = alpha*strainRate.first - multiplier.first;
-        tempVec.second = alpha*strainRate.second - multiplier.second;
-        tempVec.divergence(temp);
-        source[finestLevel] = (temp - 1.0)/(1+alpha);
+        // Construct new right hand side from the divergence of 
+        // alpha*strainRate - multiplier
+        {
+            ScratchArray fluxX(*workspace, velocity);
+            ScratchArray fluxZ(*workspace, velocity);
+            fluxX = alpha*strainRate.first - multiplier.first;
+            fluxZ = alpha*strainRate.second - multiplier.second;
+            divergence(fluxX, fluxZ, source[finestLevel]);
+            source[finestLevel] = (source[finestLevel] - 1.0)/(1+alpha);
+        }
         
         // Calculate new velocity
-        multigrid();        
+        _inner_solve();
         
         // Check for convergence (i.e. when $\dot\gamma = \nabla u$)
         const double resid = _normed_residual();   
+        lagrangeIterations = iter + 1;
+        lagrangeResidual = resid;
         if (resid < lagrangeTolerance) {   
             std::ostringstream msg;
             msg << " -- Problem (" << aspectRatio << ", " << binghamNumber 
@@ -143,17 +171,19 @@ void Mosolov::solve() {
         }
         
         // Calculate new multiplier                  
-        solution[solution.finestLevel].gradient(solutionGradient);
-        multiplier.first += 
-            alpha*(solutionGradient.first - strainRate.first);
-        multiplier.second +=
-            alpha*(solutionGradient.second - strainRate.second);
+        ScratchArray gradX(*workspace, velocity), gradZ(*workspace, velocity);
+        velocity.dx(gradX);
+        velocity.dz(gradZ);
+        multiplier.first += alpha*(gradX - strainRate.first);
+        multiplier.second += alpha*(gradZ - strainRate.second);
+        _checkpoint_if_due();
     } 
     
     // If we're here, then the convergence has failed  
+    lagrangeResidual = _normed_residual();
     std::ostringstream msg;
     msg << " -- Problem (" << aspectRatio << ", " << binghamNumber 
         << ") failed to converge after " << maxLagrangeIteration
-        << " iterations. Residual = " << _normed_residual() << std::endl;
+        << " iterations. Residual = " << lagrangeResidual << std::endl;
     std::cout << msg.str(); std::cout.flush();
 }  
\ No newline at end of file
@@ -27,18 +27,37 @@ public:
     
     // Filename generator
     virtual inline std::string filename(std::string root="");
-    virtual void write(int numOfVariables=1, std::string root="");
+    virtual std::size_t peak_memory();
     
-    // Data arrays  
-    mgrid::FDArray temp;
-    mgrid::FDVecArray multiplier, strainRate, determinant, tempVec, solutionGradient;
+    // Work units, cycles and coarse iterations of all the multigrid solves
+    // in the last solve, added up (solve_result only has the last of them).
+    // After carrying on from a checkpoint, this only counts the solves
+    // since.
+    inline const mgrid::SolveResult& total_solve_result();
+
+    // Checkpoints also hold the multiplier, strain rate and Lagrange 
+    // iteration count, so solve can carry on from the next iteration, and
+    // the Bingham number, so restore can reject another problem's
+    virtual void checkpoint(mgrid::CheckpointWriter& checkpoint);
+    virtual void restore(mgrid::CheckpointReader& checkpoint);
+    
+    // Data arrays (scratch arrays come from the workspace)
+    mgrid::FDVecArray multiplier, strainRate;
     
 protected:  
     const double aspectRatio, binghamNumber, alpha;  
     const unsigned int maxLagrangeIteration; 
     const double lagrangeTolerance;    
+    unsigned int lagrangeIterations;    // Iterations taken by the last solve
+    double lagrangeResidual;            // and its final residual
+    mgrid::SolveResult totalResult;     // and its multigrid solves
+
+    void _inner_solve();
     
     inline double _normed_residual();    
+    virtual mgrid::SolutionOutput _output(int numOfVariables, 
+        std::string root);
+    virtual std::string solution_name() { return "velocity"; }
 };    
 
 // = Inline functions =  
@@ -66,17 +85,31 @@ inline std::string Mosolov::filename(std::string root) {
     return name.str();
 }
 
+// Statistics of the whole solve, with the final residual of the last
+// multigrid solve (which is only worked out when it's asked for)
+inline const mgrid::SolveResult& Mosolov::total_solve_result() {
+    totalResult.finalResidual = solve_result().finalResidual;
+    return totalResult;
+}
+
 // Function to check convergence, returns normed residual
 inline double Mosolov::_normed_residual() {
-    // Calculate norm of velocity gradient
-    solution[solution.finestLevel].gradient(solutionGradient);   
-    temp = dot_product(solutionGradient, solutionGradient);
-    const double velGradientMagnitude = temp.norm();   
-    
-    // Calculate norm of residual
-    tempVec = solutionGradient - strainRate;
-    temp = dot_product(tempVec, tempVec);  
-    const double residualNorm = temp.norm();
+    // Norms of |grad u|^2 and of |grad u - strain rate|^2, summed directly
+    // from the gradient rather than from temporary arrays
+    mgrid::FDArray& velocity = solution[finestLevel];
+    mgrid::ScratchArray gradX(*workspace, velocity);
+    mgrid::ScratchArray gradZ(*workspace, velocity);
+    velocity.dx(gradX);
+    velocity.dz(gradZ);
+    const double velGradientMagnitude = sqrt(mgrid::blocked_sum(
+        mgrid::SquaredTerm<mgrid::VectorSquareTerm>(
+            mgrid::VectorSquareTerm(gradX, gradZ)), 
+        velocity.rows(), velocity.columns()));
+    const double residualNorm = sqrt(mgrid::blocked_sum(
+        mgrid::SquaredTerm<mgrid::VectorDifferenceSquareTerm>(
+            mgrid::VectorDifferenceSquareTerm(gradX, gradZ, 
+                strainRate.first, strainRate.second)),
+        velocity.rows(), velocity.columns()));
     return residualNorm/velGradientMagnitude;
 }
 
@@ -0,0 +1,55 @@
+/*
+    workspace.cpp (Multigrid)
+    Jess Robertson, 2026-10-19
+*/
+
+#include "workspace.hpp"
+
+// Borrow and return arrays
+mgrid::FDArray mgrid::Workspace::acquire(const double aspectRatio,
+    const int nx, const int nz)
+{
+    boost::mutex::scoped_lock guard(lock);
+    const std::size_t bytes = std::size_t(nx)*nz*sizeof(double);
+    inUse += bytes;
+    peakInUse = std::max(peakInUse, inUse);
+
+    // Reuse a free array of the right shape if there is one
+    std::multimap<Shape, FDArray>::iterator found
+        = freeArrays.find(boost::make_tuple(aspectRatio, nx, nz));
+    if (found != freeArrays.end()) {
+        FDArray result = found->second;
+        freeArrays.erase(found);
+        return result;
+    }
+    allocated += bytes;
+    return FDArray(aspectRatio, nx, nz);
+}
+void mgrid::Workspace::release(FDArray array) {
+    boost::mutex::scoped_lock guard(lock);
+    inUse -= std::size_t(array.rows())*array.columns()*sizeof(double);
+    freeArrays.insert(std::make_pair(
+        boost::make_tuple(array.aspect_ratio(), array.rows(),
+            array.columns()), array));
+}
+
+// Memory use
+std::size_t mgrid::Workspace::memory() {
+    boost::mutex::scoped_lock guard(lock);
+    return allocated;
+}
+std::size_t mgrid::Workspace::peak_memory() {
+    boost::mutex::scoped_lock guard(lock);
+    return peakInUse;
+}
+
+// = ScratchArray =
+mgrid::ScratchArray::ScratchArray(Workspace& workspace, FDArray& like):
+    workspace(workspace)
+{
+    reference(workspace.acquire(like.aspect_ratio(), like.rows(),
+        like.columns()));
+}
+mgrid::ScratchArray::~ScratchArray() {
+    workspace.release(*this);
+}
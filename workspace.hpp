@@ -0,0 +1,77 @@
+/*
+    workspace.hpp (Multigrid)
+    Jess Robertson, 2026-10-19
+
+    Pool of scratch arrays, which solvers borrow for as long as they need
+    them instead of keeping whole stacks of temporary storage.
+*/
+
+#ifndef WORKSPACE_HPP_8DJ3T6WA
+#define WORKSPACE_HPP_8DJ3T6WA
+
+#include <map>
+#include <boost/utility.hpp>
+#include <boost/thread.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+
+#include "types.hpp"
+#include "multigrid_exceptions.hpp"
+#include "fdarray.hpp"
+
+namespace mgrid {
+
+// = Workspace class interface =
+/*  Arrays are handed out by acquire and given back by release, and are kept
+    for reuse by later requests for the same shape rather than freed, so a
+    workspace only grows to the most scratch storage needed at once for
+    each shape. The contents of an acquired array are whatever was left in
+    it. A workspace can be shared between solvers (e.g. solvers which run
+    one after another on the same thread), and is safe to use from several
+    threads.
+
+    Use ScratchArray rather than calling acquire and release directly.
+*/
+class Workspace: private boost::noncopyable {
+public:
+    Workspace(): allocated(0), inUse(0), peakInUse(0) {};
+    virtual ~Workspace() {};
+
+    // Borrow and return arrays
+    FDArray acquire(const double aspectRatio, const int nx, const int nz);
+    void release(FDArray array);
+
+    // Memory held by the pool in bytes, and the most in use at once
+    std::size_t memory();
+    std::size_t peak_memory();
+
+private:
+    typedef boost::tuple<double, int, int> Shape;
+    std::multimap<Shape, FDArray> freeArrays;
+    boost::mutex lock;
+    std::size_t allocated, inUse, peakInUse;
+};
+
+// = ScratchArray class interface =
+/*  An FDArray borrowed from a Workspace, with the same shape as the given
+    array, which is given back when it goes out of scope.
+*/
+class ScratchArray: public FDArray, private boost::noncopyable {
+public:
+    ScratchArray(Workspace& workspace, FDArray& like);
+    virtual ~ScratchArray();
+
+    // Operators from FDArray
+    using FDArray::operator=;
+    using FDArray::operator+=;
+    using FDArray::operator-=;
+    using FDArray::operator*=;
+    using FDArray::operator/=;
+
+private:
+    Workspace& workspace;
+};
+
+} // end namespace mgrid
+
+#endif /* end of include guard: WORKSPACE_HPP_8DJ3T6WA */